@@ -0,0 +1,15 @@
+# generate a large input from example programs and benchmark lexer
+# usage: bench-lex.sh [size in MB] [passes], run build.sh first
+DIR=$(pwd)
+SIZE=$((${1:-64} * 1024 * 1024))
+PASSES=${2:-10}
+OUT=$DIR/bench-lex.clam
+
+cat ../../example/*/main.clam > $OUT
+while [ $(wc -c < $OUT) -lt $SIZE ]
+do
+	cat $OUT $OUT > $OUT.tmp
+	mv $OUT.tmp $OUT
+done
+
+$DIR/clamc --bench-lex $PASSES $OUT
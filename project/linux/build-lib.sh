@@ -0,0 +1,42 @@
+# build static library libclam.a from all sources except main.c, api is in clam.h
+DIR=$(pwd)
+cd ../../src/clamc
+OBJ=$(mktemp -d)
+gcc -g -c \
+	analyzer.c \
+	ast.c \
+	executor.c \
+	generator.c \
+	lexer.c \
+	message.c \
+	module.c \
+	parser.c \
+	source.c \
+	stack.c \
+	strings.c \
+	token.c \
+	type.c \
+	vector.c \
+	printer.c \
+	bytecode.c \
+	compiler.c \
+	vm.c \
+	map.c \
+	arena.c \
+	timer.c \
+	bench.c \
+	constant.c \
+	x64.c \
+	jit.c \
+	rope.c \
+	thread.c \
+	cache.c \
+	serializer.c \
+	flat.c \
+	batch.c \
+	stats.c \
+	profile.c \
+	clam.c \
+	&& mv *.o $OBJ \
+	&& ar rcs $DIR/libclam.a $OBJ/*.o
+rm -rf $OBJ
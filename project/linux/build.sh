@@ -16,4 +16,24 @@ gcc -g -L. -o $DIR/clamc \
 	type.c \
 	vector.c \
 	printer.c \
-	main.c
+	bytecode.c \
+	compiler.c \
+	vm.c \
+	map.c \
+	arena.c \
+	timer.c \
+	bench.c \
+	constant.c \
+	x64.c \
+	jit.c \
+	rope.c \
+	thread.c \
+	cache.c \
+	serializer.c \
+	flat.c \
+	clam.c \
+	batch.c \
+	stats.c \
+	profile.c \
+	main.c \
+	-lpthread
@@ -3,12 +3,15 @@
 
 #include "analyzer.h"
 #include "message.h"
+#include "constant.h"
 
 struct Variant
 {
 	Type type;
 	String name;
 	int level;
+	int slot;     //frame slot, or global index
+	bool global;
 	//TODO; check variant init or not
 };
 typedef struct Variant Variant;
@@ -35,13 +38,17 @@ static bool _Analyzer_checkTypeConvert(Analyzer* anly, Type left, Type right);
 static Type _Analyzer_checkTypeOperate(Analyzer* anly, ExprType op, Type* t1, Type* t2, Type* t3);
 static bool _Analyzer_checkLvalue(Analyzer* anly, Expression* expr);
 static bool _Analyzer_checkZero(Analyzer* anly, Expression* expr);
+static bool _Analyzer_checkShift(Analyzer* anly, Expression* expr);
 static Variant* _Analyzer_findVariant(Analyzer* anly, String name);
-static Declaration* _Analyzer_findFunction(Analyzer* anly, String name);
+static int _Analyzer_allocSlot(Analyzer* anly);
 
 void Analyzer_init(Analyzer* anly)
 {
 	Stack_init(&anly->stack, sizeof(Variant));
 	anly->level = 0;
+	anly->slot = 0;
+	anly->frameSize = 0;
+	anly->globalCount = 0;
 }
 
 void Analyzer_destroy(Analyzer* anly)
@@ -66,6 +73,8 @@ void Analyzer_analyze(Analyzer* anly, Module* module)
 		Declaration* decl = (Declaration*)Vector_get(&module->functions, i);
 		_Analyzer_function(anly, decl);
 	}
+
+	FlatCode_build(&module->flat, module);
 }
 
 void _Analyzer_variant(Analyzer* anly, Declaration* decl)
@@ -95,6 +104,11 @@ void _Analyzer_variant(Analyzer* anly, Declaration* decl)
 			if (!_Analyzer_checkTypeConvert(anly, variant.type, rtype))
 				error(&decl->variant.initExpr->location, "rvalue expression type cannot convert to lvalue type");
 		}
+
+		//slot is allocated after init expression, variant not visible in it
+		variant.global = anly->level == 0;
+		variant.slot = variant.global ? anly->globalCount++ : _Analyzer_allocSlot(anly);
+		decl->variant.slot = variant.slot;
 		break;
 
 	default:
@@ -108,6 +122,8 @@ void _Analyzer_function(Analyzer* anly, Declaration* decl)
 {
 	anly->level++;
 	int lastSize = anly->stack.size;
+	anly->slot = 0;
+	anly->frameSize = 0;
 
 	FuncDecl* func = &decl->function;
 	String main = String_literal("main");
@@ -118,6 +134,9 @@ void _Analyzer_function(Analyzer* anly, Declaration* decl)
 
 		if (decl->function.resType.id != TYPE_INT)
 			error(&decl->location, "function 'main' must return int");
+
+		if (func->parameters.size)
+			error(&decl->location, "function 'main' must have no parameters");
 	}
 
 	for (int i = 0; i < func->parameters.size; ++i)
@@ -127,6 +146,8 @@ void _Analyzer_function(Analyzer* anly, Declaration* decl)
 		v.type = param->type;  //TODO: check type realy existed.
 		v.name = param->name;
 		v.level = anly->level;
+		v.slot = _Analyzer_allocSlot(anly);  //parameter i is slot i
+		v.global = false;
 		Stack_push(&anly->stack, &v);
 	}
 
@@ -141,6 +162,8 @@ void _Analyzer_function(Analyzer* anly, Declaration* decl)
 	if (!hasReturn && func->resType.id != TYPE_VOID)  //check has or hasn't return statement
 		error(&decl->location, "function return type not 'void', missing return statement");
 
+	func->frameSize = anly->frameSize;
+
 	Vector_resize(&anly->stack, lastSize);
 	anly->level--;
 }
@@ -277,9 +300,15 @@ void _Analyzer_assignStatement(Analyzer* anly, Statement* stat)
 
 	if (stat->type == STATEMENT_TYPE_DIV_ASSIGN || stat->type == STATEMENT_TYPE_MOD_ASSIGN)
 	{
-		if (_Analyzer_checkZero(anly, stat->assign.rightExpr))  //TODO: compile time eval expression value
+		if (_Analyzer_checkZero(anly, stat->assign.rightExpr))
 			error(&stat->assign.rightExpr->location, "division by zero");
 	}
+
+	if (stat->type == STATEMENT_TYPE_LSHIFT_ASSIGN || stat->type == STATEMENT_TYPE_RSHIFT_ASSIGN)
+	{
+		if (!_Analyzer_checkShift(anly, stat->assign.rightExpr))
+			error(&stat->assign.rightExpr->location, "shift count out of range");
+	}
 }
 
 void _Analyzer_incDecStatement(Analyzer* anly, Statement* stat)
@@ -303,6 +332,7 @@ bool _Analyzer_compoundStatement(Analyzer* anly, Declaration* decl, Statement* s
 {
 	anly->level++;
 	int lastSize = anly->stack.size;
+	int lastSlot = anly->slot;
 
 	int hasReturn = 0;
 	for (int i = 0; i < stat->compound.size; ++i)
@@ -313,6 +343,7 @@ bool _Analyzer_compoundStatement(Analyzer* anly, Declaration* decl, Statement* s
 	}
 
 	Vector_resize(&anly->stack, lastSize);
+	anly->slot = lastSlot;  //block slots are reused by next block
 	anly->level--;
 
 	return hasReturn != 0;
@@ -334,36 +365,44 @@ void _Analyzer_returnStatement(Analyzer* anly, Declaration* decl, Statement* sta
 	}
 }
 
+//every expression node is annotated with its type, backends do not derive it again
 Type _Analyzer_expression(Analyzer* anly, Expression* expr)
 {
 	Variant* var = NULL;
-	Declaration* decl = NULL;
+	Type type = errorType;
 
 	switch (expr->type)
 	{
 	case EXPR_TYPE_IDENT:
-		var = _Analyzer_findVariant(anly, expr->identExpr);
+		var = _Analyzer_findVariant(anly, expr->identExpr.name);
 		if (!var)
 		{
-			error(&expr->location, "undefined variant '" String_FMT "'", String_arg(expr->identExpr));
-			return errorType;
+			error(&expr->location, "undefined variant '" String_FMT "'", String_arg(expr->identExpr.name));
+			break;
 		}
-		return var->type;
+		expr->identExpr.slot = var->slot;
+		expr->identExpr.global = var->global;
+		type = var->type;
+		break;
 
 	case EXPR_TYPE_INT:
-		return intType;
+		type = intType;
+		break;
 
 	case EXPR_TYPE_BOOL:
-		return boolType;
+		type = boolType;
+		break;
 
 	case EXPR_TYPE_CALL:
-		return _Analyzer_callExpression(anly, expr);
+		type = _Analyzer_callExpression(anly, expr);
+		break;
 
 	case EXPR_TYPE_PLUS:
 	case EXPR_TYPE_MINUS:
 	case EXPR_TYPE_NOT:
 	case EXPR_TYPE_NEG:
-		return _Analyzer_unaryExpression(anly, expr);
+		type = _Analyzer_unaryExpression(anly, expr);
+		break;
 
 	case EXPR_TYPE_ADD:
 	case EXPR_TYPE_SUB:
@@ -383,15 +422,19 @@ Type _Analyzer_expression(Analyzer* anly, Expression* expr)
 	case EXPR_TYPE_XOR:
 	case EXPR_TYPE_LSHIFT:
 	case EXPR_TYPE_RSHIFT:
-		return _Analyzer_binaryExpression(anly, expr);
+		type = _Analyzer_binaryExpression(anly, expr);
+		break;
 
 	case EXPR_TYPE_COND:
-		return _Analyzer_conditionExpression(anly, expr);
+		type = _Analyzer_conditionExpression(anly, expr);
+		break;
 
 	default:
 		error(&expr->location, "incorrect expression");
 	}
-	return errorType;
+
+	expr->valueType = type.id;
+	return type;
 }
 
 Type _Analyzer_conditionExpression(Analyzer* anly, Expression* expr)
@@ -414,6 +457,7 @@ Type _Analyzer_conditionExpression(Analyzer* anly, Expression* expr)
 	if (!_Analyzer_checkTypeConvert(anly, type2, type3))
 		error(&expr->condExpr.expr3->location, "right expression type cannot convert to left type");
 
+	Constant_fold(expr);
 	return type2;
 }
 
@@ -422,13 +466,15 @@ Type _Analyzer_callExpression(Analyzer* anly, Expression* expr)
 	if (expr->callExpr.func->type != EXPR_TYPE_IDENT)
 		error(&expr->callExpr.func->location, "invalid function identifier");
 
-	Declaration* decl = _Analyzer_findFunction(anly, expr->callExpr.func->identExpr);  //check the function exists
+	Declaration* decl = Module_findFunction(anly->module, expr->callExpr.func->identExpr.name);  //check the function exists
 	if (!decl)
 	{
-		error(&expr->location, "undefined function '" String_FMT "'", String_arg(expr->callExpr.func->identExpr));
+		error(&expr->location, "undefined function '" String_FMT "'", String_arg(expr->callExpr.func->identExpr.name));
 		return errorType;
 	}
 
+	expr->callExpr.decl = decl;
+
 	if (expr->callExpr.args.size != decl->function.parameters.size)  //TODO: support variadic parameter
 	{
 		error(&expr->location, "function argument count not match");  //TODO: show difference
@@ -456,6 +502,7 @@ Type _Analyzer_unaryExpression(Analyzer* anly, Expression* expr)
 	if (rtype.id == TYPE_INIT)
 		error(&expr->unaryExpr->location, "expression type not support this operator");  //TODO: clarity the error message
 
+	Constant_fold(expr);
 	return rtype;
 }
 
@@ -470,10 +517,17 @@ Type _Analyzer_binaryExpression(Analyzer* anly, Expression* expr)
 
 	if (expr->type == EXPR_TYPE_DIV || expr->type == EXPR_TYPE_MOD)
 	{
-		if (_Analyzer_checkZero(anly, expr->binaryExpr.rightExpr))  //TODO: compile time eval expression value
+		if (_Analyzer_checkZero(anly, expr->binaryExpr.rightExpr))
 			error(&expr->binaryExpr.rightExpr->location, "division by zero");
 	}
 
+	if (expr->type == EXPR_TYPE_LSHIFT || expr->type == EXPR_TYPE_RSHIFT)
+	{
+		if (!_Analyzer_checkShift(anly, expr->binaryExpr.rightExpr))
+			error(&expr->binaryExpr.rightExpr->location, "shift count out of range");
+	}
+
+	Constant_fold(expr);  //operands are folded already
 	return ltype;
 }
 
@@ -615,17 +669,15 @@ bool _Analyzer_checkLvalue(Analyzer* anly, Expression* expr)
 
 bool _Analyzer_checkZero(Analyzer* anly, Expression* expr)
 {
-	switch (expr->type)  //TODO: compile time eval expression value
-	{
-	case EXPR_TYPE_INT:
-		return expr->intExpr == 0;
-
-	case EXPR_TYPE_PLUS:
-	case EXPR_TYPE_MINUS:
-		return _Analyzer_checkZero(anly,  expr->unaryExpr);
-	}
+	//constant subtrees are folded to literal before check
+	return expr->type == EXPR_TYPE_INT && expr->intExpr == 0;
+}
 
-	return false;
+bool _Analyzer_checkShift(Analyzer* anly, Expression* expr)
+{
+	if (expr->type != EXPR_TYPE_INT)
+		return true;
+	return expr->intExpr >= 0 && expr->intExpr < 32;
 }
 
 Variant* _Analyzer_findVariant(Analyzer* anly, String name)
@@ -639,13 +691,10 @@ Variant* _Analyzer_findVariant(Analyzer* anly, String name)
 	return NULL;
 }
 
-Declaration* _Analyzer_findFunction(Analyzer* anly, String name)
+int _Analyzer_allocSlot(Analyzer* anly)
 {
-	for (int i = 0; i < anly->module->functions.size; ++i)
-	{
-		Declaration* decl = Vector_get(&anly->module->functions, i);
-		if (String_equalsString(name, decl->function.name))
-			return decl;
-	}
-	return NULL;
+	int slot = anly->slot++;
+	if (anly->slot > anly->frameSize)
+		anly->frameSize = anly->slot;
+	return slot;
 }
@@ -10,6 +10,9 @@ struct Analyzer
 	Stack stack;  //Stack<Variant>
 	Module* module;
 	int level;
+	int slot;         //next free frame slot of current function
+	int frameSize;    //max frame slots of current function
+	int globalCount;
 };
 typedef struct Analyzer Analyzer;
 
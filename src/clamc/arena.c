@@ -0,0 +1,58 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "message.h"
+
+#define ARENA_ALIGN sizeof(void*)
+
+static void _Arena_grow(Arena* arena, size_t size);
+
+void Arena_init(Arena* arena)
+{
+	arena->blocks = NULL;
+	arena->ptr = NULL;
+	arena->end = NULL;
+	arena->used = 0;
+}
+
+void Arena_destroy(Arena* arena)
+{
+	ArenaBlock* block = arena->blocks;
+	while (block)
+	{
+		ArenaBlock* next = block->next;
+		free(block);
+		block = next;
+	}
+	Arena_init(arena);
+}
+
+void* Arena_alloc(Arena* arena, size_t size)
+{
+	size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+
+	if ((size_t)(arena->end - arena->ptr) < size)
+		_Arena_grow(arena, size);
+
+	void* p = arena->ptr;
+	arena->ptr += size;
+	arena->used += size;
+	return p;
+}
+
+void _Arena_grow(Arena* arena, size_t size)
+{
+	size_t header = (sizeof(ArenaBlock) + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+	size_t blockSize = size > ARENA_BLOCK_SIZE - header ? size + header : ARENA_BLOCK_SIZE;  //large object has own block
+
+	ArenaBlock* block = malloc(blockSize);
+	if (!block)
+		error(NULL, "out of memory");
+
+	block->next = arena->blocks;
+	block->size = blockSize;
+	arena->blocks = block;
+	arena->ptr = (char*)block + header;
+	arena->end = (char*)block + blockSize;
+}
@@ -0,0 +1,30 @@
+#ifndef CLAM_ARENA_H
+#define CLAM_ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+struct ArenaBlock
+{
+	struct ArenaBlock* next;
+	size_t size;
+};
+typedef struct ArenaBlock ArenaBlock;
+
+//bump pointer allocator, all memory released together by Arena_destroy
+struct Arena
+{
+	ArenaBlock* blocks;  //current block first
+	char* ptr;
+	char* end;
+	size_t used;
+};
+typedef struct Arena Arena;
+
+void Arena_init(Arena* arena);
+void Arena_destroy(Arena* arena);
+
+void* Arena_alloc(Arena* arena, size_t size);
+
+#endif
@@ -4,6 +4,7 @@
 #include <stdbool.h>
 
 #include "type.h"
+#include "arena.h"
 #include "vector.h"
 #include "strings.h"
 #include "source_location.h"
@@ -33,11 +34,11 @@ struct FuncDecl
 	String name;
 	Vector parameters;  //Vector<Parameter>
 	Vector block;       //Vector<Statement>
+	int frameSize;      //slots of parameters and local variants, set by analyzer
 };
 typedef struct FuncDecl FuncDecl;
 
 void FuncDecl_init(FuncDecl* func);
-void FuncDecl_destroy(FuncDecl* func);
 
 
 struct VarDecl
@@ -45,11 +46,10 @@ struct VarDecl
 	Type type;
 	String name;
 	struct Expression* initExpr;
+	int slot;  //frame slot of local variant, or index of global variant, set by analyzer
 };
 typedef struct VarDecl VarDecl;
 
-void VarDecl_destroy(VarDecl* vd);
-
 struct Declaration
 {
 	SourceLocation location;
@@ -69,7 +69,6 @@ struct Declaration
 typedef struct Declaration Declaration;
 
 void Declaration_init(Declaration* decl);
-void Declaration_destroy(Declaration* decl);
 
 
 //expression
@@ -121,11 +120,19 @@ struct ConditionExpression
 };
 typedef struct ConditionExpression ConditionExpression;
 
+struct IdentExpression
+{
+	String name;
+	int slot;     //same as VarDecl.slot of the referenced variant
+	bool global;
+};
+typedef struct IdentExpression IdentExpression;
+
 struct CallExpression
 {
 	struct Expression* func;
 	Vector args;  //Vector<Expression>
-
+	Declaration* decl;  //called function, resolved by analyzer
 };
 typedef struct CallExpression CallExpression;
 
@@ -133,12 +140,14 @@ struct Expression
 {
 	SourceLocation location;
 	ExprType type;
+	int flat;  //index in module flat code, -1 if not flattened, fits in padding
+	TypeId valueType;  //resolved by analyzer, TYPE_INIT before analyzing
 	union
 	{
 		int intExpr;
 		bool boolExpr;
 		CallExpression callExpr;
-		String identExpr;
+		IdentExpression identExpr;
 		struct Expression* unaryExpr;
 		BinaryExpression binaryExpr;
 		ConditionExpression condExpr;
@@ -146,14 +155,13 @@ struct Expression
 };
 typedef struct Expression Expression;
 
-Expression* Expression_create(ExprType type, SourceLocation* loc);
-Expression* Expression_createLiteral(ExprType type, Token* token);
-Expression* Expression_createCall(SourceLocation* loc, Expression* func);
-Expression* Expression_createIdent(SourceLocation* loc, Token* token);
-Expression* Expression_createUnary(SourceLocation* loc, ExprType type, Expression* right);
-Expression* Expression_createBinary(SourceLocation* loc, ExprType type, Expression* left, Expression* right);
-
-void Expression_destroy(Expression* expr);
+//nodes and their lists are allocated from module arena and released with it
+Expression* Expression_create(Arena* arena, ExprType type, SourceLocation* loc);
+Expression* Expression_createLiteral(Arena* arena, ExprType type, Token* token);
+Expression* Expression_createCall(Arena* arena, SourceLocation* loc, Expression* func);
+Expression* Expression_createIdent(Arena* arena, SourceLocation* loc, Token* token);
+Expression* Expression_createUnary(Arena* arena, SourceLocation* loc, ExprType type, Expression* right);
+Expression* Expression_createBinary(Arena* arena, SourceLocation* loc, ExprType type, Expression* left, Expression* right);
 
 bool Expression_contains(Expression* expr, ExprType type);
 
@@ -217,9 +225,8 @@ struct Statement
 typedef struct Statement Statement;
 
 void Statement_init(Statement* stat);
-void Statement_destroy(Statement* stat);
 
-Statement* Statement_alloc();
+Statement* Statement_alloc(Arena* arena);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <setjmp.h>
+
+#include "batch.h"
+#include "source.h"
+#include "executor.h"
+#include "vm.h"
+#include "jit.h"
+#include "thread.h"
+#include "message.h"
+
+//rows [begin, end) evaluated by one thread
+struct BatchWorker
+{
+	Batch* batch;
+	int begin;
+	int end;
+	int row;      //row being evaluated
+	bool failed;  //stopped by runtime error
+	Thread thread;
+};
+typedef struct BatchWorker BatchWorker;
+
+static void _Batch_parseCsv(Batch* batch, const char* filename, const char* data, const char* end);
+static void _Batch_check(Batch* batch, const char* filename);
+static void _Batch_work(void* arg);
+static void _Batch_report(void* user, const SourceLocation* loc, bool isError, const char* text);
+
+void Batch_init(Batch* batch, const Module* module, const Program* program, const char* function)
+{
+	String name = { function, (int)strlen(function) };
+	const Declaration* decl = Module_findFunction(module, name);
+	if (!decl || !decl->exported)
+		error(NULL, "exported function '%s' not found", function);
+	if (!decl->function.parameters.size)
+		error(&decl->location, "batch function '%s' has no parameters", function);
+
+	batch->module = module;
+	batch->program = program;
+	batch->function = decl;
+	batch->entry = (int)(decl - (Declaration*)module->functions.data);  //chunk index is same as module->functions
+	batch->argc = decl->function.parameters.size;
+	Vector_init(&batch->rows, sizeof(int));
+	Vector_init(&batch->results, sizeof(int));
+	batch->jit = false;
+	batch->stack = 0;
+}
+
+void Batch_destroy(Batch* batch)
+{
+	Vector_destroy(&batch->rows);
+	Vector_destroy(&batch->results);
+}
+
+void Batch_load(Batch* batch, const char* filename, bool binary)
+{
+	Source src;
+	if (!Source_open(&src, filename))
+		error(NULL, "open '%s' failed", filename);
+
+	Batch_parse(batch, filename, src.data, src.size, binary);
+	Source_destroy(&src);
+}
+
+void Batch_parse(Batch* batch, const char* name, const char* data, long long size, bool binary)
+{
+	if (binary)
+	{
+		long long rowSize = batch->argc * (long long)sizeof(int);
+		if (size % rowSize)
+			error(NULL, "'%s' size is not a multiple of %lld bytes", name, rowSize);
+		if (size / sizeof(int) > INT_MAX)
+			error(NULL, "'%s' has too many rows", name);
+
+		Vector_resize(&batch->rows, (int)(size / sizeof(int)));
+		if (size)
+			memcpy(batch->rows.data, data, size);
+	}
+	else
+		_Batch_parseCsv(batch, name, data, data + size);
+
+	_Batch_check(batch, name);
+}
+
+void Batch_run(Batch* batch, int threads)
+{
+	int count = batch->rows.size / batch->argc;
+	Vector_resize(&batch->results, count);
+
+	if (threads > count)
+		threads = count;
+	if (threads < 1)
+		threads = 1;
+
+	BatchWorker* workers = malloc(threads * sizeof(BatchWorker));
+	if (!workers)
+		fatal(NULL, "out of memory");
+
+	//contiguous rows per worker, this thread takes the first range
+	bool* started = calloc(threads, sizeof(bool));
+	for (int i = 0; i < threads; ++i)
+	{
+		workers[i].batch = batch;
+		workers[i].begin = (int)((long long)count * i / threads);
+		workers[i].end = (int)((long long)count * (i + 1) / threads);
+		workers[i].row = workers[i].begin;
+		workers[i].failed = false;
+	}
+
+	for (int i = 1; i < threads; ++i)
+		started[i] = Thread_start(&workers[i].thread, _Batch_work, &workers[i]);
+	_Batch_work(&workers[0]);
+
+	//ranges of threads failed to start run here
+	for (int i = 1; i < threads; ++i)
+	{
+		if (started[i])
+			Thread_join(&workers[i].thread);
+		else
+			_Batch_work(&workers[i]);
+	}
+
+	int failed = 0;
+	for (int i = 0; i < threads; ++i)
+		failed += workers[i].failed;
+
+	free(started);
+	free(workers);
+
+	if (failed)
+		error(NULL, "batch stopped by runtime error");
+}
+
+void Batch_write(Batch* batch, FILE* out, bool binary)
+{
+	if (binary)
+	{
+		fwrite(batch->results.data, sizeof(int), batch->results.size, out);
+		return;
+	}
+
+	const int* results = batch->results.data;
+	for (int i = 0; i < batch->results.size; ++i)
+		fprintf(out, "%d\n", results[i]);
+}
+
+void _Batch_parseCsv(Batch* batch, const char* filename, const char* data, const char* end)
+{
+	SourceLocation loc = { filename, 1, 1 };
+	const char* p = data;
+
+	while (p < end)
+	{
+		const char* line = p;
+		int values = 0;
+
+		for (;;)
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+				p++;
+			if (p == end || *p == '\n')
+				break;
+
+			loc.colum = (int)(p - line) + 1;
+			long long value = 0;
+
+			if (end - p >= 4 && memcmp(p, "true", 4) == 0)
+			{
+				value = 1;
+				p += 4;
+			}
+			else if (end - p >= 5 && memcmp(p, "false", 5) == 0)
+				p += 5;
+			else
+			{
+				bool neg = p < end && *p == '-';
+				if (neg || (p < end && *p == '+'))
+					p++;
+				if (p == end || *p < '0' || *p > '9')
+					error(&loc, "expected integer value");
+
+				while (p < end && *p >= '0' && *p <= '9')
+				{
+					value = value * 10 + (*p++ - '0');
+					if (value > (long long)INT_MAX + 1)
+						error(&loc, "integer value out of range");
+				}
+				if (neg)
+					value = -value;
+				if (value > INT_MAX)
+					error(&loc, "integer value out of range");
+			}
+
+			int v = (int)value;
+			Vector_add(&batch->rows, &v);
+			values++;
+
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+				p++;
+			if (p < end && *p == ',')
+				p++;
+			else if (p < end && *p != '\n')
+			{
+				loc.colum = (int)(p - line) + 1;
+				error(&loc, "expected ',' between values");
+			}
+		}
+
+		//blank lines are skipped
+		if (values && values != batch->argc)
+		{
+			loc.colum = 1;
+			error(&loc, "expected %d values, got %d", batch->argc, values);
+		}
+
+		if (p < end)
+			p++;  //'\n'
+		loc.line++;
+	}
+}
+
+void _Batch_check(Batch* batch, const char* filename)
+{
+	const int* rows = batch->rows.data;
+	const Vector* params = &batch->function->function.parameters;
+
+	for (int i = 0; i < batch->argc; ++i)
+	{
+		const Parameter* param = Vector_get(params, i);
+		if (param->type.id != TYPE_BOOL)
+			continue;
+
+		for (int j = i; j < batch->rows.size; j += batch->argc)
+		{
+			if (rows[j] != 0 && rows[j] != 1)
+				error(NULL, "'%s' row %d: value %d of bool parameter '" String_FMT "' is not 0 or 1", filename, j / batch->argc + 1, rows[j], String_arg(param->name));
+		}
+	}
+}
+
+void _Batch_work(void* arg)
+{
+	BatchWorker* w = arg;
+	Batch* batch = w->batch;
+	const int* rows = batch->rows.data;
+	int* results = batch->results.data;
+
+	Executor exec;
+	Executor_init(&exec);
+	if (batch->stack > 0)
+		exec.maxStack = batch->stack;
+
+	Jit native;
+	Jit_init(&native);
+
+	VM vm;
+	VM_init(&vm);
+	if (batch->stack > 0)
+		vm.maxRegisters = batch->stack;
+	if (batch->jit)
+		vm.jit = &native;
+
+	//runtime error is reported with its row, then this worker stops
+	MessageHandler handler;
+	handler.sink = _Batch_report;
+	handler.user = w;
+	Message_push(&handler);
+
+	if (setjmp(handler.jump) == 0)
+	{
+		//globals are reset for every row, so results do not depend on how rows are split
+		for (w->row = w->begin; w->row < w->end; w->row++)
+		{
+			const int* args = rows + (long long)w->row * batch->argc;
+			if (batch->program)
+			{
+				VM_load(&vm, batch->program);
+				results[w->row] = VM_call(&vm, batch->entry, args, batch->argc);
+			}
+			else
+			{
+				Executor_load(&exec, batch->module);
+				results[w->row] = Executor_call(&exec, batch->function, args, batch->argc);
+			}
+		}
+	}
+	else
+		w->failed = true;
+
+	Message_pop(&handler);
+
+	VM_destroy(&vm);
+	Jit_destroy(&native);
+	Executor_destroy(&exec);
+}
+
+void _Batch_report(void* user, const SourceLocation* loc, bool isError, const char* text)
+{
+	BatchWorker* w = user;
+	(loc && loc->filename) ? fprintf(stderr, "%s:%d:%d ", loc->filename, loc->line, loc->colum) : fprintf(stderr, "clamc: ");
+	fprintf(stderr, "%s: row %d: %s\n", isError ? "error" : "warnning", w->row + 1, text);
+}
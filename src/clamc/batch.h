@@ -0,0 +1,37 @@
+#ifndef CLAM_BATCH_H
+#define CLAM_BATCH_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "module.h"
+#include "bytecode.h"
+#include "vector.h"
+
+//calls one exported function for every row of int arguments, rows are split over threads
+//and each thread has its own executor or vm, module and program are shared
+struct Batch
+{
+	const Module* module;
+	const Program* program;       //NULL to run by AST executor
+	const Declaration* function;
+	int entry;                    //chunk of function
+	int argc;
+	Vector rows;                  //Vector<int>, argc values per row
+	Vector results;               //Vector<int>, one per row
+	bool jit;
+	int stack;                    //max stack of executor or vm, 0 for default
+};
+typedef struct Batch Batch;
+
+void Batch_init(Batch* batch, const Module* module, const Program* program, const char* function);
+void Batch_destroy(Batch* batch);
+
+//CSV text with one row per line, bool values are 0, 1, true or false,
+//or packed native int32 values if binary
+void Batch_load(Batch* batch, const char* filename, bool binary);
+void Batch_parse(Batch* batch, const char* name, const char* data, long long size, bool binary);
+void Batch_run(Batch* batch, int threads);
+void Batch_write(Batch* batch, FILE* out, bool binary);
+
+#endif
@@ -0,0 +1,77 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "bench.h"
+#include "lexer.h"
+#include "timer.h"
+
+static const char* tokenTypeToString[] =
+{
+	"eof",
+	"int",
+	"float",
+	"bool",
+	"literal",
+	"keyword",
+	"keyword_type",
+	"operator",
+	"delimiter",
+	"ident",
+};
+
+#define BENCH_TOKEN_TYPES (sizeof(tokenTypeToString) / sizeof(tokenTypeToString[0]))
+
+void Bench_lex(Source* src, int count, bool prelex)
+{
+	long long types[BENCH_TOKEN_TYPES];
+	memset(types, 0, sizeof(types));
+
+	if (count <= 0)
+		count = 1;
+
+	long long tokens = 0;
+	double beg = Timer_now();
+
+	for (int i = 0; i < count; ++i)
+	{
+		Source_reset(src);
+
+		Lexer lex;
+		Lexer_init(&lex, src);
+		if (prelex)
+			Lexer_prelex(&lex);
+
+		Token* token;
+		do
+		{
+			token = Lexer_next(&lex);
+			types[token->type]++;
+		} while (token->type != TOKEN_TYPE_EOF);
+
+		Lexer_destroy(&lex);
+	}
+
+	double elapsed = Timer_now() - beg;
+	if (elapsed <= 0)
+		elapsed = 1e-9;
+
+	for (int i = 0; i < BENCH_TOKEN_TYPES; ++i)
+		tokens += types[i];
+
+	double bytes = (double)src->size * count;
+
+	printf("file: %s (%lld bytes)\n", src->name, src->size);
+	printf("passes: %d%s\n", count, prelex ? ", pre-lexed" : "");
+	printf("tokens: %lld per pass\n", tokens / count);
+	printf("time: %.3f ms per pass\n", elapsed * 1000 / count);
+	printf("throughput: %.2f Mtokens/s, %.2f MB/s\n", tokens / elapsed / 1e6, bytes / elapsed / (1024 * 1024));
+
+	printf("token types:\n");
+	for (int i = 0; i < BENCH_TOKEN_TYPES; ++i)
+	{
+		if (types[i])
+			printf("  %-14s%lld\n", tokenTypeToString[i], types[i] / count);
+	}
+
+	Source_reset(src);
+}
@@ -0,0 +1,10 @@
+#ifndef CLAM_BENCH_H
+#define CLAM_BENCH_H
+
+#include "source.h"
+
+//tokenize source count times, print tokens/sec, MB/sec and token type counts
+//prelex measures filling the token buffer instead of streaming
+void Bench_lex(Source* src, int count, bool prelex);
+
+#endif
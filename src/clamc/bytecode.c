@@ -0,0 +1,42 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "bytecode.h"
+
+void Chunk_init(Chunk* chunk, String name, int argc)
+{
+	chunk->name = name;
+	Vector_init(&chunk->code, sizeof(Instruction));
+	Vector_init(&chunk->locations, sizeof(SourceLocation));
+	chunk->argc = argc;
+	chunk->frameSize = argc;
+}
+
+void Chunk_destroy(Chunk* chunk)
+{
+	Vector_destroy(&chunk->code);
+	Vector_destroy(&chunk->locations);
+}
+
+int Chunk_emit(Chunk* chunk, Instruction ins, SourceLocation* loc)
+{
+	SourceLocation none = { NULL, 0, 0 };
+	Vector_add(&chunk->code, &ins);
+	Vector_add(&chunk->locations, loc ? loc : &none);
+	return chunk->code.size - 1;
+}
+
+void Program_init(Program* prog)
+{
+	Vector_init(&prog->chunks, sizeof(Chunk));
+	prog->globalCount = 0;
+	prog->init = -1;
+	prog->main = -1;
+}
+
+void Program_destroy(Program* prog)
+{
+	for (int i = 0; i < prog->chunks.size; ++i)
+		Chunk_destroy(Vector_get(&prog->chunks, i));
+	Vector_destroy(&prog->chunks);
+}
@@ -0,0 +1,96 @@
+#ifndef CLAM_BYTECODE_H
+#define CLAM_BYTECODE_H
+
+#include "vector.h"
+#include "strings.h"
+#include "source_location.h"
+
+enum OpCode
+{
+	OP_NOP,
+
+	OP_LOADK,        // r[a] = imm
+	OP_MOVE,         // r[a] = r[b]
+	OP_GETGLOBAL,    // r[a] = g[b]
+	OP_SETGLOBAL,    // g[a] = r[b]
+
+	OP_NEGI,         // r[a] = -r[b]
+	OP_BITNOTI,      // r[a] = ~r[b]
+	OP_NOTB,         // r[a] = !r[b]
+	OP_INCI,         // r[a]++
+	OP_DECI,         // r[a]--
+
+	OP_ADDI,         // r[a] = r[b] + r[c]
+	OP_SUBI,         // r[a] = r[b] - r[c]
+	OP_MULI,         // r[a] = r[b] * r[c]
+	OP_DIVI,         // r[a] = r[b] / r[c]
+	OP_MODI,         // r[a] = r[b] % r[c]
+	OP_BITANDI,      // r[a] = r[b] & r[c]
+	OP_BITORI,       // r[a] = r[b] | r[c]
+	OP_XORI,         // r[a] = r[b] ^ r[c]
+	OP_SHLI,         // r[a] = r[b] << r[c]
+	OP_SHRI,         // r[a] = r[b] >> r[c]
+
+	OP_EQI,          // r[a] = r[b] == r[c]
+	OP_NEI,          // r[a] = r[b] != r[c]
+	OP_LTI,          // r[a] = r[b] < r[c]
+	OP_LEI,          // r[a] = r[b] <= r[c]
+	OP_GTI,          // r[a] = r[b] > r[c]
+	OP_GEI,          // r[a] = r[b] >= r[c]
+
+	OP_JMP,          // pc += imm
+	OP_JMPF,         // if (!r[a]) pc += imm
+	OP_JMPT,         // if (r[a]) pc += imm
+
+	OP_CALL,         // r[a] = chunk[b](r[a], r[a + 1], ...)
+	OP_RET,          // return r[a]
+	OP_RETV,         // return
+};
+typedef enum OpCode OpCode;
+
+//8 bytes per instruction
+struct Instruction
+{
+	unsigned short op;
+	unsigned short a;
+	union
+	{
+		struct
+		{
+			unsigned short b;
+			unsigned short c;
+		};
+		int imm;
+	};
+};
+typedef struct Instruction Instruction;
+
+#define BYTECODE_MAX_REGISTER 0xFFFF
+
+struct Chunk
+{
+	String name;
+	Vector code;       //Vector<Instruction>
+	Vector locations;  //Vector<SourceLocation>, parallel to code
+	int argc;
+	int frameSize;     //registers used by one call
+};
+typedef struct Chunk Chunk;
+
+void Chunk_init(Chunk* chunk, String name, int argc);
+void Chunk_destroy(Chunk* chunk);
+int Chunk_emit(Chunk* chunk, Instruction ins, SourceLocation* loc);
+
+struct Program
+{
+	Vector chunks;  //Vector<Chunk>, functions in module order then global init
+	int globalCount;
+	int init;       //global init chunk
+	int main;       //'main' chunk, -1 if not found
+};
+typedef struct Program Program;
+
+void Program_init(Program* prog);
+void Program_destroy(Program* prog);
+
+#endif
\ No newline at end of file
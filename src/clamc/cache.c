@@ -0,0 +1,174 @@
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#include <process.h>
+#include <windows.h>
+#define getpid _getpid
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "cache.h"
+#include "message.h"
+
+#define CACHE_PATH_SIZE 4096
+
+static void _Cache_build(Cache* cache);
+static unsigned long long _Cache_hash(unsigned long long hash, const char* data, long long size);
+static unsigned long long _Cache_check(unsigned long long hash, const char* data, long long size);
+static bool _Cache_path(Cache* cache, char* path, const char* key, const char* ext);
+
+void Cache_init(Cache* cache, const char* dir)
+{
+	cache->dir = dir;
+
+	//single level, parent must exist
+#ifdef _WIN32
+	_mkdir(dir);
+#else
+	mkdir(dir, 0777);
+#endif
+
+	_Cache_build(cache);
+}
+
+void Cache_destroy(Cache* cache)
+{
+	cache->dir = NULL;
+}
+
+void Cache_key(CacheKey* key, const char* data, long long size, const char* options)
+{
+	unsigned long long hash = 14695981039346656037ull;
+	hash = _Cache_hash(hash, data, size);
+	hash = _Cache_hash(hash, "\0", 1);  //separate source from options
+	hash = _Cache_hash(hash, options, strlen(options));
+	snprintf(key->name, CACHE_KEY_SIZE, "%016llx", hash);
+
+	unsigned long long check = 0;
+	check = _Cache_check(check, data, size);
+	check = _Cache_check(check, "\0", 1);
+	check = _Cache_check(check, options, strlen(options));
+	key->size = size;
+	key->check = check;
+}
+
+bool Cache_load(Cache* cache, const CacheKey* key, const char* ext, Rope* out)
+{
+	char path[CACHE_PATH_SIZE];
+	if (!_Cache_path(cache, path, key->name, ext))
+		return false;
+
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return false;
+
+	//entry starts with size and check of its source, other sources colliding on name are misses
+	long long size;
+	unsigned long long check;
+	if (fscanf(f, "%lld %llx", &size, &check) != 2 || fgetc(f) != '\n' || size != key->size || check != key->check)
+	{
+		fclose(f);
+		return false;
+	}
+
+	char buf[16 * 1024];
+	size_t n;
+	while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+		Rope_appendN(out, buf, (int)n);
+
+	fclose(f);
+	return true;
+}
+
+void Cache_store(Cache* cache, const CacheKey* key, const char* ext, Rope* content)
+{
+	char path[CACHE_PATH_SIZE];
+	char tmp[CACHE_PATH_SIZE + 64];
+	if (!_Cache_path(cache, path, key->name, ext))
+		return;
+
+	//unique per process and job, other compilers may store same key at the same time
+	snprintf(tmp, sizeof(tmp), "%s.%d.%p.tmp", path, (int)getpid(), (void*)content);
+
+	FILE* f = fopen(tmp, "wb");
+	if (!f)
+	{
+		warning(NULL, "write cache '%s' failed", tmp);
+		return;
+	}
+
+	fprintf(f, "%lld %016llx\n", key->size, key->check);
+	Rope_write(content, f);
+	bool ok = !ferror(f);
+	fclose(f);
+
+#ifdef _WIN32
+	remove(path);  //rename does not replace on windows
+#endif
+	if (!ok || rename(tmp, path) != 0)
+	{
+		remove(tmp);
+		warning(NULL, "write cache '%s' failed", path);
+	}
+}
+
+void _Cache_build(Cache* cache)
+{
+	//compiler executable, build time if it cannot be read
+	unsigned long long hash = 14695981039346656037ull;
+	FILE* f = NULL;
+#ifdef _WIN32
+	char path[CACHE_PATH_SIZE];
+	DWORD len = GetModuleFileNameA(NULL, path, sizeof(path));
+	if (len > 0 && len < sizeof(path))
+		f = fopen(path, "rb");
+#elif defined(__linux__)
+	f = fopen("/proc/self/exe", "rb");
+#endif
+
+	if (f)
+	{
+		char buf[16 * 1024];
+		size_t n;
+		while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+			hash = _Cache_hash(hash, buf, (long long)n);
+		fclose(f);
+	}
+	else
+	{
+		const char* stamp = __DATE__ " " __TIME__;
+		hash = _Cache_hash(hash, stamp, strlen(stamp));
+	}
+	snprintf(cache->build, CACHE_KEY_SIZE, "%016llx", hash);
+}
+
+unsigned long long _Cache_hash(unsigned long long hash, const char* data, long long size)
+{
+	for (long long i = 0; i < size; ++i)
+	{
+		hash ^= (unsigned char)data[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+unsigned long long _Cache_check(unsigned long long hash, const char* data, long long size)
+{
+	//multiply and fold, unrelated to FNV-1a so a collision of one is not a collision of both
+	for (long long i = 0; i < size; ++i)
+	{
+		hash = (hash + (unsigned char)data[i]) * 0x9E3779B97F4A7C15ull;
+		hash ^= hash >> 29;
+	}
+	return hash;
+}
+
+bool _Cache_path(Cache* cache, char* path, const char* key, const char* ext)
+{
+	int len = snprintf(path, CACHE_PATH_SIZE, "%s/%s.%s", cache->dir, key, ext);
+	return len > 0 && len < CACHE_PATH_SIZE;
+}
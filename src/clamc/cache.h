@@ -0,0 +1,37 @@
+#ifndef CLAM_CACHE_H
+#define CLAM_CACHE_H
+
+#include <stdbool.h>
+
+#include "rope.h"
+
+#define CACHE_KEY_SIZE 17  //16 hex digits and terminator
+
+//on-disk cache of generated output, one file per key and extension
+//entries are written to a temporary file and renamed, readers never see partial entries
+struct Cache
+{
+	const char* dir;
+	char build[CACHE_KEY_SIZE];  //hash of compiler executable, output of other builds is not reused
+};
+typedef struct Cache Cache;
+
+//entry of one source, size and second hash are stored in the entry and checked on load
+struct CacheKey
+{
+	char name[CACHE_KEY_SIZE];  //FNV-1a 64 of source bytes and compile options
+	long long size;             //source bytes
+	unsigned long long check;   //second hash of source bytes and compile options
+};
+typedef struct CacheKey CacheKey;
+
+void Cache_init(Cache* cache, const char* dir);
+void Cache_destroy(Cache* cache);
+
+void Cache_key(CacheKey* key, const char* data, long long size, const char* options);
+
+//false if missing or written for another source with same name
+bool Cache_load(Cache* cache, const CacheKey* key, const char* ext, Rope* out);
+void Cache_store(Cache* cache, const CacheKey* key, const char* ext, Rope* content);
+
+#endif
@@ -0,0 +1,133 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "clam.h"
+#include "source.h"
+#include "lexer.h"
+#include "parser.h"
+#include "analyzer.h"
+#include "compiler.h"
+#include "vm.h"
+
+struct ClamProgram
+{
+	char* name;
+	char* code;
+	Source source;
+	Lexer lex;
+	Parser parser;
+	Analyzer anly;
+	Module* module;  //NULL until compiled
+	Program program;
+	VM vm;           //interpret only, long jump out of native code is not portable
+};
+
+static char* _Clam_copy(const char* s);
+
+ClamProgram* Clam_compile(const char* name, const char* code, MessageSink sink, void* user)
+{
+	ClamProgram* clam = malloc(sizeof(ClamProgram));
+	clam->name = _Clam_copy(name ? name : "<string>");
+	clam->code = _Clam_copy(code);
+	clam->module = NULL;
+
+	Source_init(&clam->source, clam->code);
+	clam->source.name = clam->name;
+	Lexer_init(&clam->lex, &clam->source);
+	Parser_init(&clam->parser);
+	Analyzer_init(&clam->anly);
+	Program_init(&clam->program);
+	VM_init(&clam->vm);
+
+	MessageHandler handler;
+	handler.sink = sink;
+	handler.user = user;
+	Message_push(&handler);
+
+	if (setjmp(handler.jump) == 0)
+	{
+		Module* module = Parser_translate(&clam->parser, &clam->lex);
+		Analyzer_analyze(&clam->anly, module);
+
+		Compiler c;
+		Compiler_init(&c);
+		Compiler_compile(&c, module, &clam->program);
+		Compiler_destroy(&c);
+
+		clam->module = module;
+	}
+
+	Message_pop(&handler);
+
+	if (!clam->module)
+	{
+		Clam_free(clam);
+		return NULL;
+	}
+
+	return clam;
+}
+
+void Clam_free(ClamProgram* clam)
+{
+	if (!clam)
+		return;
+
+	//module nodes reference source text, release source last
+	VM_destroy(&clam->vm);
+	Program_destroy(&clam->program);
+	Analyzer_destroy(&clam->anly);
+	Parser_destroy(&clam->parser);
+	Lexer_destroy(&clam->lex);
+	Source_destroy(&clam->source);
+	free(clam->code);
+	free(clam->name);
+	free(clam);
+}
+
+bool Clam_run(ClamProgram* clam, const char* function, const int* args, int count, int* result, MessageSink sink, void* user)
+{
+	String name = { function, (int)strlen(function) };
+	Declaration* decl = Module_findFunction(clam->module, name);
+	volatile bool done = false;
+
+	MessageHandler handler;
+	handler.sink = sink;
+	handler.user = user;
+	Message_push(&handler);
+
+	if (setjmp(handler.jump) == 0)
+	{
+		if (!decl || !decl->exported)
+			error(NULL, "exported function '%s' not found", function);
+
+		FuncDecl* func = &decl->function;
+		if (count != func->parameters.size)
+			error(&decl->location, "function '%s' takes %d arguments, but %d given", function, func->parameters.size, count);
+
+		for (int i = 0; i < count; i++)
+		{
+			Parameter* param = Vector_get(&func->parameters, i);
+			if (param->type.id == TYPE_BOOL && args[i] != 0 && args[i] != 1)
+				error(&decl->location, "argument %d of function '%s' is not a bool", i + 1, function);
+		}
+
+		int entry = (int)(decl - (Declaration*)clam->module->functions.data);  //chunk index is same as module->functions
+		VM_load(&clam->vm, &clam->program);
+		int ret = VM_call(&clam->vm, entry, args, count);
+		if (result)
+			*result = ret;
+		done = true;
+	}
+
+	Message_pop(&handler);
+	return done;
+}
+
+char* _Clam_copy(const char* s)
+{
+	size_t size = strlen(s) + 1;
+	char* copy = malloc(size);
+	memcpy(copy, s, size);
+	return copy;
+}
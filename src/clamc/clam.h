@@ -0,0 +1,22 @@
+#ifndef CLAM_CLAM_H
+#define CLAM_CLAM_H
+
+#include <stdbool.h>
+
+#include "message.h"
+
+//library entry, compiles and runs programs in process without touching
+//global state; diagnostics go to the sink of the call and never exit.
+//different programs may be used by different threads at the same time,
+//one program is used by one thread at a time
+struct ClamProgram;
+typedef struct ClamProgram ClamProgram;
+
+//compile source text, returns NULL after reporting errors to sink
+ClamProgram* Clam_compile(const char* name, const char* code, MessageSink sink, void* user);
+void Clam_free(ClamProgram* clam);
+
+//call exported function with fresh globals, false after reporting errors to sink
+bool Clam_run(ClamProgram* clam, const char* function, const int* args, int count, int* result, MessageSink sink, void* user);
+
+#endif
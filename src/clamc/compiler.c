@@ -0,0 +1,566 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "message.h"
+
+static void _Compiler_function(Compiler* c, Declaration* decl, Chunk* chunk);
+static void _Compiler_globalInit(Compiler* c, Chunk* chunk);
+static void _Compiler_statement(Compiler* c, Statement* stat);
+static void _Compiler_variant(Compiler* c, Declaration* decl);
+static void _Compiler_ifStatement(Compiler* c, Statement* stat);
+static void _Compiler_assignStatement(Compiler* c, Statement* stat);
+static void _Compiler_incDecStatement(Compiler* c, Statement* stat);
+static void _Compiler_compoundStatement(Compiler* c, Vector* block);
+static void _Compiler_returnStatement(Compiler* c, Statement* stat);
+static int _Compiler_expression(Compiler* c, Expression* expr, int dest);
+static int _Compiler_identExpression(Compiler* c, Expression* expr, int dest);
+static int _Compiler_conditionExpression(Compiler* c, Expression* expr, int dest);
+static int _Compiler_logicExpression(Compiler* c, Expression* expr, int dest);
+static int _Compiler_callExpression(Compiler* c, Expression* expr, int dest);
+static int _Compiler_unaryExpression(Compiler* c, Expression* expr, int dest);
+static int _Compiler_binaryExpression(Compiler* c, Expression* expr, int dest);
+static OpCode _Compiler_binaryOpCode(ExprType type);
+static int _Compiler_emit(Compiler* c, OpCode op, int a, int b, int cc, SourceLocation* loc);
+static int _Compiler_emitJump(Compiler* c, OpCode op, int a, SourceLocation* loc);
+static void _Compiler_patchJump(Compiler* c, int index);
+static int _Compiler_allocRegister(Compiler* c, SourceLocation* loc);
+static int _Compiler_target(Compiler* c, int dest, SourceLocation* loc);
+static int _Compiler_functionIndex(Compiler* c, Declaration* decl);
+
+void Compiler_init(Compiler* c)
+{
+	c->module = NULL;
+	c->program = NULL;
+	c->chunk = NULL;
+	c->top = 0;
+}
+
+void Compiler_destroy(Compiler* c)
+{
+}
+
+void Compiler_compile(Compiler* c, Module* module, Program* program)
+{
+	c->module = module;
+	c->program = program;
+
+	//global variants, numbered by declaration order
+	program->globalCount = 0;
+	for (int i = 0; i < module->declarations.size; i++)
+	{
+		Declaration* decl = Vector_get(&module->declarations, i);
+		if (decl->type == DECL_TYPE_VARIANT)
+			program->globalCount++;
+	}
+
+	//one chunk per function, same index as module->functions
+	Chunk chunk;
+	for (int i = 0; i < module->functions.size; i++)
+	{
+		Declaration* decl = Vector_get(&module->functions, i);
+		Chunk_init(&chunk, decl->function.name, decl->function.parameters.size);
+		Vector_add(&program->chunks, &chunk);
+	}
+
+	String init = String_literal("<init>");
+	Chunk_init(&chunk, init, 0);
+	Vector_add(&program->chunks, &chunk);
+	program->init = program->chunks.size - 1;
+
+	//compile (chunks vector is stable from here)
+	for (int i = 0; i < module->functions.size; i++)
+		_Compiler_function(c, Vector_get(&module->functions, i), Vector_get(&program->chunks, i));
+
+	_Compiler_globalInit(c, Vector_get(&program->chunks, program->init));
+
+	String main = String_literal("main");
+	program->main = _Compiler_functionIndex(c, Module_findFunction(module, main));
+}
+
+void _Compiler_function(Compiler* c, Declaration* decl, Chunk* chunk)
+{
+	FuncDecl* func = &decl->function;
+	c->chunk = chunk;
+
+	//parameters and local variants use their frame slots as registers, temporaries follow
+	if (func->frameSize >= BYTECODE_MAX_REGISTER)
+		error(&decl->location, "too many variants in function '" String_FMT "'", String_arg(func->name));
+
+	chunk->frameSize = func->frameSize;
+	c->top = func->frameSize;
+
+	for (int i = 0; i < func->block.size; ++i)
+		_Compiler_statement(c, Vector_get(&func->block, i));
+
+	_Compiler_emit(c, OP_RETV, 0, 0, 0, &decl->location);  //implicit return
+
+	c->chunk = NULL;
+}
+
+void _Compiler_globalInit(Compiler* c, Chunk* chunk)
+{
+	c->chunk = chunk;
+	c->top = 0;
+
+	for (int i = 0; i < c->module->declarations.size; i++)
+	{
+		Declaration* decl = Vector_get(&c->module->declarations, i);
+		if (decl->type != DECL_TYPE_VARIANT || !decl->variant.initExpr)
+			continue;
+
+		int r = _Compiler_expression(c, decl->variant.initExpr, -1);
+		_Compiler_emit(c, OP_SETGLOBAL, decl->variant.slot, r, 0, &decl->location);
+		c->top = 0;
+	}
+
+	_Compiler_emit(c, OP_RETV, 0, 0, 0, NULL);
+	c->chunk = NULL;
+}
+
+void _Compiler_statement(Compiler* c, Statement* stat)
+{
+	int top = c->top;
+
+	switch (stat->type)
+	{
+	case STATEMENT_TYPE_DECLARATION:
+		_Compiler_variant(c, &stat->declaration);
+		break;
+
+	case STATEMENT_TYPE_IF:
+		_Compiler_ifStatement(c, stat);
+		break;
+
+	case STATEMENT_TYPE_COMPOUND:
+		_Compiler_compoundStatement(c, &stat->compound);
+		break;
+
+	case STATEMENT_TYPE_ASSIGN:
+	case STATEMENT_TYPE_ADD_ASSIGN:
+	case STATEMENT_TYPE_SUB_ASSIGN:
+	case STATEMENT_TYPE_MUL_ASSIGN:
+	case STATEMENT_TYPE_DIV_ASSIGN:
+	case STATEMENT_TYPE_MOD_ASSIGN:
+	case STATEMENT_TYPE_BITAND_ASSIGN:
+	case STATEMENT_TYPE_BITOR_ASSIGN:
+	case STATEMENT_TYPE_XOR_ASSIGN:
+	case STATEMENT_TYPE_LSHIFT_ASSIGN:
+	case STATEMENT_TYPE_RSHIFT_ASSIGN:
+		_Compiler_assignStatement(c, stat);
+		break;
+
+	case STATEMENT_TYPE_INC:
+	case STATEMENT_TYPE_DEC:
+		_Compiler_incDecStatement(c, stat);
+		break;
+
+	case STATEMENT_TYPE_EXPRESSION:
+		_Compiler_expression(c, stat->expr, -1);
+		break;
+
+	case STATEMENT_TYPE_RETURN:
+		_Compiler_returnStatement(c, stat);
+		break;
+	}
+
+	c->top = top;  //free temporary registers
+}
+
+void _Compiler_variant(Compiler* c, Declaration* decl)
+{
+	int reg = decl->variant.slot;
+
+	if (decl->variant.initExpr)
+		_Compiler_expression(c, decl->variant.initExpr, reg);
+	else
+		_Compiler_emit(c, OP_LOADK, reg, 0, 0, &decl->location);
+}
+
+void _Compiler_ifStatement(Compiler* c, Statement* stat)
+{
+	int top = c->top;
+	int cond = _Compiler_expression(c, stat->ifStat.condition, -1);
+	int jumpElse = _Compiler_emitJump(c, OP_JMPF, cond, &stat->location);
+	c->top = top;
+
+	_Compiler_statement(c, stat->ifStat.statement);
+
+	if (stat->ifStat.elseStat)
+	{
+		int jumpEnd = _Compiler_emitJump(c, OP_JMP, 0, &stat->location);
+		_Compiler_patchJump(c, jumpElse);
+		_Compiler_statement(c, stat->ifStat.elseStat);
+		_Compiler_patchJump(c, jumpEnd);
+	}
+	else
+	{
+		_Compiler_patchJump(c, jumpElse);
+	}
+}
+
+void _Compiler_assignStatement(Compiler* c, Statement* stat)
+{
+	Expression* left = stat->assign.leftExpr;
+	Expression* right = stat->assign.rightExpr;
+	IdentExpression* ident = &left->identExpr;  //TODO: more lvalue expression
+
+	if (stat->type == STATEMENT_TYPE_ASSIGN)
+	{
+		if (!ident->global)
+		{
+			_Compiler_expression(c, right, ident->slot);
+		}
+		else
+		{
+			int r = _Compiler_expression(c, right, -1);
+			_Compiler_emit(c, OP_SETGLOBAL, ident->slot, r, 0, &stat->location);
+		}
+		return;
+	}
+
+	OpCode op = OP_NOP;
+	switch (stat->type)
+	{
+	case STATEMENT_TYPE_ADD_ASSIGN:    op = OP_ADDI;    break;
+	case STATEMENT_TYPE_SUB_ASSIGN:    op = OP_SUBI;    break;
+	case STATEMENT_TYPE_MUL_ASSIGN:    op = OP_MULI;    break;
+	case STATEMENT_TYPE_DIV_ASSIGN:    op = OP_DIVI;    break;
+	case STATEMENT_TYPE_MOD_ASSIGN:    op = OP_MODI;    break;
+	case STATEMENT_TYPE_BITAND_ASSIGN: op = OP_BITANDI; break;
+	case STATEMENT_TYPE_BITOR_ASSIGN:  op = OP_BITORI;  break;
+	case STATEMENT_TYPE_XOR_ASSIGN:    op = OP_XORI;    break;
+	case STATEMENT_TYPE_LSHIFT_ASSIGN: op = OP_SHLI;    break;
+	case STATEMENT_TYPE_RSHIFT_ASSIGN: op = OP_SHRI;    break;
+	}
+
+	int rvalue = _Compiler_expression(c, right, -1);
+
+	if (!ident->global)
+	{
+		_Compiler_emit(c, op, ident->slot, ident->slot, rvalue, &right->location);
+	}
+	else
+	{
+		int lvalue = _Compiler_allocRegister(c, &left->location);
+		_Compiler_emit(c, OP_GETGLOBAL, lvalue, ident->slot, 0, &left->location);
+		_Compiler_emit(c, op, lvalue, lvalue, rvalue, &right->location);
+		_Compiler_emit(c, OP_SETGLOBAL, ident->slot, lvalue, 0, &stat->location);
+	}
+}
+
+void _Compiler_incDecStatement(Compiler* c, Statement* stat)
+{
+	OpCode op = stat->type == STATEMENT_TYPE_INC ? OP_INCI : OP_DECI;
+	IdentExpression* ident = &stat->incExpr->identExpr;  //TODO: more lvalue expression
+
+	if (!ident->global)
+	{
+		_Compiler_emit(c, op, ident->slot, 0, 0, &stat->location);
+	}
+	else
+	{
+		int r = _Compiler_allocRegister(c, &stat->location);
+		_Compiler_emit(c, OP_GETGLOBAL, r, ident->slot, 0, &stat->location);
+		_Compiler_emit(c, op, r, 0, 0, &stat->location);
+		_Compiler_emit(c, OP_SETGLOBAL, ident->slot, r, 0, &stat->location);
+	}
+}
+
+void _Compiler_compoundStatement(Compiler* c, Vector* block)
+{
+	for (int i = 0; i < block->size; ++i)
+		_Compiler_statement(c, Vector_get(block, i));
+}
+
+void _Compiler_returnStatement(Compiler* c, Statement* stat)
+{
+	if (stat->returnExpr)
+	{
+		int r = _Compiler_expression(c, stat->returnExpr, -1);
+		_Compiler_emit(c, OP_RET, r, 0, 0, &stat->location);
+	}
+	else
+	{
+		_Compiler_emit(c, OP_RETV, 0, 0, 0, &stat->location);
+	}
+}
+
+//compile expression value to register dest, or any register if dest < 0, return the result register
+int _Compiler_expression(Compiler* c, Expression* expr, int dest)
+{
+	Instruction ins;
+	int r;
+
+	switch (expr->type)
+	{
+	case EXPR_TYPE_IDENT:
+		return _Compiler_identExpression(c, expr, dest);
+
+	case EXPR_TYPE_INT:
+	case EXPR_TYPE_BOOL:
+		r = _Compiler_target(c, dest, &expr->location);
+		ins.op = OP_LOADK;
+		ins.a = r;
+		ins.imm = expr->type == EXPR_TYPE_INT ? expr->intExpr : expr->boolExpr;
+		Chunk_emit(c->chunk, ins, &expr->location);
+		return r;
+
+	case EXPR_TYPE_CALL:
+		return _Compiler_callExpression(c, expr, dest);
+
+	case EXPR_TYPE_PLUS:
+	case EXPR_TYPE_MINUS:
+	case EXPR_TYPE_NOT:
+	case EXPR_TYPE_NEG:
+		return _Compiler_unaryExpression(c, expr, dest);
+
+	case EXPR_TYPE_ADD:
+	case EXPR_TYPE_SUB:
+	case EXPR_TYPE_MUL:
+	case EXPR_TYPE_DIV:
+	case EXPR_TYPE_MOD:
+	case EXPR_TYPE_NE:
+	case EXPR_TYPE_EQ:
+	case EXPR_TYPE_LT:
+	case EXPR_TYPE_LE:
+	case EXPR_TYPE_GT:
+	case EXPR_TYPE_GE:
+	case EXPR_TYPE_BITAND:
+	case EXPR_TYPE_BITOR:
+	case EXPR_TYPE_XOR:
+	case EXPR_TYPE_LSHIFT:
+	case EXPR_TYPE_RSHIFT:
+		return _Compiler_binaryExpression(c, expr, dest);
+
+	case EXPR_TYPE_AND:
+	case EXPR_TYPE_OR:
+		return _Compiler_logicExpression(c, expr, dest);
+
+	case EXPR_TYPE_COND:
+		return _Compiler_conditionExpression(c, expr, dest);
+	}
+
+	error(&expr->location, "incorrect expression");
+	return -1;
+}
+
+int _Compiler_identExpression(Compiler* c, Expression* expr, int dest)
+{
+	IdentExpression* ident = &expr->identExpr;
+	if (!ident->global)
+	{
+		if (dest < 0 || dest == ident->slot)
+			return ident->slot;  //read variant register directly
+
+		_Compiler_emit(c, OP_MOVE, dest, ident->slot, 0, &expr->location);
+		return dest;
+	}
+
+	int r = _Compiler_target(c, dest, &expr->location);
+	_Compiler_emit(c, OP_GETGLOBAL, r, ident->slot, 0, &expr->location);
+	return r;
+}
+
+int _Compiler_conditionExpression(Compiler* c, Expression* expr, int dest)
+{
+	//dest may be read by the branches (a = b ? a : 0), so evaluate to a new register
+	int top = c->top;
+	int r = _Compiler_allocRegister(c, &expr->location);
+
+	int cond = _Compiler_expression(c, expr->condExpr.expr1, -1);
+	int jumpElse = _Compiler_emitJump(c, OP_JMPF, cond, &expr->location);
+	c->top = r + 1;
+
+	_Compiler_expression(c, expr->condExpr.expr2, r);
+	int jumpEnd = _Compiler_emitJump(c, OP_JMP, 0, &expr->location);
+	c->top = r + 1;
+
+	_Compiler_patchJump(c, jumpElse);
+	_Compiler_expression(c, expr->condExpr.expr3, r);
+	_Compiler_patchJump(c, jumpEnd);
+
+	if (dest < 0)
+	{
+		c->top = r + 1;
+		return r;
+	}
+
+	c->top = top;
+	_Compiler_emit(c, OP_MOVE, dest, r, 0, &expr->location);
+	return dest;
+}
+
+int _Compiler_logicExpression(Compiler* c, Expression* expr, int dest)
+{
+	int top = c->top;
+	int r = _Compiler_allocRegister(c, &expr->location);
+
+	_Compiler_expression(c, expr->binaryExpr.leftExpr, r);
+	c->top = r + 1;
+
+	//short cut eval
+	int jumpEnd = _Compiler_emitJump(c, expr->type == EXPR_TYPE_AND ? OP_JMPF : OP_JMPT, r, &expr->location);
+	_Compiler_expression(c, expr->binaryExpr.rightExpr, r);
+	_Compiler_patchJump(c, jumpEnd);
+
+	if (dest < 0)
+	{
+		c->top = r + 1;
+		return r;
+	}
+
+	c->top = top;
+	_Compiler_emit(c, OP_MOVE, dest, r, 0, &expr->location);
+	return dest;
+}
+
+int _Compiler_callExpression(Compiler* c, Expression* expr, int dest)
+{
+	int index = _Compiler_functionIndex(c, expr->callExpr.decl);
+
+	//call without arguments from an empty frame would start callee at caller base,
+	//skip a register so recursion through it still grows stack
+	if (c->top == 0 && expr->callExpr.args.size == 0)
+		_Compiler_allocRegister(c, &expr->location);
+
+	//arguments are evaluated left to right into consecutive registers, become parameters of callee frame
+	int base = c->top;
+	for (int i = 0; i < expr->callExpr.args.size; ++i)
+	{
+		Expression* arg = Vector_get(&expr->callExpr.args, i);
+		int r = _Compiler_allocRegister(c, &arg->location);
+		_Compiler_expression(c, arg, r);
+		c->top = r + 1;
+	}
+
+	//callee frame must be counted for the result register
+	if (c->top == base)
+		_Compiler_allocRegister(c, &expr->location);
+
+	_Compiler_emit(c, OP_CALL, base, index, 0, &expr->location);
+
+	if (dest < 0 || dest == base)
+	{
+		c->top = base + 1;
+		return base;
+	}
+
+	c->top = base;
+	_Compiler_emit(c, OP_MOVE, dest, base, 0, &expr->location);
+	return dest;
+}
+
+int _Compiler_unaryExpression(Compiler* c, Expression* expr, int dest)
+{
+	if (expr->type == EXPR_TYPE_PLUS)
+		return _Compiler_expression(c, expr->unaryExpr, dest);
+
+	OpCode op = OP_NOP;
+	switch (expr->type)
+	{
+	case EXPR_TYPE_MINUS: op = OP_NEGI;    break;
+	case EXPR_TYPE_NEG:   op = OP_BITNOTI; break;
+	case EXPR_TYPE_NOT:   op = OP_NOTB;    break;
+	}
+
+	int top = c->top;
+	int r = _Compiler_expression(c, expr->unaryExpr, -1);
+	c->top = top;
+
+	int res = _Compiler_target(c, dest, &expr->location);
+	_Compiler_emit(c, op, res, r, 0, &expr->location);
+	return res;
+}
+
+int _Compiler_binaryExpression(Compiler* c, Expression* expr, int dest)
+{
+	int top = c->top;
+	int left = _Compiler_expression(c, expr->binaryExpr.leftExpr, -1);
+	int right = _Compiler_expression(c, expr->binaryExpr.rightExpr, -1);
+	c->top = top;
+
+	//operands are read before result written, so dest can reuse them
+	int res = _Compiler_target(c, dest, &expr->location);
+
+	OpCode op = _Compiler_binaryOpCode(expr->type);  //bool is 0 or 1 in register, compare as int
+
+	if (op == OP_DIVI || op == OP_MODI)
+		_Compiler_emit(c, op, res, left, right, &expr->binaryExpr.rightExpr->location);  //for division by zero error
+	else
+		_Compiler_emit(c, op, res, left, right, &expr->location);
+
+	return res;
+}
+
+OpCode _Compiler_binaryOpCode(ExprType type)
+{
+	switch (type)
+	{
+	case EXPR_TYPE_ADD:    return OP_ADDI;
+	case EXPR_TYPE_SUB:    return OP_SUBI;
+	case EXPR_TYPE_MUL:    return OP_MULI;
+	case EXPR_TYPE_DIV:    return OP_DIVI;
+	case EXPR_TYPE_MOD:    return OP_MODI;
+	case EXPR_TYPE_NE:     return OP_NEI;
+	case EXPR_TYPE_EQ:     return OP_EQI;
+	case EXPR_TYPE_LT:     return OP_LTI;
+	case EXPR_TYPE_LE:     return OP_LEI;
+	case EXPR_TYPE_GT:     return OP_GTI;
+	case EXPR_TYPE_GE:     return OP_GEI;
+	case EXPR_TYPE_BITAND: return OP_BITANDI;
+	case EXPR_TYPE_BITOR:  return OP_BITORI;
+	case EXPR_TYPE_XOR:    return OP_XORI;
+	case EXPR_TYPE_LSHIFT: return OP_SHLI;
+	case EXPR_TYPE_RSHIFT: return OP_SHRI;
+	}
+	return OP_NOP;
+}
+
+int _Compiler_emit(Compiler* c, OpCode op, int a, int b, int cc, SourceLocation* loc)
+{
+	Instruction ins;
+	ins.op = op;
+	ins.a = a;
+	ins.b = b;
+	ins.c = cc;
+	return Chunk_emit(c->chunk, ins, loc);
+}
+
+int _Compiler_emitJump(Compiler* c, OpCode op, int a, SourceLocation* loc)
+{
+	Instruction ins;
+	ins.op = op;
+	ins.a = a;
+	ins.imm = 0;  //patch later
+	return Chunk_emit(c->chunk, ins, loc);
+}
+
+void _Compiler_patchJump(Compiler* c, int index)
+{
+	Instruction* ins = Vector_get(&c->chunk->code, index);
+	ins->imm = c->chunk->code.size - index - 1;  //relative to next instruction
+}
+
+int _Compiler_allocRegister(Compiler* c, SourceLocation* loc)
+{
+	if (c->top >= BYTECODE_MAX_REGISTER)
+		error(loc, "too many registers in function '" String_FMT "'", String_arg(c->chunk->name));
+
+	int r = c->top++;
+	if (c->top > c->chunk->frameSize)
+		c->chunk->frameSize = c->top;
+	return r;
+}
+
+int _Compiler_target(Compiler* c, int dest, SourceLocation* loc)
+{
+	return dest < 0 ? _Compiler_allocRegister(c, loc) : dest;
+}
+
+int _Compiler_functionIndex(Compiler* c, Declaration* decl)
+{
+	if (!decl)
+		return -1;
+	return (int)(decl - (Declaration*)c->module->functions.data);  //chunk index is same as module->functions
+}
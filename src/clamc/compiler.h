@@ -0,0 +1,22 @@
+#ifndef CLAM_COMPILER_H
+#define CLAM_COMPILER_H
+
+#include "module.h"
+#include "bytecode.h"
+
+//lower an analyzed module to register bytecode, variant slots are used as registers
+struct Compiler
+{
+	Module* module;
+	Program* program;
+	Chunk* chunk;
+	int top;        //first free temporary register of current chunk
+};
+typedef struct Compiler Compiler;
+
+void Compiler_init(Compiler* c);
+void Compiler_destroy(Compiler* c);
+
+void Compiler_compile(Compiler* c, Module* module, Program* program);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,266 @@
+#include "constant.h"
+
+static bool _Constant_literal(Expression* expr, Constant* value);
+static bool _Constant_unary(ExprType op, Constant* right, Constant* value);
+static bool _Constant_binary(ExprType op, Constant* left, Constant* right, Constant* value);
+static void _Constant_store(Expression* expr, Constant* value);
+
+bool Constant_evaluate(Expression* expr, Constant* value)
+{
+	Constant left, right;
+
+	switch (expr->type)
+	{
+	case EXPR_TYPE_INT:
+	case EXPR_TYPE_BOOL:
+		return _Constant_literal(expr, value);
+
+	case EXPR_TYPE_PLUS:
+	case EXPR_TYPE_MINUS:
+	case EXPR_TYPE_NOT:
+	case EXPR_TYPE_NEG:
+		return Constant_evaluate(expr->unaryExpr, &right) && _Constant_unary(expr->type, &right, value);
+
+	case EXPR_TYPE_AND:
+	case EXPR_TYPE_OR:
+		if (!Constant_evaluate(expr->binaryExpr.leftExpr, &left))
+			return false;
+		if (left.boolValue == (expr->type == EXPR_TYPE_OR))  //short circuit
+		{
+			*value = left;
+			return true;
+		}
+		return Constant_evaluate(expr->binaryExpr.rightExpr, value);
+
+	case EXPR_TYPE_ADD:
+	case EXPR_TYPE_SUB:
+	case EXPR_TYPE_MUL:
+	case EXPR_TYPE_DIV:
+	case EXPR_TYPE_MOD:
+	case EXPR_TYPE_NE:
+	case EXPR_TYPE_EQ:
+	case EXPR_TYPE_LT:
+	case EXPR_TYPE_LE:
+	case EXPR_TYPE_GT:
+	case EXPR_TYPE_GE:
+	case EXPR_TYPE_BITAND:
+	case EXPR_TYPE_BITOR:
+	case EXPR_TYPE_XOR:
+	case EXPR_TYPE_LSHIFT:
+	case EXPR_TYPE_RSHIFT:
+		return Constant_evaluate(expr->binaryExpr.leftExpr, &left)
+			&& Constant_evaluate(expr->binaryExpr.rightExpr, &right)
+			&& _Constant_binary(expr->type, &left, &right, value);
+
+	case EXPR_TYPE_COND:
+		if (!Constant_evaluate(expr->condExpr.expr1, &left))
+			return false;
+		return Constant_evaluate(left.boolValue ? expr->condExpr.expr2 : expr->condExpr.expr3, value);
+	}
+
+	return false;
+}
+
+bool Constant_fold(Expression* expr)
+{
+	Constant left, right, value;
+
+	switch (expr->type)
+	{
+	case EXPR_TYPE_PLUS:
+	case EXPR_TYPE_MINUS:
+	case EXPR_TYPE_NOT:
+	case EXPR_TYPE_NEG:
+		if (!_Constant_literal(expr->unaryExpr, &right) || !_Constant_unary(expr->type, &right, &value))
+			return false;
+		break;
+
+	case EXPR_TYPE_AND:
+	case EXPR_TYPE_OR:
+		if (!_Constant_literal(expr->binaryExpr.leftExpr, &left))
+			return false;
+		if (left.boolValue == (expr->type == EXPR_TYPE_OR))  //right is never evaluated
+			_Constant_store(expr, &left);
+		else
+			*expr = *expr->binaryExpr.rightExpr;
+		return true;
+
+	case EXPR_TYPE_ADD:
+	case EXPR_TYPE_SUB:
+	case EXPR_TYPE_MUL:
+	case EXPR_TYPE_DIV:
+	case EXPR_TYPE_MOD:
+	case EXPR_TYPE_NE:
+	case EXPR_TYPE_EQ:
+	case EXPR_TYPE_LT:
+	case EXPR_TYPE_LE:
+	case EXPR_TYPE_GT:
+	case EXPR_TYPE_GE:
+	case EXPR_TYPE_BITAND:
+	case EXPR_TYPE_BITOR:
+	case EXPR_TYPE_XOR:
+	case EXPR_TYPE_LSHIFT:
+	case EXPR_TYPE_RSHIFT:
+		if (!_Constant_literal(expr->binaryExpr.leftExpr, &left) || !_Constant_literal(expr->binaryExpr.rightExpr, &right))
+			return false;
+		if (!_Constant_binary(expr->type, &left, &right, &value))
+			return false;
+		break;
+
+	case EXPR_TYPE_COND:
+		if (!_Constant_literal(expr->condExpr.expr1, &left))
+			return false;
+		*expr = left.boolValue ? *expr->condExpr.expr2 : *expr->condExpr.expr3;
+		return true;
+
+	default:
+		return false;
+	}
+
+	_Constant_store(expr, &value);
+	return true;
+}
+
+bool _Constant_literal(Expression* expr, Constant* value)
+{
+	switch (expr->type)
+	{
+	case EXPR_TYPE_INT:
+		value->type = TYPE_INT;
+		value->intValue = expr->intExpr;
+		return true;
+
+	case EXPR_TYPE_BOOL:
+		value->type = TYPE_BOOL;
+		value->boolValue = expr->boolExpr;
+		return true;
+	}
+
+	return false;
+}
+
+bool _Constant_unary(ExprType op, Constant* right, Constant* value)
+{
+	value->type = right->type;
+
+	switch (op)
+	{
+	case EXPR_TYPE_PLUS:
+		value->intValue = right->intValue;
+		return true;
+
+	case EXPR_TYPE_MINUS:
+		value->intValue = (int)(0u - (unsigned int)right->intValue);
+		return true;
+
+	case EXPR_TYPE_NEG:
+		value->intValue = ~right->intValue;
+		return true;
+
+	case EXPR_TYPE_NOT:
+		value->boolValue = !right->boolValue;
+		return true;
+	}
+
+	return false;
+}
+
+bool _Constant_binary(ExprType op, Constant* left, Constant* right, Constant* value)
+{
+	//int arithmetic wraps like the executor, operations with undefined result are not folded
+	unsigned int l = (unsigned int)left->intValue;
+	unsigned int r = (unsigned int)right->intValue;
+
+	value->type = TYPE_INT;
+
+	switch (op)
+	{
+	case EXPR_TYPE_ADD:
+		value->intValue = (int)(l + r);
+		return true;
+
+	case EXPR_TYPE_SUB:
+		value->intValue = (int)(l - r);
+		return true;
+
+	case EXPR_TYPE_MUL:
+		value->intValue = (int)(l * r);
+		return true;
+
+	case EXPR_TYPE_DIV:
+	case EXPR_TYPE_MOD:
+		if (right->intValue == 0 || (right->intValue == -1 && l == 0x80000000u))
+			return false;
+		value->intValue = op == EXPR_TYPE_DIV ? left->intValue / right->intValue : left->intValue % right->intValue;
+		return true;
+
+	case EXPR_TYPE_BITAND:
+		value->intValue = left->intValue & right->intValue;
+		return true;
+
+	case EXPR_TYPE_BITOR:
+		value->intValue = left->intValue | right->intValue;
+		return true;
+
+	case EXPR_TYPE_XOR:
+		value->intValue = left->intValue ^ right->intValue;
+		return true;
+
+	case EXPR_TYPE_LSHIFT:
+		if (r > 31)
+			return false;
+		value->intValue = (int)(l << r);
+		return true;
+
+	case EXPR_TYPE_RSHIFT:
+		if (r > 31)
+			return false;
+		value->intValue = left->intValue >> r;
+		return true;
+	}
+
+	value->type = TYPE_BOOL;
+
+	switch (op)
+	{
+	case EXPR_TYPE_EQ:
+		value->boolValue = left->type == TYPE_BOOL ? left->boolValue == right->boolValue : left->intValue == right->intValue;
+		return true;
+
+	case EXPR_TYPE_NE:
+		value->boolValue = left->type == TYPE_BOOL ? left->boolValue != right->boolValue : left->intValue != right->intValue;
+		return true;
+
+	case EXPR_TYPE_LT:
+		value->boolValue = left->intValue < right->intValue;
+		return true;
+
+	case EXPR_TYPE_LE:
+		value->boolValue = left->intValue <= right->intValue;
+		return true;
+
+	case EXPR_TYPE_GT:
+		value->boolValue = left->intValue > right->intValue;
+		return true;
+
+	case EXPR_TYPE_GE:
+		value->boolValue = left->intValue >= right->intValue;
+		return true;
+	}
+
+	return false;
+}
+
+void _Constant_store(Expression* expr, Constant* value)
+{
+	if (value->type == TYPE_BOOL)
+	{
+		expr->type = EXPR_TYPE_BOOL;
+		expr->boolExpr = value->boolValue;
+	}
+	else
+	{
+		expr->type = EXPR_TYPE_INT;
+		expr->intExpr = value->intValue;
+	}
+}
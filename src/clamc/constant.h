@@ -0,0 +1,25 @@
+#ifndef CLAM_CONSTANT_H
+#define CLAM_CONSTANT_H
+
+#include "ast.h"
+
+//compile time value of int/bool expression
+struct Constant
+{
+	TypeId type;
+	union
+	{
+		int intValue;
+		bool boolValue;
+	};
+};
+typedef struct Constant Constant;
+
+//evaluate whole expression tree, return false if not constant
+bool Constant_evaluate(Expression* expr, Constant* value);
+
+//fold expression whose operands are already literals into literal, call bottom up after type check
+//constant ternary and left side of '&&' '||' select the branch that would be evaluated
+bool Constant_fold(Expression* expr);
+
+#endif
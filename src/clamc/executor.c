@@ -3,24 +3,18 @@
 
 #include "executor.h"
 #include "message.h"
+#include "profile.h"
+#include "thread.h"
 
+//4 bytes like VM register, bool is 0 or 1, types are annotated by analyzer and never checked at runtime
 struct Value
 {
-	String name;
-	Type type;
-	int level;
-	union
-	{
-		int intValue;
-		bool boolValue;
-	};
+	int intValue;
 };
 typedef struct Value Value;
 
 static void Value_init(Value* v)
 {
-	String_init(&v->name);
-	Type_init(&v->type);
 	v->intValue = 0;
 }
 
@@ -31,118 +25,206 @@ enum ExecuteResult
 };
 typedef enum ExecuteResult ExecuteResult;
 
-static void _Executor_variant(Executor* exec, Declaration* decl);
-static void _Executor_function(Executor* exec, Declaration* decl, Vector args);
-static ExecuteResult _Executor_statement(Executor* exec, Declaration* decl, Statement* stat);
-static ExecuteResult _Executor_ifStatement(Executor* exec, Declaration* decl, Statement* stat);
-static void _Executor_assignStatement(Executor* exec, Statement* stat);
-static void _Executor_incDecStatement(Executor* exec, Statement* stat);
-static ExecuteResult _Executor_compoundStatement(Executor* exec, Declaration* decl,  Statement* stat);
-static void _Executor_expression(Executor* exec, Expression* expr);
-static void _Executor_conditionExpression(Executor* exec, Expression* expr);
-static void _Executor_callExpression(Executor* exec, Expression* expr);
-static void _Executor_unaryExpression(Executor* exec, Expression* expr);
-static void _Executor_binaryExpression(Executor* exec, Expression* expr);
-static void _Executor_logicExpression(Executor* exec, Expression* expr);
-static Value* _Executor_findVariant(Executor* exec, String name);
-static Declaration* _Executor_findFunction(Executor* exec, String name);
-static void _Executor_enterBlock(Executor* exec);
-static void _Executor_leaveBlock(Executor* exec);
-static Stack _Executor_enterFunction(Executor* exec, int argc);
-static void _Executor_leaveFunction(Executor* exec, Stack base);
+static void _Executor_variant(Executor* exec, const Declaration* decl, bool global);
+static void _Executor_function(Executor* exec, const Declaration* decl, const int* args, int count);
+static void _Executor_invoke(Executor* exec, const Declaration* decl, int base);
+static void _Executor_profile(Executor* exec, const Declaration* decl, int base);
+static ExecuteResult _Executor_statement(Executor* exec, const Declaration* decl, const Statement* stat);
+static ExecuteResult _Executor_ifStatement(Executor* exec, const Declaration* decl, const Statement* stat);
+static void _Executor_assignStatement(Executor* exec, const Statement* stat);
+static void _Executor_incDecStatement(Executor* exec, const Statement* stat);
+static ExecuteResult _Executor_compoundStatement(Executor* exec, const Declaration* decl,  const Statement* stat);
+static void _Executor_expression(Executor* exec, int index);
+static void _Executor_conditionExpression(Executor* exec, const FlatExpr* expr);
+static void _Executor_callExpression(Executor* exec, const FlatExpr* expr);
+static void _Executor_unaryExpression(Executor* exec, const FlatExpr* expr);
+static void _Executor_binaryExpression(Executor* exec, const FlatExpr* expr);
+static void _Executor_logicExpression(Executor* exec, const FlatExpr* expr);
+static Value* _Executor_getVariant(Executor* exec, int slot, bool global);
 
 void Executor_init(Executor* exec)
 {
 	Vector_init(&exec->global, sizeof(Value));
 	Stack_init(&exec->stack, sizeof(Value));
-	Stack_reserve(&exec->stack, 1 * 1024 * 1024);  //1M * sizeof(Value)
+	Stack_reserve(&exec->stack, 1024);
 	exec->module = 0;
-	exec->level = 0;
+	exec->exprs = NULL;
+	exec->args = NULL;
+	exec->base = 0;
+	exec->maxStack = EXECUTOR_MAX_STACK;
+	exec->stackLimit = 0;
+	exec->profile = NULL;
 }
 
 void Executor_destroy(Executor* exec)
 {
+	Vector_destroy(&exec->global);
 	Stack_destroy(&exec->stack);
 }
 
-void Executor_run(Executor* exec, Module* module)
+void Executor_run(Executor* exec, const Module* module)
 {
-	exec->module = module;
-	Vector_resize(&exec->stack, 0);
+	int ret = Executor_execute(exec, module);
 
-	//global variants
-	for (int i = 0; i < module->declarations.size; i++)
-	{
-		Declaration* decl = (Declaration*)Vector_get(&module->declarations, i);
-		if (decl->type == DECL_TYPE_VARIANT)
-			_Executor_variant(exec, decl);
-	}
+	//output main return
+	printf("main return %d\n", ret);
+}
+
+int Executor_execute(Executor* exec, const Module* module)
+{
+	Executor_load(exec, module);
 
 	//find main
 	String main = String_literal("main");
-	Declaration* decl = _Executor_findFunction(exec, main);
+	const Declaration* decl = Module_findFunction(module, main);
 	if (!decl)
 		error(NULL, "function 'main' not found");
 
 	//call main
-	Vector args;
-	Vector_init(&args, 0);  //TODO: add main argument
-	_Executor_function(exec, decl, args);
+	_Executor_function(exec, decl, NULL, 0);  //analyzer allows no parameters
 
-	//output main return
 	Value* ret = Stack_top(&exec->stack);
-	printf("main return %d\n", ret->intValue);
+	return ret->intValue;
 }
 
-void _Executor_variant(Executor* exec, Declaration* decl)
+void Executor_load(Executor* exec, const Module* module)
 {
-	_Executor_expression(exec, decl->variant.initExpr);
-	Value* exprValue = Stack_top(&exec->stack);
-	exprValue->name = decl->variant.name;
-	exprValue->level = exec->level;
+	//native stack is measured from top level entry
+	exec->stackLimit = Thread_stackLimit(EXECUTOR_MAX_NATIVE);
+
+	exec->module = module;
+	exec->exprs = module->flat.exprs.data;
+	exec->args = module->flat.args.data;
+	exec->base = 0;
+	Vector_resize(&exec->stack, 0);
+
+	//global variants, zero before init (init expression may call function reads later variant)
+	int globalCount = 0;
+	for (int i = 0; i < module->declarations.size; i++)
+	{
+		const Declaration* decl = Vector_get(&module->declarations, i);
+		if (decl->type == DECL_TYPE_VARIANT)
+			globalCount++;
+	}
 
-	if (exec->level == 0)
-		Vector_add(&exec->global, Stack_pop(&exec->stack));
+	Vector_resize(&exec->global, globalCount);
+	if (globalCount)
+		memset(exec->global.data, 0, globalCount * sizeof(Value));
+
+	for (int i = 0; i < module->declarations.size; i++)
+	{
+		const Declaration* decl = Vector_get(&module->declarations, i);
+		if (decl->type == DECL_TYPE_VARIANT)
+			_Executor_variant(exec, decl, true);
+	}
 }
 
-void _Executor_function(Executor* exec, Declaration* decl, Vector args)
+int Executor_call(Executor* exec, const Declaration* decl, const int* args, int count)
 {
-	//push arguments
-	for (int i = args.size - 1; i >= 0; --i)  //right to left
+	exec->stackLimit = Thread_stackLimit(EXECUTOR_MAX_NATIVE);
+
+	exec->base = 0;
+	Vector_resize(&exec->stack, 0);
+
+	//caller passes bool arguments as 0 or 1
+	for (int i = 0; i < count; ++i)
 	{
-		Parameter* param = Vector_get(&decl->function.parameters, i);
-		Expression* arg = Vector_get(&args, i);
-		_Executor_expression(exec, arg);
-		Value* v = Stack_top(&exec->stack);
-		v->name = param->name;
+		Value value;
+		value.intValue = args[i];
+		Stack_push(&exec->stack, &value);
 	}
 
-	Stack base = _Executor_enterFunction(exec, args.size);
+	if (exec->profile)
+		_Executor_profile(exec, decl, 0);
+	else
+		_Executor_invoke(exec, decl, 0);
+
+	if (decl->function.resType.id == TYPE_VOID)
+		return 0;
+	return ((Value*)Stack_top(&exec->stack))->intValue;
+}
+
+void _Executor_variant(Executor* exec, const Declaration* decl, bool global)
+{
+	Value value;
+	if (decl->variant.initExpr)
+	{
+		_Executor_expression(exec, decl->variant.initExpr->flat);
+		value = *(Value*)Stack_pop(&exec->stack);
+	}
+	else
+		Value_init(&value);
+
+	if (global)
+		*(Value*)Vector_get(&exec->global, decl->variant.slot) = value;
+	else
+		*(Value*)Vector_get(&exec->stack, exec->base + decl->variant.slot) = value;
+}
+
+void _Executor_function(Executor* exec, const Declaration* decl, const int* args, int count)
+{
+	int base = exec->stack.size;
+
+	//arguments are evaluated left to right, become the first slots of callee frame
+	for (int i = 0; i < count; ++i)
+		_Executor_expression(exec, args[i]);
+
+	if (exec->profile)
+		_Executor_profile(exec, decl, base);
+	else
+		_Executor_invoke(exec, decl, base);
+}
+
+void _Executor_invoke(Executor* exec, const Declaration* decl, int base)
+{
+	const FuncDecl* func = &decl->function;
+	char marker;
+
+	if (base + func->frameSize > exec->maxStack || (uintptr_t)&marker < exec->stackLimit)
+		error(&decl->location, "stack overflow, call function '" String_FMT "'", String_arg(func->name));
+
+	Vector_resize(&exec->stack, base + func->frameSize);
+
+	int lastBase = exec->base;
+	exec->base = base;
 
 	ExecuteResult result = EXEC_RESULT_NORMAL;
-	FuncDecl* func = &decl->function;
 
 	for (int i = 0; i < func->block.size; i++)
 	{
-		Statement* stat = (Statement*)Vector_get(&func->block, i);
+		const Statement* stat = Vector_get(&func->block, i);
 		result = _Executor_statement(exec, decl, stat);
 		if (result == EXEC_RESULT_RETURN)
 			break;
 	}
 
-	Value* ret = Stack_top(&exec->stack);
+	Value ret;
+	if (func->resType.id != TYPE_VOID)
+		ret = *(Value*)Stack_top(&exec->stack);  //return statement left value on top
 
-	_Executor_leaveFunction(exec, base);
+	exec->base = lastBase;
+	Vector_resize(&exec->stack, base);
 
 	//return value
-	if (decl->function.resType.id != TYPE_VOID)
-		Stack_push(&exec->stack, ret);
+	if (func->resType.id != TYPE_VOID)
+		Stack_push(&exec->stack, &ret);
+}
+
+//kept out of _Executor_invoke so the unprofiled call path stays lean
+void _Executor_profile(Executor* exec, const Declaration* decl, int base)
+{
+	Profile_enter(exec->profile, (int)(decl - (const Declaration*)exec->module->functions.data));
+	_Executor_invoke(exec, decl, base);
+	Profile_exit(exec->profile);
 }
 
-ExecuteResult _Executor_statement(Executor* exec, Declaration* decl, Statement* stat)
+ExecuteResult _Executor_statement(Executor* exec, const Declaration* decl, const Statement* stat)
 {
 	ExecuteResult result = EXEC_RESULT_NORMAL;
-	FuncDecl* func = &decl->function;
+	const FuncDecl* func = &decl->function;
+
+	if (exec->profile)
+		Profile_statement(exec->profile, stat);
 
 	switch (stat->type)
 	{
@@ -151,7 +233,7 @@ ExecuteResult _Executor_statement(Executor* exec, Declaration* decl, Statement*
 		break;
 		
 	case STATEMENT_TYPE_DECLARATION:
-		_Executor_variant(exec, &stat->declaration);
+		_Executor_variant(exec, &stat->declaration, false);
 		break;
 
 	case STATEMENT_TYPE_IF:
@@ -178,23 +260,23 @@ ExecuteResult _Executor_statement(Executor* exec, Declaration* decl, Statement*
 		break;
 
 	case STATEMENT_TYPE_EXPRESSION:
-		_Executor_expression(exec, stat->expr);
+		_Executor_expression(exec, stat->expr->flat);
 		break;
 
 	case STATEMENT_TYPE_RETURN:
 		if (stat->returnExpr)
-			_Executor_expression(exec, stat->returnExpr);  //eval expr
+			_Executor_expression(exec, stat->returnExpr->flat);  //eval expr
 		return EXEC_RESULT_RETURN;
 	}
 
 	return result;
 }
 
-ExecuteResult _Executor_ifStatement(Executor* exec, Declaration* decl, Statement* stat)
+ExecuteResult _Executor_ifStatement(Executor* exec, const Declaration* decl, const Statement* stat)
 {
-	_Executor_expression(exec, stat->ifStat.condition);
+	_Executor_expression(exec, stat->ifStat.condition->flat);
 	Value* cond = Stack_pop(&exec->stack);
-	if (cond->boolValue)
+	if (cond->intValue)
 		return _Executor_statement(exec, decl, stat->ifStat.statement);
 	else if (stat->ifStat.elseStat)
 		return _Executor_statement(exec, decl, stat->ifStat.elseStat);
@@ -202,179 +284,112 @@ ExecuteResult _Executor_ifStatement(Executor* exec, Declaration* decl, Statement
 	return EXEC_RESULT_NORMAL;
 }
 
-void _Executor_assignStatement(Executor* exec, Statement* stat)
+void _Executor_assignStatement(Executor* exec, const Statement* stat)
 {
-	//find lvalue variant
-	Value* lvalue = _Executor_findVariant(exec, stat->assign.leftExpr->identExpr);  //TODO: process expression first
-
 	//eval rvalue
-	_Executor_expression(exec, stat->assign.rightExpr);
+	_Executor_expression(exec, stat->assign.rightExpr->flat);
 	Value* rvalue = Stack_pop(&exec->stack);
 
-	//assign
+	//find lvalue variant, after rvalue because the stack may be moved by growing
+	const IdentExpression* ident = &stat->assign.leftExpr->identExpr;  //TODO: process expression first
+	Value* lvalue = _Executor_getVariant(exec, ident->slot, ident->global);
+
+	//assign, analyzer allows compound assignment on int only
 	switch (stat->type)
 	{
 	case STATEMENT_TYPE_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue = rvalue->intValue;
-			break;
-
-		case TYPE_BOOL:
-			lvalue->boolValue = rvalue->boolValue;
-			break;
-		}
+		lvalue->intValue = rvalue->intValue;
 		break;
 
 	case STATEMENT_TYPE_ADD_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue += rvalue->intValue;
-			break;
-		}
+		lvalue->intValue += rvalue->intValue;
 		break;
 
 	case STATEMENT_TYPE_SUB_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue -= rvalue->intValue;
-			break;
-		}
+		lvalue->intValue -= rvalue->intValue;
 		break;
 
 	case STATEMENT_TYPE_MUL_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue *= rvalue->intValue;
-			break;
-		}
+		lvalue->intValue *= rvalue->intValue;
 		break;
 
 	case STATEMENT_TYPE_DIV_ASSIGN:
 	case STATEMENT_TYPE_MOD_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			if (rvalue->intValue == 0)
-				error(&stat->assign.rightExpr->location, "right value is zero, division by zero");
-
-			if (stat->type == STATEMENT_TYPE_DIV_ASSIGN)
-				lvalue->intValue /= rvalue->intValue;
-			else
-				lvalue->intValue %= rvalue->intValue;
+		if (rvalue->intValue == 0)
+			error(&stat->assign.rightExpr->location, "right value is zero, division by zero");
 
-			break;
-		}
+		if (stat->type == STATEMENT_TYPE_DIV_ASSIGN)
+			lvalue->intValue /= rvalue->intValue;
+		else
+			lvalue->intValue %= rvalue->intValue;
 		break;
 
 	case STATEMENT_TYPE_BITAND_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue &= rvalue->intValue;
-			break;
-		}
+		lvalue->intValue &= rvalue->intValue;
 		break;
 
 	case STATEMENT_TYPE_BITOR_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue |= rvalue->intValue;
-			break;
-		}
+		lvalue->intValue |= rvalue->intValue;
 		break;
 
 	case STATEMENT_TYPE_XOR_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue ^= rvalue->intValue;
-			break;
-		}
+		lvalue->intValue ^= rvalue->intValue;
 		break;
 
 	case STATEMENT_TYPE_LSHIFT_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue <<= rvalue->intValue;
-			break;
-		}
+		lvalue->intValue <<= rvalue->intValue;
 		break;
-	
+
 	case STATEMENT_TYPE_RSHIFT_ASSIGN:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue >>= rvalue->intValue;
-			break;
-		}
+		lvalue->intValue >>= rvalue->intValue;
 		break;
-
 	}
 }
 
-void _Executor_incDecStatement(Executor* exec, Statement* stat)
+void _Executor_incDecStatement(Executor* exec, const Statement* stat)
 {
 	//find lvalue variant
-	Value* lvalue = _Executor_findVariant(exec, stat->incExpr->identExpr);  //TODO: process expression first
+	const IdentExpression* ident = &stat->incExpr->identExpr;  //TODO: process expression first
+	Value* lvalue = _Executor_getVariant(exec, ident->slot, ident->global);
 
-	//eval
+	//eval, int only
 	if (stat->type == STATEMENT_TYPE_INC)
-		lvalue->intValue++;  //TODO: more type
+		lvalue->intValue++;
 	else
 		lvalue->intValue--;
 }
 
-ExecuteResult _Executor_compoundStatement(Executor* exec, Declaration* decl, Statement* stat)
+ExecuteResult _Executor_compoundStatement(Executor* exec, const Declaration* decl, const Statement* stat)
 {
-	_Executor_enterBlock(exec);
-
 	ExecuteResult result = EXEC_RESULT_NORMAL;
 
 	for (int i = 0; i < stat->compound.size; i++)
 	{
-		Statement* subStat = (Statement*)Vector_get(&stat->compound, i);
+		const Statement* subStat = Vector_get(&stat->compound, i);
 		result = _Executor_statement(exec, decl, subStat);
 		if (result == EXEC_RESULT_RETURN)
 			break;
 	}
 
-	_Executor_leaveBlock(exec);
 	return result;
 }
 
-void _Executor_expression(Executor* exec, Expression* expr)
+void _Executor_expression(Executor* exec, int index)
 {
 	//TODO: add more expressions
+	const FlatExpr* expr = exec->exprs + index;
 	Value value;
 
 	switch (expr->type)
 	{
 	case EXPR_TYPE_IDENT:
-		value = *_Executor_findVariant(exec, expr->identExpr);  //copy
-		value.level = exec->level;
+		value = *_Executor_getVariant(exec, expr->ident.slot, expr->ident.global);  //copy
 		Stack_push(&exec->stack, &value);
 		break;
 
 	case EXPR_TYPE_INT:
-		Value_init(&value);
-		value.type = intType;
-		value.intValue = expr->intExpr;
-		value.level = exec->level;
-		Stack_push(&exec->stack, &value);
-		break;
-
 	case EXPR_TYPE_BOOL:
-		Value_init(&value);
-		value.type = boolType;
-		value.boolValue = expr->boolExpr;
-		value.level = exec->level;
+		value.intValue = expr->value;
 		Stack_push(&exec->stack, &value);
 		break;
 
@@ -419,381 +434,155 @@ void _Executor_expression(Executor* exec, Expression* expr)
 	}
 }
 
-void _Executor_conditionExpression(Executor* exec, Expression* expr)
+void _Executor_conditionExpression(Executor* exec, const FlatExpr* expr)
 {
-	_Executor_expression(exec, expr->condExpr.expr1);
-	Value* cond = Stack_top(&exec->stack);
-
-	_Executor_expression(exec, expr->condExpr.expr2);
-	Value* v1 = Stack_top(&exec->stack);
-
-	if (cond->boolValue)  //short cut
-	{
-		switch (v1->type.id)
-		{
-		case TYPE_INT:
-			cond->intValue = v1->intValue;
-			break;
-		}
-
-		cond->type = v1->type;
-		Stack_pop(&exec->stack);
-		return;
-	}
-
-	_Executor_expression(exec, expr->condExpr.expr3);
-	Value* v2 = Stack_top(&exec->stack);
-
-	switch (v1->type.id)
-	{
-	case TYPE_INT:
-		cond->intValue = v2->intValue;
-		break;
-	}
+	_Executor_expression(exec, expr->cond.expr1);
+	Value* cond = Stack_pop(&exec->stack);
 
-	cond->type = v1->type;
-	Stack_pop(&exec->stack);
-	Stack_pop(&exec->stack);
+	//only selected branch is evaluated, its value replaces condition
+	_Executor_expression(exec, cond->intValue ? expr->cond.expr2 : expr->cond.expr3);
 }
 
-void _Executor_callExpression(Executor* exec, Expression* expr)
+void _Executor_callExpression(Executor* exec, const FlatExpr* expr)
 {
-	//find function
-	Declaration* decl = _Executor_findFunction(exec, expr->callExpr.func->identExpr);
-
-	//call function
-	_Executor_function(exec, decl, expr->callExpr.args);
+	//call function, resolved by analyzer
+	const Declaration* decl = Vector_get(&exec->module->functions, expr->call.function);
+	_Executor_function(exec, decl, exec->args + expr->call.args, expr->call.count);
 }
 
-void _Executor_unaryExpression(Executor* exec, Expression* expr)
+void _Executor_unaryExpression(Executor* exec, const FlatExpr* expr)
 {
-	_Executor_expression(exec, expr->unaryExpr);
+	_Executor_expression(exec, expr->unary);
 	Value* value = Stack_top(&exec->stack);
 
 	switch (expr->type)
 	{
 	case EXPR_TYPE_PLUS:
-		switch (value->type.id)
-		{
-		case TYPE_INT:
-			value->intValue = +value->intValue;
-			break;
-		}
 		break;
 
 	case EXPR_TYPE_MINUS:
-		switch (value->type.id)
-		{
-		case TYPE_INT:
-			value->intValue = -value->intValue;
-			break;
-		}
+		value->intValue = -value->intValue;
 		break;
 
 	case EXPR_TYPE_NEG:
-		switch (value->type.id)
-		{
-		case TYPE_INT:
-			value->intValue = ~value->intValue;
-			break;
-		}
+		value->intValue = ~value->intValue;
 		break;
 
 	case EXPR_TYPE_NOT:
-		value->boolValue = !value->boolValue;
+		value->intValue = !value->intValue;
 		break;
 	}
 }
 
-void _Executor_binaryExpression(Executor* exec, Expression* expr)
+//operand types are checked by analyzer, int and bool compare the same way
+void _Executor_binaryExpression(Executor* exec, const FlatExpr* expr)
 {
-	_Executor_expression(exec, expr->binaryExpr.leftExpr);
-	Value* lvalue = Stack_top(&exec->stack);
+	_Executor_expression(exec, expr->binary.left);
+	_Executor_expression(exec, expr->binary.right);
 
-	_Executor_expression(exec, expr->binaryExpr.rightExpr);
 	Value* rvalue = Stack_pop(&exec->stack);
+	Value* lvalue = Stack_top(&exec->stack);  //stack may be moved by right expression
 
 	switch (expr->type)
 	{
 	case EXPR_TYPE_ADD:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue += rvalue->intValue;
-			break;
-		}
+		lvalue->intValue += rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_SUB:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue -= rvalue->intValue;
-			break;
-		}
+		lvalue->intValue -= rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_MUL:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			lvalue->intValue *= rvalue->intValue;
-			break;
-		}
+		lvalue->intValue *= rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_DIV:
 	case EXPR_TYPE_MOD:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			if (rvalue->intValue == 0)
-				error(&expr->binaryExpr.rightExpr->location, "right value is zero, division by zero");
-
-			if (expr->type == EXPR_TYPE_DIV)
-				lvalue->intValue /= rvalue->intValue;
-			else
-				lvalue->intValue %= rvalue->intValue;
-			break;
-		}
+		if (rvalue->intValue == 0)
+			error(Vector_get(&exec->module->flat.locations, expr->binary.right), "right value is zero, division by zero");
+
+		if (expr->type == EXPR_TYPE_DIV)
+			lvalue->intValue /= rvalue->intValue;
+		else
+			lvalue->intValue %= rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_NE:
-	case EXPR_TYPE_EQ:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			switch (rvalue->type.id)
-			{
-			case TYPE_INT:
-				if (expr->type == EXPR_TYPE_NE)
-					lvalue->boolValue = lvalue->intValue != rvalue->intValue;
-				else
-					lvalue->boolValue = lvalue->intValue == rvalue->intValue;
-				break;
-			}
-			break;
-
-		case TYPE_BOOL:
-			if (expr->type == EXPR_TYPE_NE)
-				lvalue->boolValue = lvalue->boolValue != rvalue->boolValue;
-			else
-				lvalue->boolValue = lvalue->boolValue == rvalue->boolValue;
-
-			break;
-		}
+		lvalue->intValue = lvalue->intValue != rvalue->intValue;
+		break;
 
-		lvalue->type = boolType;
+	case EXPR_TYPE_EQ:
+		lvalue->intValue = lvalue->intValue == rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_LT:
-	case EXPR_TYPE_LE:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			switch (rvalue->type.id)
-			{
-			case TYPE_INT:
-				if (expr->type == EXPR_TYPE_LT)
-					lvalue->boolValue = lvalue->intValue <  rvalue->intValue;
-				else
-					lvalue->boolValue = lvalue->intValue <= rvalue->intValue;
-
-				break;
-			}
-			break;
-		}
+		lvalue->intValue = lvalue->intValue < rvalue->intValue;
+		break;
 
-		lvalue->type = boolType;
+	case EXPR_TYPE_LE:
+		lvalue->intValue = lvalue->intValue <= rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_GT:
-	case EXPR_TYPE_GE:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			switch (rvalue->type.id)
-			{
-			case TYPE_INT:
-				if (expr->type == EXPR_TYPE_GT)
-					lvalue->boolValue = lvalue->intValue > rvalue->intValue;
-				else
-					lvalue->boolValue = lvalue->intValue >= rvalue->intValue;
-
-				break;
-			}
-			break;
-		}
+		lvalue->intValue = lvalue->intValue > rvalue->intValue;
+		break;
 
-		lvalue->type = boolType;
+	case EXPR_TYPE_GE:
+		lvalue->intValue = lvalue->intValue >= rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_BITAND:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			switch (rvalue->type.id)
-			{
-			case TYPE_INT:
-				lvalue->intValue = lvalue->intValue & rvalue->intValue;
-				break;
-			}
-			break;
-		}
+		lvalue->intValue &= rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_BITOR:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			switch (rvalue->type.id)
-			{
-			case TYPE_INT:
-				lvalue->intValue = lvalue->intValue | rvalue->intValue;
-				break;
-			}
-			break;
-		}
+		lvalue->intValue |= rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_XOR:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			switch (rvalue->type.id)
-			{
-			case TYPE_INT:
-				lvalue->intValue = lvalue->intValue ^ rvalue->intValue;
-				break;
-			}
-			break;
-		}
+		lvalue->intValue ^= rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_LSHIFT:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			switch (rvalue->type.id)
-			{
-			case TYPE_INT:
-				lvalue->intValue = lvalue->intValue << rvalue->intValue;
-				break;
-			}
-			break;
-		}
+		lvalue->intValue <<= rvalue->intValue;
 		break;
 
 	case EXPR_TYPE_RSHIFT:
-		switch (lvalue->type.id)
-		{
-		case TYPE_INT:
-			switch (rvalue->type.id)
-			{
-			case TYPE_INT:
-				lvalue->intValue = lvalue->intValue >> rvalue->intValue;
-				break;
-			}
-			break;
-		}
+		lvalue->intValue >>= rvalue->intValue;
 		break;
-
 	}
 }
 
-void _Executor_logicExpression(Executor* exec, Expression* expr)
+void _Executor_logicExpression(Executor* exec, const FlatExpr* expr)
 {
-	_Executor_expression(exec, expr->binaryExpr.leftExpr);
+	_Executor_expression(exec, expr->binary.left);
 	Value* lvalue = Stack_top(&exec->stack);
 
 	switch (expr->type)  //short cut eval
 	{
 	case EXPR_TYPE_AND:
-		if (!lvalue->boolValue)
+		if (!lvalue->intValue)
 			return;
 		break;
 
 	case EXPR_TYPE_OR:
-		if (lvalue->boolValue)
+		if (lvalue->intValue)
 			return;
 		break;
 	}
 
-	_Executor_expression(exec, expr->binaryExpr.rightExpr);
+	//left value did not decide the result, right value is the result
+	_Executor_expression(exec, expr->binary.right);
 	Value* rvalue = Stack_pop(&exec->stack);
-
-	switch (expr->type)
-	{
-	case EXPR_TYPE_AND:
-		lvalue->boolValue = lvalue->boolValue && rvalue->boolValue;
-		break;
-
-	case EXPR_TYPE_OR:
-		lvalue->boolValue = lvalue->boolValue || rvalue->boolValue;
-		break;
-	}
+	lvalue = Stack_top(&exec->stack);  //stack may be moved by right expression
+	*lvalue = *rvalue;
 }
 
-Value* _Executor_findVariant(Executor* exec, String name)
+Value* _Executor_getVariant(Executor* exec, int slot, bool global)
 {
-	for (int i = exec->stack.size - 1; i >= 0; --i)  //reverse (local first)
-	{
-		Value* value = Vector_get(&exec->stack, i);
-		if (value->level <= exec->level && String_equalsString(value->name, name))
-			return value;
-	}
-
-	for (int i = 0; i < exec->global.size; ++i)  //global second
-	{
-		Value* value = Vector_get(&exec->global, i);
-		if (String_equalsString(value->name, name))
-			return value;
-	}
+	if (global)
+		return Vector_get(&exec->global, slot);
 
-	return NULL;
-}
-
-Declaration* _Executor_findFunction(Executor* exec, String name)
-{
-	for (int i = 0; i < exec->module->functions.size; i++)
-	{
-		Declaration* decl = (Declaration*)Vector_get(&exec->module->functions, i);
-		if (String_equalsString(name, decl->function.name))
-		{
-			//found function
-			return decl;
-		}
-	}
-	return NULL;
-}
-
-void _Executor_enterBlock(Executor* exec)
-{
-	exec->level++;
-}
-
-void _Executor_leaveBlock(Executor* exec)
-{
-	exec->level--;
-}
-
-Stack _Executor_enterFunction(Executor* exec, int argc)
-{
-	exec->level++;
-	Stack base = exec->stack;  //save stack
-
-	//adjust stack
-	int diff = exec->stack.size - argc;
-	int offset = diff * exec->stack.elemSize;
-	exec->stack.data = (char*)exec->stack.data + offset;
-	exec->stack.size = argc;
-	exec->stack.cap -= diff;
-
-	return base;
-}
-
-void _Executor_leaveFunction(Executor* exec, Stack base)
-{
-	exec->stack = base;  //restore stack
-	exec->level--;
+	return Vector_get(&exec->stack, exec->base + slot);  //slot resolved by analyzer
 }
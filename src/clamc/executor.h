@@ -1,22 +1,42 @@
 #ifndef CLAM_EXECUTOR_H
 #define CLAM_EXECUTOR_H
 
+#include <stdint.h>
+
 #include "module.h"
 
 #include "vector.h"
 #include "stack.h"
 
+struct Profile;
+
+#define EXECUTOR_MAX_STACK (1 * 1024 * 1024)  //1M * sizeof(Value)
+#define EXECUTOR_MAX_NATIVE (4 * 1024 * 1024)  //bytes of native stack used by nested calls, less if thread stack is smaller
+
+//all run state is owned by executor, module is only read, so one analyzed module
+//can be run by executors on different threads at the same time
 struct Executor
 {
-	Vector global;  //Vector<Value>
-	Stack stack;    //Stack<Value>
-	Module* module;
-	int level;
+	Vector global;  //Vector<Value>, indexed by global slot
+	Stack stack;    //Stack<Value>, function frames and temporary values, grows on demand
+	const Module* module;
+	const FlatExpr* exprs;  //module->flat.exprs, expressions are walked by index
+	const int* args;        //module->flat.args
+	int base;       //frame base of current function
+	int maxStack;   //stack overflow above it
+	uintptr_t stackLimit;  //native stack overflow below it, calls recurse in C
+	struct Profile* profile;  //NULL if not profiling
 };
 typedef struct Executor Executor;
 
 void Executor_init(Executor* exec);
 void Executor_destroy(Executor* exec);
-void Executor_run(Executor* exec, Module* module);
+void Executor_run(Executor* exec, const Module* module);
+//run global initializers and main, returns main result without output
+int Executor_execute(Executor* exec, const Module* module);
+//zero globals and run their initializers, then functions can be called
+void Executor_load(Executor* exec, const Module* module);
+//call function of loaded module with arguments in its first slots, returns its result
+int Executor_call(Executor* exec, const Declaration* decl, const int* args, int count);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,157 @@
+#include <string.h>
+
+#include "flat.h"
+#include "module.h"
+
+static void _FlatCode_statement(FlatCode* code, Module* module, Statement* stat);
+static void _FlatCode_declaration(FlatCode* code, Module* module, Declaration* decl);
+static int _FlatCode_expression(FlatCode* code, Module* module, Expression* expr);
+
+void FlatCode_init(FlatCode* code)
+{
+	Vector_init(&code->exprs, sizeof(FlatExpr));
+	Vector_init(&code->locations, sizeof(SourceLocation));
+	Vector_init(&code->args, sizeof(int));
+}
+
+void FlatCode_destroy(FlatCode* code)
+{
+	Vector_destroy(&code->exprs);
+	Vector_destroy(&code->locations);
+	Vector_destroy(&code->args);
+}
+
+void FlatCode_build(FlatCode* code, Module* module)
+{
+	Vector_resize(&code->exprs, 0);
+	Vector_resize(&code->locations, 0);
+	Vector_resize(&code->args, 0);
+
+	for (int i = 0; i < module->declarations.size; ++i)
+		_FlatCode_declaration(code, module, Vector_get(&module->declarations, i));
+}
+
+void _FlatCode_declaration(FlatCode* code, Module* module, Declaration* decl)
+{
+	switch (decl->type)
+	{
+	case DECL_TYPE_FUNCTION:
+		for (int i = 0; i < decl->function.block.size; ++i)
+			_FlatCode_statement(code, module, Vector_get(&decl->function.block, i));
+		break;
+
+	case DECL_TYPE_VARIANT:
+		if (decl->variant.initExpr)
+			_FlatCode_expression(code, module, decl->variant.initExpr);
+		break;
+	}
+}
+
+//target of assignment and increment is read from tree, only evaluated expressions are flattened
+void _FlatCode_statement(FlatCode* code, Module* module, Statement* stat)
+{
+	switch (stat->type)
+	{
+	case STATEMENT_TYPE_DECLARATION:
+		_FlatCode_declaration(code, module, &stat->declaration);
+		break;
+
+	case STATEMENT_TYPE_ASSIGN:
+	case STATEMENT_TYPE_ADD_ASSIGN:
+	case STATEMENT_TYPE_SUB_ASSIGN:
+	case STATEMENT_TYPE_MUL_ASSIGN:
+	case STATEMENT_TYPE_DIV_ASSIGN:
+	case STATEMENT_TYPE_MOD_ASSIGN:
+	case STATEMENT_TYPE_BITAND_ASSIGN:
+	case STATEMENT_TYPE_BITOR_ASSIGN:
+	case STATEMENT_TYPE_XOR_ASSIGN:
+	case STATEMENT_TYPE_LSHIFT_ASSIGN:
+	case STATEMENT_TYPE_RSHIFT_ASSIGN:
+		_FlatCode_expression(code, module, stat->assign.rightExpr);
+		break;
+
+	case STATEMENT_TYPE_IF:
+		_FlatCode_expression(code, module, stat->ifStat.condition);
+		_FlatCode_statement(code, module, stat->ifStat.statement);
+		if (stat->ifStat.elseStat)
+			_FlatCode_statement(code, module, stat->ifStat.elseStat);
+		break;
+
+	case STATEMENT_TYPE_RETURN:
+		if (stat->returnExpr)
+			_FlatCode_expression(code, module, stat->returnExpr);
+		break;
+
+	case STATEMENT_TYPE_EXPRESSION:
+		_FlatCode_expression(code, module, stat->expr);
+		break;
+
+	case STATEMENT_TYPE_COMPOUND:
+		for (int i = 0; i < stat->compound.size; ++i)
+			_FlatCode_statement(code, module, Vector_get(&stat->compound, i));
+		break;
+	}
+}
+
+int _FlatCode_expression(FlatCode* code, Module* module, Expression* expr)
+{
+	FlatExpr node;
+	memset(&node, 0, sizeof(node));
+	node.type = expr->type;
+
+	//parent before children, node is stored after children got their indices
+	int index = code->exprs.size;
+	Vector_add(&code->exprs, &node);
+	Vector_add(&code->locations, &expr->location);
+	expr->flat = index;
+
+	switch (expr->type)
+	{
+	case EXPR_TYPE_INT:
+		node.value = expr->intExpr;
+		break;
+
+	case EXPR_TYPE_BOOL:
+		node.value = expr->boolExpr;
+		break;
+
+	case EXPR_TYPE_CALL:
+		node.call.function = (int)(expr->callExpr.decl - (Declaration*)module->functions.data);
+		node.call.args = code->args.size;
+		node.call.count = expr->callExpr.args.size;
+
+		Vector_resize(&code->args, node.call.args + node.call.count);
+		for (int i = 0; i < node.call.count; ++i)
+		{
+			int arg = _FlatCode_expression(code, module, Vector_get(&expr->callExpr.args, i));
+			*(int*)Vector_get(&code->args, node.call.args + i) = arg;
+		}
+		break;
+
+	case EXPR_TYPE_IDENT:
+		node.ident.slot = expr->identExpr.slot;
+		node.ident.global = expr->identExpr.global;
+		break;
+
+	case EXPR_TYPE_PLUS:
+	case EXPR_TYPE_MINUS:
+	case EXPR_TYPE_NOT:
+	case EXPR_TYPE_NEG:
+		node.unary = _FlatCode_expression(code, module, expr->unaryExpr);
+		break;
+
+	case EXPR_TYPE_COND:
+		node.cond.expr1 = _FlatCode_expression(code, module, expr->condExpr.expr1);
+		node.cond.expr2 = _FlatCode_expression(code, module, expr->condExpr.expr2);
+		node.cond.expr3 = _FlatCode_expression(code, module, expr->condExpr.expr3);
+		break;
+
+	default:  //binary
+		node.binary.left = _FlatCode_expression(code, module, expr->binaryExpr.leftExpr);
+		node.binary.right = _FlatCode_expression(code, module, expr->binaryExpr.rightExpr);
+		break;
+	}
+
+	*(FlatExpr*)Vector_get(&code->exprs, index) = node;
+	return index;
+}
@@ -0,0 +1,59 @@
+#ifndef CLAM_FLAT_H
+#define CLAM_FLAT_H
+
+#include "ast.h"
+#include "vector.h"
+
+struct Module;
+
+//16 bytes, children are indices of FlatCode.exprs
+struct FlatExpr
+{
+	ExprType type;
+	union
+	{
+		int value;  //int, bool
+		struct
+		{
+			int slot;
+			int global;
+		} ident;
+		struct
+		{
+			int function;  //index of module->functions
+			int args;      //first index of FlatCode.args
+			int count;
+		} call;
+		int unary;
+		struct
+		{
+			int left;
+			int right;
+		} binary;
+		struct
+		{
+			int expr1;
+			int expr2;
+			int expr3;
+		} cond;
+	};
+};
+typedef struct FlatExpr FlatExpr;
+
+//analyzed expressions of module in preorder, nodes of a function are adjacent
+//Expression.flat of tree node is its index, locations are kept out of hot nodes
+struct FlatCode
+{
+	Vector exprs;      //Vector<FlatExpr>
+	Vector locations;  //Vector<SourceLocation>, same index as exprs
+	Vector args;       //Vector<int>, arguments of calls
+};
+typedef struct FlatCode FlatCode;
+
+void FlatCode_init(FlatCode* code);
+void FlatCode_destroy(FlatCode* code);
+
+//rebuild module->flat, call after analyzing, tree is not changed except Expression.flat
+void FlatCode_build(FlatCode* code, struct Module* module);
+
+#endif
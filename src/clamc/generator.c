@@ -1,13 +1,16 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 #include "generator.h"
 #include "message.h"
+#include "constant.h"
+#include "x64.h"
 
 static void _Generator_variant(Generator* gen, Declaration* decl);
 static void _Generator_function(Generator* gen, Declaration* decl);
-static void _Generator_parameterList(Generator* gen, Vector params, StringBuffer* buf);
+static void _Generator_parameterList(Generator* gen, Vector params, Rope* buf);
 static void _Generator_statement(Generator* gen, Declaration* decl, Statement* stat);
 static void _Generator_ifStatement(Generator* gen, Declaration* decl, Statement* stat);
 static void _Generator_assignStatement(Generator* gen, Statement* stat);
@@ -15,42 +18,54 @@ static void _Generator_incDecStatement(Generator* gen, Statement* stat);
 static void _Generator_compoundStatement(Generator* gen, Declaration* decl, Vector block);
 static void _Generator_expressionStatement(Generator* gen, Expression* expr);
 static void _Generator_returnStatement(Generator* gen, Statement* stat);
-static void _Generator_expression(Generator* gen, Expression* expr, StringBuffer* buf);
-static void _Generator_conditionExpression(Generator* gen, Expression* expr, StringBuffer* buf);
-static void _Generator_unaryExpression(Generator* gen, Expression* expr, StringBuffer* buf);
-static void _Generator_binaryExpression(Generator* gen, Expression* expr, StringBuffer* buf);
-static void _Generator_callExpression(Generator* gen, Expression* expr, StringBuffer* buf);
+static void _Generator_expression(Generator* gen, Expression* expr, Rope* buf);
+static void _Generator_conditionExpression(Generator* gen, Expression* expr, Rope* buf);
+static void _Generator_unaryExpression(Generator* gen, Expression* expr, Rope* buf);
+static void _Generator_binaryExpression(Generator* gen, Expression* expr, Rope* buf);
+static void _Generator_callExpression(Generator* gen, Expression* expr, Rope* buf);
 static bool _Generator_isConstantExpression(Generator* gen, Expression* expr);
 
-static void _Generator_indent(Generator* gen, StringBuffer* buf);
+static void _Generator_functionName(Generator* gen, String name, Rope* buf);
+static void _Generator_indent(Generator* gen, Rope* buf);
 
 void Generator_init(Generator* gen, GenerateTarget target)
 {
-	StringBuffer_init(&gen->header);
-	StringBuffer_init(&gen->srcDecl);
-	StringBuffer_init(&gen->srcDef);
-	StringBuffer_init(&gen->initGlobal);
-	StringBuffer_init(&gen->main);
+	Rope_init(&gen->header);
+	Rope_init(&gen->srcDecl);
+	Rope_init(&gen->srcDef);
+	Rope_init(&gen->initGlobal);
+	Rope_init(&gen->main);
 	gen->module = NULL;
 	gen->target = target;
+	String_init(&gen->unit);
 	gen->level = 0;
 	gen->inMain = false;
 
-	StringBuffer_append(&gen->srcDecl, "#include <stdbool.h>\n");
+	Rope_append(&gen->srcDecl, "#include <stdbool.h>\n");
 }
 
 void Generator_destroy(Generator* gen)
 {
-	StringBuffer_destroy(&gen->header);
-	StringBuffer_destroy(&gen->srcDecl);
-	StringBuffer_destroy(&gen->srcDef);
-	StringBuffer_destroy(&gen->initGlobal);
+	Rope_destroy(&gen->header);
+	Rope_destroy(&gen->srcDecl);
+	Rope_destroy(&gen->srcDef);
+	Rope_destroy(&gen->initGlobal);
+	Rope_destroy(&gen->main);
 }
 
 void Generator_generate(Generator* gen, Module* module)
 {
 	gen->module = module;
 
+	if (gen->target == GENERATE_TARGE_X64)
+	{
+		X64Generator x64;
+		X64Generator_init(&x64);
+		X64Generator_generate(&x64, module, &gen->srcDef);
+		X64Generator_destroy(&x64);
+		return;
+	}
+
 	for (int i = 0; i < module->declarations.size; i++)
 	{
 		Declaration* decl = (Declaration*)Vector_get(&module->declarations, i);
@@ -67,15 +82,52 @@ void Generator_generate(Generator* gen, Module* module)
 	}
 }
 
-void Generator_getSource(Generator* gen, StringBuffer* source)
+void Generator_getSource(Generator* gen, Rope* source)
 {
-	StringBuffer_appendString(source, (String*)&gen->srcDecl);
-	StringBuffer_appendString(source, (String*)&gen->srcDef);
+	if (gen->target == GENERATE_TARGE_X64)
+	{
+		Rope_splice(source, &gen->srcDef);
+		return;
+	}
+
+	if (gen->unit.length)
+	{
+		Rope_append(source, "#include \"");
+		Rope_appendString(source, &gen->unit);
+		Rope_append(source, ".h\"\n");
+	}
+
+	Rope_splice(source, &gen->srcDecl);
+	Rope_splice(source, &gen->srcDef);
+
+	if (gen->unit.length)
+	{
+		//global initialization is left to the program linking the unit
+		Rope_append(source, "void ");
+		Rope_appendString(source, &gen->unit);
+		Rope_append(source, "_init()\n{\n");
+		Rope_splice(source, &gen->initGlobal);
+		Rope_append(source, "}\n");
+		return;
+	}
 
-	StringBuffer_append(source, "int main()\n{\n");
-	StringBuffer_appendString(source, (String*)&gen->initGlobal);
-	StringBuffer_appendString(source, (String*)&gen->main);
-	StringBuffer_append(source, "}\n");
+	Rope_append(source, "int main()\n{\n");
+	Rope_splice(source, &gen->initGlobal);
+	Rope_splice(source, &gen->main);
+	Rope_append(source, "}\n");
+}
+
+void Generator_getHeader(Generator* gen, Rope* header)
+{
+	char guard[256];
+	int len = 0;
+	for (int i = 0; i < gen->unit.length && len < (int)sizeof(guard) - 3; ++i)
+		guard[len++] = (char)toupper((unsigned char)gen->unit.data[i]);
+
+	Rope_appendFormat(header, "#ifndef %.*s_H\n#define %.*s_H\n\n", len, guard, len, guard);
+	Rope_append(header, "#include <stdbool.h>\n\n");
+	Rope_splice(header, &gen->header);
+	Rope_appendFormat(header, "extern void " String_FMT "_init();\n\n#endif\n", String_arg(gen->unit));
 }
 
 void _Generator_variant(Generator* gen, Declaration* decl)
@@ -84,69 +136,69 @@ void _Generator_variant(Generator* gen, Declaration* decl)
 	if (gen->level == 0 && decl->exported)
 	{
 		//extern
-		StringBuffer_append(&gen->header, "extern ");
+		Rope_append(&gen->header, "extern ");
 
 		//type
-		StringBuffer_appendString(&gen->header, &var->type.name);
-		StringBuffer_append(&gen->header, " ");
+		Rope_appendString(&gen->header, &var->type.name);
+		Rope_append(&gen->header, " ");
 
 		//name
-		StringBuffer_appendString(&gen->header, &var->name);
+		Rope_appendString(&gen->header, &var->name);
 
-		StringBuffer_append(&gen->header, ";\n");
+		Rope_append(&gen->header, ";\n");
 	}
 
 	if (gen->level == 0)
 	{
 		//static
 		if (!decl->exported)
-			StringBuffer_append(&gen->srcDecl, "static ");
+			Rope_append(&gen->srcDecl, "static ");
 
 		//type
-		StringBuffer_appendString(&gen->srcDecl, &var->type.name);
-		StringBuffer_append(&gen->srcDecl, " ");
+		Rope_appendString(&gen->srcDecl, &var->type.name);
+		Rope_append(&gen->srcDecl, " ");
 
 		//name
-		StringBuffer_appendString(&gen->srcDecl, &var->name);
+		Rope_appendString(&gen->srcDecl, &var->name);
 
 		if (var->initExpr)
 		{
 			if (!_Generator_isConstantExpression(gen, var->initExpr))
 			{
-				StringBuffer_append(&gen->initGlobal, "\t");
-				StringBuffer_appendString(&gen->initGlobal, &var->name);
-				StringBuffer_append(&gen->initGlobal, " = ");
+				Rope_append(&gen->initGlobal, "\t");
+				Rope_appendString(&gen->initGlobal, &var->name);
+				Rope_append(&gen->initGlobal, " = ");
 				_Generator_expression(gen, var->initExpr, &gen->initGlobal);
-				StringBuffer_append(&gen->initGlobal, ";\n");
+				Rope_append(&gen->initGlobal, ";\n");
 			}
 			else
 			{
-				StringBuffer_append(&gen->srcDecl, " = ");
+				Rope_append(&gen->srcDecl, " = ");
 				_Generator_expression(gen, var->initExpr, &gen->srcDecl);
 			}
 		}
 
-		StringBuffer_append(&gen->srcDecl, ";\n");
+		Rope_append(&gen->srcDecl, ";\n");
 		return;
 	}
 
-	StringBuffer* buf = gen->inMain ? &gen->main : &gen->srcDef;
+	Rope* buf = gen->inMain ? &gen->main : &gen->srcDef;
 	_Generator_indent(gen, buf);
 
 	//type
-	StringBuffer_appendString(buf, &var->type.name);
-	StringBuffer_append(buf, " ");
+	Rope_appendString(buf, &var->type.name);
+	Rope_append(buf, " ");
 
 	//name
-	StringBuffer_appendString(buf, &var->name);
+	Rope_appendString(buf, &var->name);
 
 	if (var->initExpr)
 	{
-		StringBuffer_append(buf, " = ");
+		Rope_append(buf, " = ");
 		_Generator_expression(gen, var->initExpr, buf);
 	}
 
-	StringBuffer_append(buf, ";\n");
+	Rope_append(buf, ";\n");
 }
 
 void _Generator_function(Generator* gen, Declaration* decl)
@@ -154,54 +206,54 @@ void _Generator_function(Generator* gen, Declaration* decl)
 	FuncDecl* func = &decl->function;
 	String main = String_literal("main");
 
-	if (!String_equalsString(func->name, main))  //not 'main'
+	if (gen->unit.length || !String_equalsString(func->name, main))  //not 'main' of program
 	{
 		if (decl->exported)
 		{
 			//extern
-			StringBuffer_append(&gen->header, "extern ");
+			Rope_append(&gen->header, "extern ");
 
 			//type
-			StringBuffer_appendString(&gen->header, &func->resType.name);
-			StringBuffer_append(&gen->header, " ");
+			Rope_appendString(&gen->header, &func->resType.name);
+			Rope_append(&gen->header, " ");
 
 			//name
-			StringBuffer_appendString(&gen->header, &func->name);
+			_Generator_functionName(gen, func->name, &gen->header);
 
 			//parameters
 			_Generator_parameterList(gen, func->parameters, &gen->header);
 
-			StringBuffer_append(&gen->header, ";\n");
+			Rope_append(&gen->header, ";\n");
 		}
 		else
 		{
 			//static
-			StringBuffer_append(&gen->srcDecl, "static ");
+			Rope_append(&gen->srcDecl, "static ");
 
 			//type
-			StringBuffer_appendString(&gen->srcDecl, &func->resType.name);
-			StringBuffer_append(&gen->srcDecl, " ");
+			Rope_appendString(&gen->srcDecl, &func->resType.name);
+			Rope_append(&gen->srcDecl, " ");
 
 			//name
-			StringBuffer_appendString(&gen->srcDecl, &func->name);
+			_Generator_functionName(gen, func->name, &gen->srcDecl);
 
 			//parameters
 			_Generator_parameterList(gen, func->parameters, &gen->srcDecl);
 
-			StringBuffer_append(&gen->srcDecl, ";\n");
+			Rope_append(&gen->srcDecl, ";\n");
 		}
 
 		//type
-		StringBuffer_appendString(&gen->srcDef, &func->resType.name);
-		StringBuffer_append(&gen->srcDef, " ");
+		Rope_appendString(&gen->srcDef, &func->resType.name);
+		Rope_append(&gen->srcDef, " ");
 
 		//name
-		StringBuffer_appendString(&gen->srcDef, &func->name);
+		_Generator_functionName(gen, func->name, &gen->srcDef);
 
 		//parameters
 		_Generator_parameterList(gen, func->parameters, &gen->srcDef);
 
-		StringBuffer_append(&gen->srcDef, " ");
+		Rope_append(&gen->srcDef, " ");
 
 		//block
 		_Generator_compoundStatement(gen, decl, func->block);
@@ -223,27 +275,27 @@ void _Generator_function(Generator* gen, Declaration* decl)
 	gen->inMain = false;
 }
 
-void _Generator_parameterList(Generator* gen, Vector params, StringBuffer* buf)
+void _Generator_parameterList(Generator* gen, Vector params, Rope* buf)
 {
-	StringBuffer_append(buf, "(");
+	Rope_append(buf, "(");
 
 	for (int i = 0; i < params.size; ++i)
 	{
 		if (i != 0)
-			StringBuffer_append(buf, ", ");
+			Rope_append(buf, ", ");
 
 		Parameter* p = Vector_get(&params, i);
 
 		//type
-		StringBuffer_appendString(buf, &p->type.name);
+		Rope_appendString(buf, &p->type.name);
 
-		StringBuffer_append(buf, " ");
+		Rope_append(buf, " ");
 
 		//name
-		StringBuffer_appendString(buf, &p->name);
+		Rope_appendString(buf, &p->name);
 	}
 
-	StringBuffer_append(buf, ")");
+	Rope_append(buf, ")");
 }
 
 void _Generator_statement(Generator* gen, Declaration* decl, Statement* stat)
@@ -293,11 +345,11 @@ void _Generator_statement(Generator* gen, Declaration* decl, Statement* stat)
 
 void _Generator_ifStatement(Generator* gen, Declaration* decl, Statement* stat)
 {
-	StringBuffer* buf = gen->inMain ? &gen->main : &gen->srcDef;
+	Rope* buf = gen->inMain ? &gen->main : &gen->srcDef;
 
-	_Generator_indent(gen, buf); StringBuffer_append(buf, "if (");
+	_Generator_indent(gen, buf); Rope_append(buf, "if (");
 	_Generator_expression(gen, stat->ifStat.condition, buf);
-	StringBuffer_append(buf, ")\n");
+	Rope_append(buf, ")\n");
 
 	if (stat->ifStat.statement->type != STATEMENT_TYPE_COMPOUND)
 		gen->level++;
@@ -309,7 +361,7 @@ void _Generator_ifStatement(Generator* gen, Declaration* decl, Statement* stat)
 	
 	if (stat->ifStat.elseStat)
 	{
-		_Generator_indent(gen, buf); StringBuffer_append(buf, "else\n");
+		_Generator_indent(gen, buf); Rope_append(buf, "else\n");
 		if (stat->ifStat.elseStat->type != STATEMENT_TYPE_COMPOUND)
 			gen->level++;
 
@@ -322,7 +374,7 @@ void _Generator_ifStatement(Generator* gen, Declaration* decl, Statement* stat)
 
 void _Generator_assignStatement(Generator* gen, Statement* stat)
 {
-	StringBuffer* buf = gen->inMain ? &gen->main : &gen->srcDef;
+	Rope* buf = gen->inMain ? &gen->main : &gen->srcDef;
 	_Generator_indent(gen, buf);
 
 	_Generator_expression(gen, stat->assign.leftExpr, buf);
@@ -330,70 +382,70 @@ void _Generator_assignStatement(Generator* gen, Statement* stat)
 	switch (stat->type)
 	{
 	case STATEMENT_TYPE_ASSIGN:
-		StringBuffer_append(buf, " = ");
+		Rope_append(buf, " = ");
 		break;
 
 	case STATEMENT_TYPE_ADD_ASSIGN:
-		StringBuffer_append(buf, " += ");
+		Rope_append(buf, " += ");
 		break;
 
 	case STATEMENT_TYPE_SUB_ASSIGN:
-		StringBuffer_append(buf, " -= ");
+		Rope_append(buf, " -= ");
 		break;
 
 	case STATEMENT_TYPE_MUL_ASSIGN:
-		StringBuffer_append(buf, " *= ");
+		Rope_append(buf, " *= ");
 		break;
 
 	case STATEMENT_TYPE_DIV_ASSIGN:
-		StringBuffer_append(buf, " /= ");
+		Rope_append(buf, " /= ");
 		break;
 
 	case STATEMENT_TYPE_MOD_ASSIGN:
-		StringBuffer_append(buf, " %= ");
+		Rope_append(buf, " %= ");
 		break;
 
 	case STATEMENT_TYPE_BITAND_ASSIGN:
-		StringBuffer_append(buf, " &= ");
+		Rope_append(buf, " &= ");
 		break;
 
 	case STATEMENT_TYPE_BITOR_ASSIGN:
-		StringBuffer_append(buf, " |= ");
+		Rope_append(buf, " |= ");
 		break;
 
 	case STATEMENT_TYPE_XOR_ASSIGN:
-		StringBuffer_append(buf, " ^= ");
+		Rope_append(buf, " ^= ");
 		break;
 
 	case STATEMENT_TYPE_LSHIFT_ASSIGN:
-		StringBuffer_append(buf, " <<= ");
+		Rope_append(buf, " <<= ");
 		break;
 	
 	case STATEMENT_TYPE_RSHIFT_ASSIGN:
-		StringBuffer_append(buf, " >>= ");
+		Rope_append(buf, " >>= ");
 		break;
 	}
 
 	_Generator_expression(gen, stat->assign.rightExpr, buf);
 
-	StringBuffer_append(buf, ";\n");
+	Rope_append(buf, ";\n");
 }
 
 void _Generator_incDecStatement(Generator* gen, Statement* stat)
 {
-	StringBuffer* buf = gen->inMain ? &gen->main : &gen->srcDef;
+	Rope* buf = gen->inMain ? &gen->main : &gen->srcDef;
 	_Generator_indent(gen, buf);
 
 	_Generator_expression(gen, stat->incExpr, buf);
-	StringBuffer_append(buf, stat->type == STATEMENT_TYPE_INC ? "++;\n" : "--;\n");
+	Rope_append(buf, stat->type == STATEMENT_TYPE_INC ? "++;\n" : "--;\n");
 }
 
 void _Generator_compoundStatement(Generator* gen, Declaration* decl, Vector block)
 {
-	StringBuffer* buf = gen->inMain ? &gen->main : &gen->srcDef;
+	Rope* buf = gen->inMain ? &gen->main : &gen->srcDef;
 
 	_Generator_indent(gen, buf);
-	StringBuffer_append(buf, "{\n");
+	Rope_append(buf, "{\n");
 
 	gen->level++;
 
@@ -405,35 +457,35 @@ void _Generator_compoundStatement(Generator* gen, Declaration* decl, Vector bloc
 
 	gen->level--;
 	_Generator_indent(gen, buf);
-	StringBuffer_append(buf, "}\n");
+	Rope_append(buf, "}\n");
 }
 
 void _Generator_expressionStatement(Generator* gen, Expression* expr)
 {
-	StringBuffer* buf = gen->inMain ? &gen->main : &gen->srcDef;
+	Rope* buf = gen->inMain ? &gen->main : &gen->srcDef;
 	_Generator_indent(gen, buf);
 
 	_Generator_expression(gen, expr, buf);
 
-	StringBuffer_append(buf, ";\n");
+	Rope_append(buf, ";\n");
 }
 
 void _Generator_returnStatement(Generator* gen, Statement* stat)
 {
-	StringBuffer* buf = gen->inMain ? &gen->main : &gen->srcDef;
+	Rope* buf = gen->inMain ? &gen->main : &gen->srcDef;
 	_Generator_indent(gen, buf);
 
-	StringBuffer_append(buf, "return");
+	Rope_append(buf, "return");
 	if (stat->returnExpr)
 	{
-		StringBuffer_append(buf, " ");
+		Rope_append(buf, " ");
 		_Generator_expression(gen, stat->returnExpr, buf);
 	}
 
-	StringBuffer_append(buf, ";\n");
+	Rope_append(buf, ";\n");
 }
 
-void _Generator_expression(Generator* gen, Expression* expr, StringBuffer* buf)
+void _Generator_expression(Generator* gen, Expression* expr, Rope* buf)
 {
 	char tmp[64];
 	int len;
@@ -441,16 +493,16 @@ void _Generator_expression(Generator* gen, Expression* expr, StringBuffer* buf)
 	switch (expr->type)
 	{
 	case EXPR_TYPE_IDENT:
-		StringBuffer_appendString(buf, &expr->identExpr);
+		Rope_appendString(buf, &expr->identExpr.name);
 		break;
 
 	case EXPR_TYPE_INT:
 		len = snprintf(tmp, sizeof(tmp), "%d", expr->intExpr);
-		StringBuffer_appendN(buf, tmp, len);
+		Rope_appendN(buf, tmp, len);
 		break;
 
 	case EXPR_TYPE_BOOL:
-		StringBuffer_append(buf, expr->boolExpr ? "true" : "false");
+		Rope_append(buf, expr->boolExpr ? "true" : "false");
 		break;
 
 	case EXPR_TYPE_CALL:
@@ -491,147 +543,162 @@ void _Generator_expression(Generator* gen, Expression* expr, StringBuffer* buf)
 	}
 }
 
-void _Generator_conditionExpression(Generator* gen, Expression* expr, StringBuffer* buf)
+void _Generator_conditionExpression(Generator* gen, Expression* expr, Rope* buf)
 {
 	_Generator_expression(gen, expr->condExpr.expr1, buf);
-	StringBuffer_append(buf, " ? ");
+	Rope_append(buf, " ? ");
 	_Generator_expression(gen, expr->condExpr.expr2, buf);
-	StringBuffer_append(buf, " : ");
+	Rope_append(buf, " : ");
 	_Generator_expression(gen, expr->condExpr.expr3, buf);
 }
 
-void _Generator_unaryExpression(Generator* gen, Expression* expr, StringBuffer* buf)
+void _Generator_unaryExpression(Generator* gen, Expression* expr, Rope* buf)
 {
 	switch (expr->type)
 	{
 	case EXPR_TYPE_PLUS:
-		StringBuffer_append(buf, "+");
+		Rope_append(buf, "+");
 		break;
 
 	case EXPR_TYPE_MINUS:
-		StringBuffer_append(buf, "-");
+		Rope_append(buf, "-");
 		break;
 
 	case EXPR_TYPE_NEG:
-		StringBuffer_append(buf, "~");
+		Rope_append(buf, "~");
 		break;
 
 	case EXPR_TYPE_NOT:
-		StringBuffer_append(buf, "!");
+		Rope_append(buf, "!");
 		break;
 	}
 
 	_Generator_expression(gen, expr->unaryExpr, buf);
 }
 
-void _Generator_binaryExpression(Generator* gen, Expression* expr, StringBuffer* buf)
+void _Generator_binaryExpression(Generator* gen, Expression* expr, Rope* buf)
 {
-	StringBuffer_append(buf, "(");
+	Rope_append(buf, "(");
 	_Generator_expression(gen, expr->binaryExpr.leftExpr, buf);
 
 	switch (expr->type)
 	{
 	case EXPR_TYPE_ADD:
-		StringBuffer_append(buf, " + ");
+		Rope_append(buf, " + ");
 		break;
 
 	case EXPR_TYPE_SUB:
-		StringBuffer_append(buf, " - ");
+		Rope_append(buf, " - ");
 		break;
 
 	case EXPR_TYPE_MUL:
-		StringBuffer_append(buf, " * ");
+		Rope_append(buf, " * ");
 		break;
 
 	case EXPR_TYPE_DIV:
-		StringBuffer_append(buf, " / ");
+		Rope_append(buf, " / ");
 		break;
 
 	case EXPR_TYPE_MOD:
-		StringBuffer_append(buf, " % ");
+		Rope_append(buf, " % ");
 		break;
 
 	case EXPR_TYPE_NE:
-		StringBuffer_append(buf, " != ");
+		Rope_append(buf, " != ");
 		break;
 
 	case EXPR_TYPE_EQ:
-		StringBuffer_append(buf, " == ");
+		Rope_append(buf, " == ");
 		break;
 
 	case EXPR_TYPE_LT:
-		StringBuffer_append(buf, " < ");
+		Rope_append(buf, " < ");
 		break;
 
 	case EXPR_TYPE_LE:
-		StringBuffer_append(buf, " <= ");
+		Rope_append(buf, " <= ");
 		break;
 
 	case EXPR_TYPE_GT:
-		StringBuffer_append(buf, " > ");
+		Rope_append(buf, " > ");
 		break;
 
 	case EXPR_TYPE_GE:
-		StringBuffer_append(buf, " >= ");
+		Rope_append(buf, " >= ");
 		break;
 
 	case EXPR_TYPE_AND:
-		StringBuffer_append(buf, " && ");
+		Rope_append(buf, " && ");
 		break;
 
 	case EXPR_TYPE_OR:
-		StringBuffer_append(buf, " || ");
+		Rope_append(buf, " || ");
 		break;
 
 	case EXPR_TYPE_BITAND:
-		StringBuffer_append(buf, " & ");
+		Rope_append(buf, " & ");
 		break;
 
 	case EXPR_TYPE_BITOR:
-		StringBuffer_append(buf, " | ");
+		Rope_append(buf, " | ");
 		break;
 
 	case EXPR_TYPE_XOR:
-		StringBuffer_append(buf, " ^ ");
+		Rope_append(buf, " ^ ");
 		break;
 
 	case EXPR_TYPE_LSHIFT:
-		StringBuffer_append(buf, " << ");
+		Rope_append(buf, " << ");
 		break;
 
 	case EXPR_TYPE_RSHIFT:
-		StringBuffer_append(buf, " >> ");
+		Rope_append(buf, " >> ");
 		break;
 	}
 
 	_Generator_expression(gen, expr->binaryExpr.rightExpr, buf);
-	StringBuffer_append(buf, ")");
+	Rope_append(buf, ")");
 }
 
-void _Generator_callExpression(Generator* gen, Expression* expr, StringBuffer* buf)
+void _Generator_callExpression(Generator* gen, Expression* expr, Rope* buf)
 {
-	StringBuffer_appendString(buf, &expr->callExpr.func->identExpr);
-	StringBuffer_append(buf, "(");
+	_Generator_functionName(gen, expr->callExpr.func->identExpr.name, buf);
+	Rope_append(buf, "(");
 
 	for (int i = 0; i < expr->callExpr.args.size; ++i)
 	{
 		if (i != 0)
-			StringBuffer_append(buf, ", ");
+			Rope_append(buf, ", ");
 
 		Expression* arg = Vector_get(&expr->callExpr.args, i);
 		_Generator_expression(gen, arg, buf);
 	}
 
-	StringBuffer_append(buf, ")");
+	Rope_append(buf, ")");
 }
 
 bool _Generator_isConstantExpression(Generator* gen, Expression* expr)
 {
-	return !Expression_contains(expr, EXPR_TYPE_IDENT);  //TODO: check const ident
+	Constant value;
+	return Constant_evaluate(expr, &value);  //TODO: check const ident
+}
+
+//'main' of a unit is renamed, C 'main' belongs to the program linking it
+void _Generator_functionName(Generator* gen, String name, Rope* buf)
+{
+	String main = String_literal("main");
+	if (gen->unit.length && String_equalsString(name, main))
+	{
+		Rope_appendString(buf, &gen->unit);
+		Rope_append(buf, "_main");
+		return;
+	}
+
+	Rope_appendString(buf, &name);
 }
 
-void _Generator_indent(Generator* gen, StringBuffer* buf)
+void _Generator_indent(Generator* gen, Rope* buf)
 {
 	for (int i = 0; i < gen->level; ++i)
-		StringBuffer_append(buf, "\t");
+		Rope_append(buf, "\t");
 }
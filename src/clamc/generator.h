@@ -3,23 +3,26 @@
 
 #include "ast.h"
 #include "module.h"
+#include "rope.h"
 
 enum GenerateTarget
 {
 	GENERATE_TARGE_C,
+	GENERATE_TARGE_X64,  //x86-64 GNU assembly
 };
 typedef enum GenerateTarget GenerateTarget;
 
 struct Generator
 {
-	StringBuffer header;
-	StringBuffer srcDecl;
-	StringBuffer srcDef;
-	StringBuffer initGlobal;
-	StringBuffer main;
+	Rope header;
+	Rope srcDecl;
+	Rope srcDef;
+	Rope initGlobal;
+	Rope main;
 	
 	Module* module;
 	GenerateTarget target;
+	String unit;  //module name of separate header and source, empty for one program
 	int level;
 	bool inMain;
 };
@@ -29,6 +32,7 @@ void Generator_init(Generator* gen, GenerateTarget target);
 void Generator_destroy(Generator* gen);
 
 void Generator_generate(Generator* gen, Module* mod);
-void Generator_getSource(Generator* gen, StringBuffer* source);
+void Generator_getSource(Generator* gen, Rope* source);  //moves generated text to source
+void Generator_getHeader(Generator* gen, Rope* header);  //unit only
 
 #endif
\ No newline at end of file
@@ -0,0 +1,563 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "jit.h"
+#include "vm.h"
+#include "message.h"
+#include "thread.h"
+
+#if defined(__x86_64__) && !defined(_WIN32)
+#define JIT_X64
+#include <sys/mman.h>
+#endif
+
+struct JitBlock
+{
+	void* data;
+	size_t size;
+};
+typedef struct JitBlock JitBlock;
+
+struct JitJump
+{
+	int offset;  //code offset of rel32
+	int target;  //instruction index, JIT_OVERFLOW or JIT_FALLBACK for stubs
+};
+typedef struct JitJump JitJump;
+
+#define JIT_OVERFLOW -1
+#define JIT_FALLBACK -2
+
+enum JitRegister
+{
+	RAX = 0, RCX = 1, RDX = 2, RBX = 3, RSP = 4, RBP = 5, RSI = 6, RDI = 7,
+	R12 = 12, R13 = 13,
+};
+
+//native frame: rbx registers of frame, rbp globals, r12 vm, r13 frame base
+
+static int _Jit_enter(VM* vm, int base, int chunk);
+static void _Jit_reserve(VM* vm, int size);
+static int _Jit_interpret(VM* vm, int base, int chunk);
+static void _Jit_stackOverflow();
+static void _Jit_callOverflow(const Program* program, Chunk* chunk, int pc);
+static void _Jit_divisionByZero(Chunk* chunk, int pc);
+static JitNative _Jit_compile(Jit* jit, int chunk);
+static bool _Jit_instruction(Jit* jit, Chunk* chunk, int pc);
+static void _Jit_prologue(Jit* jit, Chunk* chunk);
+static void _Jit_epilogue(Jit* jit);
+static void _Jit_loadRegisters(Jit* jit);
+static void _Jit_load(Jit* jit, int reg, int slot);
+static void _Jit_store(Jit* jit, int reg, int slot);
+static void _Jit_mem(Jit* jit, bool wide, int op, int reg, int base, int disp);
+static void _Jit_jump(Jit* jit, int op, int target);
+static void _Jit_patch(Jit* jit, int offset, int dest);
+static void _Jit_call(Jit* jit, void* func);
+static void _Jit_bytes(Jit* jit, const char* bytes, int size);
+static void _Jit_byte(Jit* jit, int b);
+static void _Jit_int(Jit* jit, int v);
+static void _Jit_pointer(Jit* jit, const void* p);
+static void* _Jit_install(Jit* jit);
+
+void Jit_init(Jit* jit)
+{
+	jit->program = NULL;
+	Vector_init(&jit->natives, sizeof(JitNative));
+	Vector_init(&jit->tried, sizeof(bool));
+	Vector_init(&jit->blocks, sizeof(JitBlock));
+	Vector_init(&jit->code, sizeof(unsigned char));
+	Vector_init(&jit->offsets, sizeof(int));
+	Vector_init(&jit->jumps, sizeof(JitJump));
+	Vector_init(&jit->traps, sizeof(JitJump));
+	Vector_init(&jit->overflows, sizeof(JitJump));
+	jit->stackLimit = 0;
+	jit->depth = 0;
+	jit->interpret = false;
+}
+
+void Jit_destroy(Jit* jit)
+{
+#ifdef JIT_X64
+	for (int i = 0; i < jit->blocks.size; ++i)
+	{
+		JitBlock* block = Vector_get(&jit->blocks, i);
+		munmap(block->data, block->size);
+	}
+#endif
+	Vector_destroy(&jit->natives);
+	Vector_destroy(&jit->tried);
+	Vector_destroy(&jit->blocks);
+	Vector_destroy(&jit->code);
+	Vector_destroy(&jit->offsets);
+	Vector_destroy(&jit->jumps);
+	Vector_destroy(&jit->traps);
+	Vector_destroy(&jit->overflows);
+}
+
+void Jit_prepare(Jit* jit, const Program* program)
+{
+	jit->program = program;
+	Jit_reset(jit);
+
+	//compiled code references these tables by address, never resize them while running
+	Vector_resize(&jit->natives, program->chunks.size);
+	Vector_resize(&jit->tried, program->chunks.size);
+	if (program->chunks.size)
+	{
+		memset(jit->natives.data, 0, program->chunks.size * sizeof(JitNative));
+		memset(jit->tried.data, 0, program->chunks.size * sizeof(bool));
+	}
+}
+
+void Jit_reset(Jit* jit)
+{
+	jit->depth = 0;
+	jit->interpret = false;
+}
+
+int Jit_call(VM* vm, int chunk, int base)
+{
+	Jit* jit = vm->jit;
+
+	//outermost entry, native stack is measured from here
+	if (jit->depth++ == 0)
+		jit->stackLimit = Thread_stackLimit(JIT_MAX_STACK);
+
+	int value = _Jit_enter(vm, base, chunk);
+
+	jit->depth--;
+	return value;
+}
+
+int _Jit_enter(VM* vm, int base, int chunk)
+{
+	Jit* jit = vm->jit;
+	JitNative* native = Vector_get(&jit->natives, chunk);
+	bool* tried = Vector_get(&jit->tried, chunk);
+
+	if (!*tried)
+	{
+		*tried = true;
+		*native = _Jit_compile(jit, chunk);
+	}
+
+	if (*native)
+		return (*native)(vm, base);
+
+	//not supported, fall back to interpreter
+	return VM_execute(vm, chunk, base);
+}
+
+void _Jit_reserve(VM* vm, int size)
+{
+	int cap = vm->registers.cap * 2;
+	Vector_reserve(&vm->registers, cap > size ? cap : size);
+	if (size > vm->registers.size)
+		vm->registers.size = size;
+}
+
+int _Jit_interpret(VM* vm, int base, int chunk)
+{
+	//frames of interpreter are on heap, callees are not compiled code again
+	vm->jit->interpret = true;
+	int value = VM_execute(vm, chunk, base);
+	vm->jit->interpret = false;
+	return value;
+}
+
+void _Jit_stackOverflow()
+{
+	error(NULL, "stack overflow");
+}
+
+void _Jit_callOverflow(const Program* program, Chunk* chunk, int pc)
+{
+	Instruction* ins = Vector_get(&chunk->code, pc);
+	Chunk* callee = Vector_get(&program->chunks, ins->b);
+	error(Vector_get(&chunk->locations, pc), "stack overflow, call function '" String_FMT "'", String_arg(callee->name));
+}
+
+void _Jit_divisionByZero(Chunk* chunk, int pc)
+{
+	error(Vector_get(&chunk->locations, pc), "right value is zero, division by zero");
+}
+
+JitNative _Jit_compile(Jit* jit, int index)
+{
+#ifndef JIT_X64
+	return NULL;
+#else
+	Chunk* chunk = Vector_get(&jit->program->chunks, index);
+
+	Vector_resize(&jit->code, 0);
+	Vector_resize(&jit->offsets, chunk->code.size + 1);
+	Vector_resize(&jit->jumps, 0);
+	Vector_resize(&jit->traps, 0);
+	Vector_resize(&jit->overflows, 0);
+
+	_Jit_prologue(jit, chunk);
+
+	for (int pc = 0; pc < chunk->code.size; ++pc)
+	{
+		*(int*)Vector_get(&jit->offsets, pc) = jit->code.size;
+		if (!_Jit_instruction(jit, chunk, pc))
+			return NULL;
+	}
+	*(int*)Vector_get(&jit->offsets, chunk->code.size) = jit->code.size;
+
+	//falling off the end returns 0 like OP_RETV
+	_Jit_bytes(jit, "\x31\xC0", 2);  //xor eax, eax
+	_Jit_epilogue(jit);
+
+	//native stack used up, run chunk by interpreter
+	int fallback = jit->code.size;
+	_Jit_bytes(jit, "\x4C\x89\xE7\x44\x89\xEE", 6);  //mov rdi, r12; mov esi, r13d
+	_Jit_byte(jit, 0xBA);                            //mov edx, chunk
+	_Jit_int(jit, index);
+	_Jit_call(jit, (void*)_Jit_interpret);
+	_Jit_epilogue(jit);
+
+	//stubs, never return
+	int overflow = jit->code.size;
+	_Jit_call(jit, (void*)_Jit_stackOverflow);
+
+	for (int i = 0; i < jit->overflows.size; ++i)
+	{
+		JitJump* call = Vector_get(&jit->overflows, i);
+		_Jit_patch(jit, call->offset, jit->code.size);
+
+		_Jit_bytes(jit, "\x48\xBF", 2);  //mov rdi, program
+		_Jit_pointer(jit, jit->program);
+		_Jit_bytes(jit, "\x48\xBE", 2);  //mov rsi, chunk
+		_Jit_pointer(jit, chunk);
+		_Jit_byte(jit, 0xBA);            //mov edx, pc
+		_Jit_int(jit, call->target);
+		_Jit_call(jit, (void*)_Jit_callOverflow);
+	}
+
+	for (int i = 0; i < jit->traps.size; ++i)
+	{
+		JitJump* trap = Vector_get(&jit->traps, i);
+		_Jit_patch(jit, trap->offset, jit->code.size);
+
+		_Jit_bytes(jit, "\x48\xBF", 2);  //mov rdi, chunk
+		_Jit_pointer(jit, chunk);
+		_Jit_byte(jit, 0xBE);            //mov esi, pc
+		_Jit_int(jit, trap->target);
+		_Jit_call(jit, (void*)_Jit_divisionByZero);
+	}
+
+	for (int i = 0; i < jit->jumps.size; ++i)
+	{
+		JitJump* jump = Vector_get(&jit->jumps, i);
+		int dest = jump->target == JIT_OVERFLOW ? overflow : jump->target == JIT_FALLBACK ? fallback : *(int*)Vector_get(&jit->offsets, jump->target);
+		_Jit_patch(jit, jump->offset, dest);
+	}
+
+	return (JitNative)_Jit_install(jit);
+#endif
+}
+
+bool _Jit_instruction(Jit* jit, Chunk* chunk, int pc)
+{
+	Instruction* ins = Vector_get(&chunk->code, pc);
+	JitNative* natives = jit->natives.data;
+
+	switch (ins->op)
+	{
+	case OP_NOP:
+		break;
+
+	case OP_LOADK:
+		_Jit_mem(jit, false, 0xC7, 0, RBX, ins->a * 4);  //mov dword [r + a], imm
+		_Jit_int(jit, ins->imm);
+		break;
+
+	case OP_MOVE:
+		_Jit_load(jit, RAX, ins->b);
+		_Jit_store(jit, RAX, ins->a);
+		break;
+
+	case OP_GETGLOBAL:
+		_Jit_mem(jit, false, 0x8B, RAX, RBP, ins->b * 4);
+		_Jit_store(jit, RAX, ins->a);
+		break;
+
+	case OP_SETGLOBAL:
+		_Jit_load(jit, RAX, ins->b);
+		_Jit_mem(jit, false, 0x89, RAX, RBP, ins->a * 4);
+		break;
+
+	case OP_NEGI:
+	case OP_BITNOTI:
+		_Jit_load(jit, RAX, ins->b);
+		_Jit_bytes(jit, ins->op == OP_NEGI ? "\xF7\xD8" : "\xF7\xD0", 2);  //neg/not eax
+		_Jit_store(jit, RAX, ins->a);
+		break;
+
+	case OP_NOTB:
+		_Jit_load(jit, RAX, ins->b);
+		_Jit_bytes(jit, "\x85\xC0\x0F\x94\xC0\x0F\xB6\xC0", 8);  //test eax, eax; sete al; movzx eax, al
+		_Jit_store(jit, RAX, ins->a);
+		break;
+
+	case OP_INCI:
+	case OP_DECI:
+		_Jit_mem(jit, false, 0x83, ins->op == OP_INCI ? 0 : 5, RBX, ins->a * 4);  //add/sub dword [r + a], 1
+		_Jit_byte(jit, 1);
+		break;
+
+	case OP_ADDI:
+	case OP_SUBI:
+	case OP_MULI:
+	case OP_BITANDI:
+	case OP_BITORI:
+	case OP_XORI:
+	{
+		static const int ops[] = { 0x03, 0x2B, 0x0FAF, 0, 0, 0x23, 0x0B, 0x33 };  //add sub imul - - and or xor
+		_Jit_load(jit, RAX, ins->b);
+		_Jit_mem(jit, false, ops[ins->op - OP_ADDI], RAX, RBX, ins->c * 4);
+		_Jit_store(jit, RAX, ins->a);
+		break;
+	}
+
+	case OP_DIVI:
+	case OP_MODI:
+	{
+		JitJump trap = { 0, pc };
+		_Jit_load(jit, RCX, ins->c);
+		_Jit_bytes(jit, "\x85\xC9\x0F\x84", 4);  //test ecx, ecx; jz trap
+		trap.offset = jit->code.size;
+		_Jit_int(jit, 0);
+		Vector_add(&jit->traps, &trap);
+
+		_Jit_load(jit, RAX, ins->b);
+		_Jit_bytes(jit, "\x99\xF7\xF9", 3);  //cdq; idiv ecx
+		_Jit_store(jit, ins->op == OP_DIVI ? RAX : RDX, ins->a);
+		break;
+	}
+
+	case OP_SHLI:
+	case OP_SHRI:
+		_Jit_load(jit, RCX, ins->c);
+		_Jit_load(jit, RAX, ins->b);
+		_Jit_bytes(jit, ins->op == OP_SHLI ? "\xD3\xE0" : "\xD3\xF8", 2);  //shl/sar eax, cl
+		_Jit_store(jit, RAX, ins->a);
+		break;
+
+	case OP_EQI:
+	case OP_NEI:
+	case OP_LTI:
+	case OP_LEI:
+	case OP_GTI:
+	case OP_GEI:
+	{
+		static const int setcc[] = { 0x94, 0x95, 0x9C, 0x9E, 0x9F, 0x9D };  //e ne l le g ge
+		_Jit_load(jit, RAX, ins->b);
+		_Jit_mem(jit, false, 0x3B, RAX, RBX, ins->c * 4);  //cmp eax, [r + c]
+		_Jit_byte(jit, 0x0F);
+		_Jit_byte(jit, setcc[ins->op - OP_EQI]);
+		_Jit_bytes(jit, "\xC0\x0F\xB6\xC0", 4);  //al; movzx eax, al
+		_Jit_store(jit, RAX, ins->a);
+		break;
+	}
+
+	case OP_JMP:
+		_Jit_jump(jit, 0xE9, pc + 1 + ins->imm);
+		break;
+
+	case OP_JMPF:
+	case OP_JMPT:
+		_Jit_mem(jit, false, 0x83, 7, RBX, ins->a * 4);  //cmp dword [r + a], 0
+		_Jit_byte(jit, 0);
+		_Jit_jump(jit, ins->op == OP_JMPF ? 0x0F84 : 0x0F85, pc + 1 + ins->imm);
+		break;
+
+	case OP_CALL:
+	{
+		//same limit as interpreter, checked by caller to report the call
+		Chunk* callee = Vector_get(&jit->program->chunks, ins->b);
+		JitJump overflow = { 0, pc };
+		_Jit_mem(jit, false, 0x8D, RAX, R13, ins->a + callee->frameSize);  //lea eax, [r13 + a + frameSize]
+		_Jit_mem(jit, false, 0x3B, RAX, R12, offsetof(VM, maxRegisters));  //cmp eax, maxRegisters
+		_Jit_bytes(jit, "\x0F\x8F", 2);                                   //jg overflow
+		overflow.offset = jit->code.size;
+		_Jit_int(jit, 0);
+		Vector_add(&jit->overflows, &overflow);
+
+		//callee frame starts at argument registers
+		_Jit_bytes(jit, "\x4C\x89\xE7", 3);              //mov rdi, r12
+		_Jit_mem(jit, false, 0x8D, RSI, R13, ins->a);  //lea esi, [r13 + a]
+
+		//call compiled callee directly, otherwise enter through _Jit_enter
+		_Jit_bytes(jit, "\x48\xB8", 2);                  //mov rax, &natives[b]
+		_Jit_pointer(jit, &natives[ins->b]);
+		_Jit_bytes(jit, "\x48\x8B\x00\x48\x85\xC0\x75\x0F", 8);  //mov rax, [rax]; test rax, rax; jnz call
+		_Jit_byte(jit, 0xBA);                            //mov edx, b
+		_Jit_int(jit, ins->b);
+		_Jit_bytes(jit, "\x48\xB8", 2);                  //mov rax, _Jit_enter
+		_Jit_pointer(jit, (void*)_Jit_enter);
+		_Jit_bytes(jit, "\xFF\xD0", 2);                  //call rax
+
+		//registers may be moved by callee
+		_Jit_loadRegisters(jit);
+		_Jit_store(jit, RAX, ins->a);
+		break;
+	}
+
+	case OP_RET:
+		_Jit_load(jit, RAX, ins->a);
+		_Jit_epilogue(jit);
+		break;
+
+	case OP_RETV:
+		_Jit_bytes(jit, "\x31\xC0", 2);  //xor eax, eax
+		_Jit_epilogue(jit);
+		break;
+
+	default:
+		return false;
+	}
+
+	return true;
+}
+
+void _Jit_prologue(Jit* jit, Chunk* chunk)
+{
+	_Jit_bytes(jit, "\x53\x55\x41\x54\x41\x55", 6);  //push rbx; push rbp; push r12; push r13
+	_Jit_bytes(jit, "\x48\x83\xEC\x08", 4);          //sub rsp, 8
+	_Jit_bytes(jit, "\x49\x89\xFC\x41\x89\xF5", 6);  //mov r12, rdi; mov r13d, esi
+
+	//native stack
+	_Jit_bytes(jit, "\x48\xB8", 2);                  //mov rax, &stackLimit
+	_Jit_pointer(jit, &jit->stackLimit);
+	_Jit_bytes(jit, "\x48\x3B\x20", 3);              //cmp rsp, [rax]
+	_Jit_jump(jit, 0x0F82, JIT_FALLBACK);            //jb fallback
+
+	//registers of frame
+	_Jit_mem(jit, false, 0x8D, RAX, R13, chunk->frameSize);                                 //lea eax, [r13 + frameSize]
+	_Jit_mem(jit, false, 0x3B, RAX, R12, offsetof(VM, maxRegisters));                       //cmp eax, maxRegisters
+	_Jit_jump(jit, 0x0F8F, JIT_OVERFLOW);                                                   //jg overflow
+	_Jit_mem(jit, false, 0x3B, RAX, R12, offsetof(VM, registers) + offsetof(Vector, cap));  //cmp eax, cap
+	_Jit_bytes(jit, "\x7E\x11\x4C\x89\xE7\x89\xC6", 7);  //jle done; mov rdi, r12; mov esi, eax
+	_Jit_call(jit, (void*)_Jit_reserve);
+
+	_Jit_mem(jit, true, 0x8B, RBP, R12, offsetof(VM, globals) + offsetof(Vector, data));  //mov rbp, globals
+	_Jit_loadRegisters(jit);
+}
+
+void _Jit_epilogue(Jit* jit)
+{
+	_Jit_bytes(jit, "\x48\x83\xC4\x08", 4);          //add rsp, 8
+	_Jit_bytes(jit, "\x41\x5D\x41\x5C\x5D\x5B", 6);  //pop r13; pop r12; pop rbp; pop rbx
+	_Jit_byte(jit, 0xC3);                            //ret
+}
+
+void _Jit_loadRegisters(Jit* jit)
+{
+	_Jit_mem(jit, true, 0x8B, RBX, R12, offsetof(VM, registers) + offsetof(Vector, data));  //mov rbx, registers
+	_Jit_bytes(jit, "\x4A\x8D\x1C\xAB", 4);                                                //lea rbx, [rbx + r13 * 4]
+}
+
+void _Jit_load(Jit* jit, int reg, int slot)
+{
+	_Jit_mem(jit, false, 0x8B, reg, RBX, slot * 4);
+}
+
+void _Jit_store(Jit* jit, int reg, int slot)
+{
+	_Jit_mem(jit, false, 0x89, reg, RBX, slot * 4);
+}
+
+//op reg, [base + disp32]
+void _Jit_mem(Jit* jit, bool wide, int op, int reg, int base, int disp)
+{
+	int rex = 0x40 | (wide ? 8 : 0) | (reg >= 8 ? 4 : 0) | (base >= 8 ? 1 : 0);
+	if (rex != 0x40)
+		_Jit_byte(jit, rex);
+
+	if (op > 0xFF)
+		_Jit_byte(jit, op >> 8);
+	_Jit_byte(jit, op & 0xFF);
+
+	_Jit_byte(jit, 0x80 | (reg & 7) << 3 | (base & 7));
+	if ((base & 7) == RSP)
+		_Jit_byte(jit, 0x24);  //sib, no index
+	_Jit_int(jit, disp);
+}
+
+//jmp or jcc rel32, patched after all instructions are emitted
+void _Jit_jump(Jit* jit, int op, int target)
+{
+	JitJump jump;
+
+	if (op > 0xFF)
+		_Jit_byte(jit, op >> 8);
+	_Jit_byte(jit, op & 0xFF);
+
+	jump.offset = jit->code.size;
+	jump.target = target;
+	Vector_add(&jit->jumps, &jump);
+	_Jit_int(jit, 0);
+}
+
+//rel32 at offset to dest
+void _Jit_patch(Jit* jit, int offset, int dest)
+{
+	int rel = dest - (offset + 4);
+	memcpy((unsigned char*)jit->code.data + offset, &rel, sizeof(rel));
+}
+
+void _Jit_call(Jit* jit, void* func)
+{
+	_Jit_bytes(jit, "\x48\xB8", 2);  //mov rax, func
+	_Jit_pointer(jit, func);
+	_Jit_bytes(jit, "\xFF\xD0", 2);  //call rax
+}
+
+void _Jit_bytes(Jit* jit, const char* bytes, int size)
+{
+	for (int i = 0; i < size; ++i)
+		_Jit_byte(jit, (unsigned char)bytes[i]);
+}
+
+void _Jit_byte(Jit* jit, int b)
+{
+	unsigned char c = (unsigned char)b;
+	Vector_add(&jit->code, &c);
+}
+
+void _Jit_int(Jit* jit, int v)
+{
+	_Jit_bytes(jit, (const char*)&v, sizeof(v));
+}
+
+void _Jit_pointer(Jit* jit, const void* p)
+{
+	_Jit_bytes(jit, (const char*)&p, sizeof(p));
+}
+
+//copy code of current chunk to executable memory
+void* _Jit_install(Jit* jit)
+{
+#ifdef JIT_X64
+	JitBlock block;
+	block.size = jit->code.size;
+	block.data = mmap(NULL, block.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (block.data == MAP_FAILED)
+		return NULL;
+
+	memcpy(block.data, jit->code.data, block.size);
+	if (mprotect(block.data, block.size, PROT_READ | PROT_EXEC) != 0)
+	{
+		munmap(block.data, block.size);
+		return NULL;
+	}
+
+	Vector_add(&jit->blocks, &block);
+	return block.data;
+#else
+	return NULL;
+#endif
+}
@@ -0,0 +1,46 @@
+#ifndef CLAM_JIT_H
+#define CLAM_JIT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "vector.h"
+#include "bytecode.h"
+
+//bytes of native stack used by compiled calls, less if thread stack is smaller,
+//deeper calls continue in interpreter, so recursion depth is limited by VM maxRegisters (--stack) as without jit
+#define JIT_MAX_STACK (4 * 1024 * 1024)
+
+struct VM;
+
+typedef int(*JitNative)(struct VM* vm, int base);
+
+//x86-64 machine code of chunks, compiled on first call
+//chunks which can not be compiled run by interpreter
+struct Jit
+{
+	const Program* program;
+	Vector natives;     //Vector<JitNative>, indexed by chunk, NULL if not compiled
+	Vector tried;       //Vector<bool>, compilation attempted
+	Vector blocks;      //Vector<JitBlock>, mapped executable memory
+	Vector code;        //Vector<unsigned char>, machine code of current chunk
+	Vector offsets;     //Vector<int>, code offset of each instruction
+	Vector jumps;       //Vector<JitJump>, rel32 to patch
+	Vector traps;       //Vector<JitJump>, division by zero checks
+	Vector overflows;   //Vector<JitJump>, register checks of calls
+	uintptr_t stackLimit; //native stack overflow below it
+	int depth;          //nested entries from interpreter
+	bool interpret;     //native stack used up, calls stay in interpreter
+};
+typedef struct Jit Jit;
+
+void Jit_init(Jit* jit);
+void Jit_destroy(Jit* jit);
+
+//bind to program before running, must be called again if program changes
+void Jit_prepare(Jit* jit, const Program* program);
+//forget nesting of a call aborted with error
+void Jit_reset(Jit* jit);
+int Jit_call(struct VM* vm, int chunk, int base);
+
+#endif
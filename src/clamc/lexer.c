@@ -1,6 +1,13 @@
 #include <string.h>
 #include <stdlib.h>
-#include <ctype.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define LEXER_SSE2
+#include <emmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
 
 #include "lexer.h"
 #include "message.h"
@@ -13,19 +20,74 @@ struct Keyword
 };
 typedef struct Keyword Keyword;
 
-static Keyword keywords[] =
+//sorted by length, keywords of one length are the candidates of a lookup
+enum _KeywordIndex
+{
+	KEYWORD_IF,
+	KEYWORD_INT,
+	KEYWORD_VOID,
+	KEYWORD_BOOL,
+	KEYWORD_TRUE,
+	KEYWORD_ELSE,
+	KEYWORD_FALSE,
+	KEYWORD_EXPORT,
+	KEYWORD_RETURN,
+	KEYWORD_COUNT,
+};
+
+#define KEYWORD_MAX_LENGTH 6
+
+static const Keyword keywords[] =
+{
+	[KEYWORD_IF    ] = { String_literal("if"    ), TOKEN_TYPE_KEYWORD,      TOKEN_VALUE_IF     },
+	[KEYWORD_INT   ] = { String_literal("int"   ), TOKEN_TYPE_KEYWORD_TYPE, TOKEN_VALUE_INT    },
+	[KEYWORD_VOID  ] = { String_literal("void"  ), TOKEN_TYPE_KEYWORD_TYPE, TOKEN_VALUE_VOID   },
+	[KEYWORD_BOOL  ] = { String_literal("bool"  ), TOKEN_TYPE_KEYWORD_TYPE, TOKEN_VALUE_BOOL   },
+	[KEYWORD_TRUE  ] = { String_literal("true"  ), TOKEN_TYPE_BOOL,         TOKEN_VALUE_TRUE   },
+	[KEYWORD_ELSE  ] = { String_literal("else"  ), TOKEN_TYPE_KEYWORD,      TOKEN_VALUE_ELSE   },
+	[KEYWORD_FALSE ] = { String_literal("false" ), TOKEN_TYPE_BOOL,         TOKEN_VALUE_FALSE  },
+	[KEYWORD_EXPORT] = { String_literal("export"), TOKEN_TYPE_KEYWORD,      TOKEN_VALUE_EXPORT },
+	[KEYWORD_RETURN] = { String_literal("return"), TOKEN_TYPE_KEYWORD,      TOKEN_VALUE_RETURN },
+};
+
+//first keyword of each length, keywords of length n are keywordStart[n] .. keywordStart[n + 1]
+static const unsigned char keywordStart[KEYWORD_MAX_LENGTH + 2] =
+{
+	[0] = KEYWORD_IF, [1] = KEYWORD_IF, [2] = KEYWORD_IF, [3] = KEYWORD_INT, [4] = KEYWORD_VOID,
+	[5] = KEYWORD_FALSE, [6] = KEYWORD_EXPORT, [7] = KEYWORD_COUNT,
+};
+
+//character class, C locale
+enum _CharClass
 {
-	{ String_literal("void"  ), TOKEN_TYPE_KEYWORD_TYPE, TOKEN_VALUE_VOID   },
-	{ String_literal("int"   ), TOKEN_TYPE_KEYWORD_TYPE, TOKEN_VALUE_INT    },
-	{ String_literal("bool"  ), TOKEN_TYPE_KEYWORD_TYPE, TOKEN_VALUE_BOOL   },
-	{ String_literal("true"  ), TOKEN_TYPE_BOOL,         TOKEN_VALUE_TRUE   },
-	{ String_literal("false" ), TOKEN_TYPE_BOOL,         TOKEN_VALUE_FALSE  },
-	{ String_literal("if"    ), TOKEN_TYPE_KEYWORD,      TOKEN_VALUE_IF     },
-	{ String_literal("else"  ), TOKEN_TYPE_KEYWORD,      TOKEN_VALUE_ELSE   },
-	{ String_literal("export"), TOKEN_TYPE_KEYWORD,      TOKEN_VALUE_EXPORT },
-	{ String_literal("return"), TOKEN_TYPE_KEYWORD,      TOKEN_VALUE_RETURN },
+	CHAR_CLASS_SPACE       = 1,
+	CHAR_CLASS_IDENT_START = 2,
+	CHAR_CLASS_DIGIT       = 4,
+	CHAR_CLASS_IDENT       = CHAR_CLASS_IDENT_START | CHAR_CLASS_DIGIT,
 };
 
+static const unsigned char charClass[256] =
+{
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 0, 0,  //0x00
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0x10
+	1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0x20
+	4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 0, 0, 0, 0, 0, 0,  //0x30
+	0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,  //0x40
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 2,  //0x50
+	0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,  //0x60
+	2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0,  //0x70
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0x80
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0x90
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0xA0
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0xB0
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0xC0
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0xD0
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0xE0
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,  //0xF0
+};
+
+static void _Lexer_loadToken(Lexer* lex);
+
 static bool _Lexer_isEof(Lexer* lex);
 static const char* _Lexer_peek(Lexer* lex);
 static const char* _Lexer_next(Lexer* lex);
@@ -37,6 +99,10 @@ static void _Lexer_parseOperator(Lexer* lex, TokenValue value);
 static void _Lexer_parseDelimiter(Lexer* lex, TokenValue value);
 static void _Lexer_parseLiteralString(Lexer* lex);
 static void _Lexer_parseKeyword(Lexer* lex);
+static const Keyword* _Lexer_findKeyword(String s);
+
+static int _Lexer_scanIdent(const char* s, long long size);
+static int _Lexer_scanSpace(const char* s, long long size, int* lines, int* lastLine);
 
 void Lexer_init(Lexer* lex, Source* source)
 {
@@ -45,13 +111,17 @@ void Lexer_init(Lexer* lex, Source* source)
 	lex->location.colum = 1;
 	Token_init(&lex->token, lex->location.filename);
 	lex->source = source;
+	TokenBuffer_init(&lex->buffer);
+	lex->cursor = 0;
+	lex->buffered = false;
+	lex->tokens = 0;
 
 	//Lexer_next(lex);
 }
 
 void Lexer_destroy(Lexer* lex)
 {
-	
+	TokenBuffer_destroy(&lex->buffer);
 }
 
 Token* Lexer_peek(Lexer* lex)
@@ -61,6 +131,13 @@ Token* Lexer_peek(Lexer* lex)
 
 Token* Lexer_next(Lexer* lex)
 {
+	if (lex->buffered)
+	{
+		_Lexer_loadToken(lex);
+		return &lex->token;
+	}
+
+	lex->tokens++;
 	do  //parse
 	{
 		_Lexer_skipSpace(lex);
@@ -71,18 +148,24 @@ Token* Lexer_next(Lexer* lex)
 			break;
 		}
 
-		char c = *_Lexer_peek(lex);
+		unsigned char c = *_Lexer_peek(lex);
+		unsigned char cls = charClass[c];
 
-		if (isalpha(c) || c == '_')
+		if (cls & CHAR_CLASS_IDENT_START)
 		{
 			_Lexer_parseIdent(lex);
+			break;
 		}
-		else if (isdigit(c))
+
+		if (cls & CHAR_CLASS_DIGIT)
 		{
 			_Lexer_parseNumber(lex);
+			break;
 		}
-		else if (c == '=')
+
+		switch (c)
 		{
+		case '=':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_ASSIGN);
 			c = *_Lexer_peek(lex);
 			if (c == '=')
@@ -91,9 +174,9 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '+')
-		{
+			break;
+
+		case '+':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_ADD);
 			c = *_Lexer_peek(lex);
 			if (c == '+')
@@ -108,9 +191,9 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '-')
-		{
+			break;
+
+		case '-':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_SUB);
 			c = *_Lexer_peek(lex);
 			if (c == '-')
@@ -125,9 +208,9 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '*')
-		{
+			break;
+
+		case '*':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_STAR);
 			c = *_Lexer_peek(lex);
 			if (c == '=')
@@ -136,9 +219,9 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '/')
-		{
+			break;
+
+		case '/':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_DIV);
 			c = *_Lexer_peek(lex);
 			if (c == '=')
@@ -147,9 +230,9 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '%')
-		{
+			break;
+
+		case '%':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_MOD);
 			c = *_Lexer_peek(lex);
 			if (c == '=')
@@ -158,9 +241,9 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '!')
-		{
+			break;
+
+		case '!':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_NOT);
 			c = *_Lexer_peek(lex);
 			if (c == '=')
@@ -169,9 +252,9 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '<')
-		{
+			break;
+
+		case '<':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_LT);
 			c = *_Lexer_peek(lex);
 			if (c == '=')
@@ -194,9 +277,9 @@ Token* Lexer_next(Lexer* lex)
 					_Lexer_next(lex);
 				}
 			}
-		}
-		else if (c == '>')
-		{
+			break;
+
+		case '>':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_GT);
 			c = *_Lexer_peek(lex);
 			if (c == '=')
@@ -219,9 +302,9 @@ Token* Lexer_next(Lexer* lex)
 					_Lexer_next(lex);
 				}
 			}
-		}
-		else if (c == '&')
-		{
+			break;
+
+		case '&':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_BITAND);
 			c = *_Lexer_peek(lex);
 			if (c == '&')
@@ -236,9 +319,9 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '|')
-		{
+			break;
+
+		case '|':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_BITOR);
 			c = *_Lexer_peek(lex);
 			if (c == '|')
@@ -253,9 +336,9 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '^')
-		{
+			break;
+
+		case '^':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_XOR);
 			c = *_Lexer_peek(lex);
 			if (c == '=')
@@ -264,49 +347,49 @@ Token* Lexer_next(Lexer* lex)
 				lex->token.literal.length++;
 				_Lexer_next(lex);
 			}
-		}
-		else if (c == '~')
-		{
+			break;
+
+		case '~':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_NEG);
-		}
-		else if (c == '?')
-		{
+			break;
+
+		case '?':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_QUES);
-		}
-		else if (c == ':')
-		{
+			break;
+
+		case ':':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_COLON);
-		}
-		else if (c == '(')
-		{
+			break;
+
+		case '(':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_LP);
-		}
-		else if (c == ')')
-		{
+			break;
+
+		case ')':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_RP);
-		}
-		else if (c == '{')
-		{
+			break;
+
+		case '{':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_LC);
-		}
-		else if (c == '}')
-		{
+			break;
+
+		case '}':
 			_Lexer_parseOperator(lex, TOKEN_VALUE_RC);
-		}
-		else if (c == ',')
-		{
+			break;
+
+		case ',':
 			_Lexer_parseDelimiter(lex, TOKEN_VALUE_COMMA);
-		}
-		else if (c == ';')
-		{
+			break;
+
+		case ';':
 			_Lexer_parseDelimiter(lex, TOKEN_VALUE_SEM);
-		}
-		else if (c == '"')
-		{
+			break;
+
+		case '"':
 			_Lexer_parseLiteralString(lex);
-		}
-		else
-		{
+			break;
+
+		default:
 			error(&lex->location, "unknown character '%c'", c);
 		}
 
@@ -315,6 +398,75 @@ Token* Lexer_next(Lexer* lex)
 	return &lex->token;
 }
 
+bool Lexer_prelex(Lexer* lex)
+{
+	if (Source_remain(lex->source) > 0xFFFFFFFFll)
+		return false;
+
+	SourceLocation start = lex->location;
+	const char* data = lex->source->data;
+
+	//roughly one token per 4 bytes
+	int cap = (int)(Source_remain(lex->source) / 4) + 1;
+	Vector_reserve(&lex->buffer.types, cap);
+	Vector_reserve(&lex->buffer.values, cap);
+	Vector_reserve(&lex->buffer.offsets, cap);
+	Vector_reserve(&lex->buffer.lengths, cap);
+	Vector_reserve(&lex->buffer.lines, cap);
+	Vector_reserve(&lex->buffer.colums, cap);
+
+	Token* token;
+	do
+	{
+		token = Lexer_next(lex);
+		TokenBuffer_add(&lex->buffer, token, data);
+	} while (token->value != TOKEN_VALUE_EOF);
+
+	lex->location = start;
+	Token_init(&lex->token, lex->location.filename);
+	lex->cursor = -1;
+	lex->buffered = true;
+	return true;
+}
+
+TokenValue Lexer_lookahead(Lexer* lex, int n)
+{
+	if (!lex->buffered)
+		fatal(&lex->location, "token lookahead requires pre-lexed source");
+
+	//stay on EOF at the end
+	int index = lex->cursor + n;
+	if (index < 0)
+		index = 0;
+	if (index >= lex->buffer.size)
+		index = lex->buffer.size - 1;
+
+	return ((unsigned char*)lex->buffer.values.data)[index];
+}
+
+int Lexer_keywordCount()
+{
+	return KEYWORD_COUNT;
+}
+
+String Lexer_keyword(int index)
+{
+	return keywords[index].literal;
+}
+
+void _Lexer_loadToken(Lexer* lex)
+{
+	if (lex->cursor < lex->buffer.size - 1)
+		lex->cursor++;
+	TokenBuffer_get(&lex->buffer, lex->cursor, lex->source->data, &lex->token);
+
+	//lexer location is the end of current token, as in streaming mode
+	lex->location.line = lex->token.location.line;
+	lex->location.colum = lex->token.location.colum + lex->token.literal.length;
+	if (lex->token.value == TOKEN_VALUE_LITERAL_STRING)
+		lex->location.colum += 2;
+}
+
 bool _Lexer_isEof(Lexer* lex)
 {
 	return Source_isEof(lex->source);
@@ -322,6 +474,8 @@ bool _Lexer_isEof(Lexer* lex)
 
 const char* _Lexer_peek(Lexer* lex)
 {
+	if (Source_isEof(lex->source))
+		return "";  //mapped source has no null terminal
 	return Source_peek(lex->source);
 }
 
@@ -341,22 +495,32 @@ const char* _Lexer_next(Lexer* lex)
 
 void _Lexer_skipSpace(Lexer* lex)
 {
-	while (!_Lexer_isEof(lex) && isspace(*_Lexer_peek(lex)))
-		_Lexer_next(lex);
+	int lines = 0;
+	int lastLine = 0;
+	int n = _Lexer_scanSpace(Source_peek(lex->source), Source_remain(lex->source), &lines, &lastLine);
+	Source_skip(lex->source, n);
+
+	//update location once for the whole run
+	if (lines)
+	{
+		lex->location.line += lines;
+		lex->location.colum = n - lastLine;
+	}
+	else
+	{
+		lex->location.colum += n;
+	}
 }
 
 void _Lexer_parseIdent(Lexer* lex)
 {
 	Token_reset(&lex->token, lex->location, TOKEN_TYPE_IDENT, TOKEN_VALUE_IDENT);
-	lex->token.literal.data = _Lexer_peek(lex);
+	lex->token.literal.data = Source_peek(lex->source);
+	lex->token.literal.length = _Lexer_scanIdent(lex->token.literal.data, Source_remain(lex->source));
 
-	const char* s;
-	do
-	{
-		lex->token.literal.length++;
-		_Lexer_next(lex);
-		s = _Lexer_peek(lex);
-	} while (!_Lexer_isEof(lex) && (isalnum(*s) || *s == '_'));
+	//identifier never contains newline
+	Source_skip(lex->source, lex->token.literal.length);
+	lex->location.colum += lex->token.literal.length;
 
 	_Lexer_parseKeyword(lex);
 }
@@ -364,18 +528,19 @@ void _Lexer_parseIdent(Lexer* lex)
 void _Lexer_parseNumber(Lexer* lex)
 {
 	Token_reset(&lex->token, lex->location, TOKEN_TYPE_INT, TOKEN_VALUE_LITERAL_INT);
-	lex->token.literal.data = _Lexer_peek(lex);
+	lex->token.literal.data = Source_peek(lex->source);
 
 	//TODO: support float bin hex oct and postfix
 
-	const char* s;
-	do
-	{
-		lex->token.literal.length++;
-		_Lexer_next(lex);
-		s = _Lexer_peek(lex);
-	} while (!_Lexer_isEof(lex) && isdigit(*s));
+	const char* s = lex->token.literal.data;
+	long long size = Source_remain(lex->source);
+	int n = 1;
+	while (n < size && (charClass[(unsigned char)s[n]] & CHAR_CLASS_DIGIT))
+		n++;
 
+	lex->token.literal.length = n;
+	Source_skip(lex->source, n);
+	lex->location.colum += n;
 }
 
 void _Lexer_parseOperator(Lexer* lex, TokenValue value)
@@ -387,19 +552,29 @@ void _Lexer_parseOperator(Lexer* lex, TokenValue value)
 
 void _Lexer_parseKeyword(Lexer* lex)
 {
-	//TODO: optimize to hash
-	for (int i = 0; i < sizeof(keywords) / sizeof(Keyword); i++)
+	const Keyword* kw = _Lexer_findKeyword(lex->token.literal);
+	if (kw)
 	{
-		Keyword* kw = &keywords[i];
-		if (String_equalsString(lex->token.literal, kw->literal))
-		{
-			lex->token.type  = kw->type;
-			lex->token.value = kw->value;
-			break;
-		}
+		lex->token.type  = kw->type;
+		lex->token.value = kw->value;
 	}
 }
 
+const Keyword* _Lexer_findKeyword(String s)
+{
+	if (s.length > KEYWORD_MAX_LENGTH)
+		return NULL;
+
+	//candidates of same length, first character rejects most of them without memcmp
+	for (int i = keywordStart[s.length]; i < keywordStart[s.length + 1]; ++i)
+	{
+		if (keywords[i].literal.data[0] == s.data[0] && memcmp(s.data + 1, keywords[i].literal.data + 1, s.length - 1) == 0)
+			return &keywords[i];
+	}
+
+	return NULL;
+}
+
 void _Lexer_parseDelimiter(Lexer* lex, TokenValue value)
 {
 	Token_reset(&lex->token, lex->location, TOKEN_TYPE_DELIMITER, value);
@@ -428,3 +603,94 @@ void _Lexer_parseLiteralString(Lexer* lex)
 		error(&lex->location, "missing termination \" charactor");
 }
 
+#ifdef LEXER_SSE2
+static int _Lexer_lowBit(unsigned int x)
+{
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward(&i, x);
+	return (int)i;
+#else
+	return __builtin_ctz(x);
+#endif
+}
+
+static int _Lexer_highBit(unsigned int x)
+{
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanReverse(&i, x);
+	return (int)i;
+#else
+	return 31 - __builtin_clz(x);
+#endif
+}
+
+//mask of bytes in [lo, hi], bytes >= 0x80 are negative and never match
+static __m128i _Lexer_range(__m128i v, char lo, char hi)
+{
+	return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+#endif
+
+int _Lexer_scanIdent(const char* s, long long size)
+{
+	int n = 1;  //first character is checked by caller
+
+#ifdef LEXER_SSE2
+	while (size - n >= 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(s + n));
+		__m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+		__m128i ident = _mm_or_si128(_mm_or_si128(_Lexer_range(lower, 'a', 'z'), _Lexer_range(v, '0', '9')), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(ident);
+		if (mask != 0xFFFF)
+			return n + _Lexer_lowBit(~mask);
+		n += 16;
+	}
+#endif
+
+	while (n < size && (charClass[(unsigned char)s[n]] & CHAR_CLASS_IDENT))
+		n++;
+	return n;
+}
+
+int _Lexer_scanSpace(const char* s, long long size, int* lines, int* lastLine)
+{
+	int n = 0;
+
+#ifdef LEXER_SSE2
+	while (size - n >= 16)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i*)(s + n));
+		__m128i space = _mm_or_si128(_Lexer_range(v, '\t', '\r'), _mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+		unsigned int mask = (unsigned int)_mm_movemask_epi8(space);
+		unsigned int newline = (unsigned int)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')));
+		int run = mask == 0xFFFF ? 16 : _Lexer_lowBit(~mask);
+
+		newline &= (1u << run) - 1;
+		if (newline)
+		{
+			*lastLine = n + _Lexer_highBit(newline);
+			for (; newline; newline &= newline - 1)
+				(*lines)++;
+		}
+
+		n += run;
+		if (run < 16)
+			return n;
+	}
+#endif
+
+	while (n < size && (charClass[(unsigned char)s[n]] & CHAR_CLASS_SPACE))
+	{
+		if (s[n] == '\n')
+		{
+			(*lines)++;
+			*lastLine = n;
+		}
+		n++;
+	}
+	return n;
+}
+
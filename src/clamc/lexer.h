@@ -8,6 +8,13 @@ struct Lexer {
 	SourceLocation location;
 	Token token;    //current token
 	Source* source;
+
+	//pre-lexed mode, Lexer_next walks the buffer instead of source
+	TokenBuffer buffer;
+	int cursor;      //index of current token
+	bool buffered;
+
+	long long tokens;  //tokens scanned from source, buffered tokens are not counted again
 };
 typedef struct Lexer Lexer;
 
@@ -16,4 +23,15 @@ void Lexer_destroy(Lexer* lex);
 Token* Lexer_peek(Lexer* lex);
 Token* Lexer_next(Lexer* lex);
 
+//lex whole source into token buffer, call before first Lexer_next
+//return false if source is too large for 32-bit token offsets
+bool Lexer_prelex(Lexer* lex);
+
+//value of the n-th token after current one, pre-lexed mode only
+TokenValue Lexer_lookahead(Lexer* lex, int n);
+
+//keyword table, every literal must be found as its keyword
+int Lexer_keywordCount();
+String Lexer_keyword(int index);
+
 #endif
\ No newline at end of file
@@ -1,23 +1,124 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <ctype.h>
+#include <setjmp.h>
+
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
 
 #include "source.h"
 #include "lexer.h"
 #include "parser.h"
 #include "executor.h"
 #include "analyzer.h"
+#include "compiler.h"
+#include "vm.h"
+#include "jit.h"
+#include "bench.h"
+#include "message.h"
+#include "thread.h"
+#include "cache.h"
+#include "serializer.h"
+#include "timer.h"
+#include "batch.h"
+#include "stats.h"
+#include "profile.h"
 
 #include "vector.h"
 #include "stack.h"
 
 static const char* ver = "v0.0.1";
 
+struct Options
+{
+	bool run;
+	bool ast;
+	bool jit;
+	int stack;
+	int benchLex;
+	bool prelex;
+	bool assembly;
+	bool unit;
+	bool emitModule;
+	int jobs;
+	int repeat;    //runs of main, split over jobs threads
+	const char* batch;    //exported function called for each row, NULL if disabled
+	const char* rows;     //batch input
+	const char* results;  //batch output, NULL for stdout
+	bool binary;          //batch rows and results are packed int32
+	bool timePasses;      //report phases of each file to stderr
+	const char* profile;  //collapsed stacks output of profiled run, NULL if disabled
+	int profileTop;       //rows of profile report
+	bool statsJson;
+	Cache* cache;  //NULL if disabled
+};
+typedef struct Options Options;
+
+//one input file, compiled independently of others
+struct Job
+{
+	const char* filename;
+	Options* options;
+	Rope output;  //generated text, written in input order after all jobs done
+	Rope errors;  //diagnostics, written to stderr after output of job
+	bool opened;
+	bool failed;  //stopped by error
+	Stats stats;  //phases, reported after all jobs done if --time-passes
+};
+typedef struct Job Job;
+
+struct Pool
+{
+	Job* jobs;
+	int count;
+	int next;  //next job to take
+	bool immediate;  //jobs print as they go on one thread, write their errors right after each job
+	Mutex lock;
+};
+typedef struct Pool Pool;
+
+//runs main on one thread by its own executor or vm, module and program are shared
+struct Runner
+{
+	Options* options;
+	const Module* module;
+	const Program* program;  //NULL to run by AST executor
+	int runs;
+	int result;
+	bool failed;              //stopped by error, first error of all runners is reported after join
+	SourceLocation location;  //of error, filename NULL if none
+	char message[256];
+};
+typedef struct Runner Runner;
+
 void usage()
 {
 	printf(
-		"usage: clamc [options] [file]\n"
+		"usage: clamc [options] [file...]\n"
 		"-r\trun code\n"
+		"--ast\trun code by AST interpreter instead of bytecode VM\n"
+		"--jit\tcompile bytecode functions to machine code on first call\n"
+		"--stack <n>\tmax stack values of interpreter\n"
+		"--bench-lex <n>\ttokenize file n times and report lexer throughput\n"
+		"--prelex\tlex whole file into token buffer before parsing\n"
+		"-S\tgenerate x86-64 assembly instead of C\n"
+		"-c\twrite C header and source of module to <module>.h and <module>.c\n"
+		"--emit-module\twrite analyzed module to <module>.cmod, which can be compiled or run like source\n"
+		"-j <n>\tcompile files by n threads, 0 for all cores, with --repeat run by n threads\n"
+		"--repeat <k>\trun main k times and report run throughput\n"
+		"--batch <f>\tcall exported function f for every row of --rows, by -j threads\n"
+		"--rows <file>\tbatch arguments, CSV with one row per line\n"
+		"--results <file>\twrite batch results to file instead of stdout\n"
+		"--binary\tbatch rows and results are packed int32 values instead of CSV\n"
+		"--profile <file>\trun by AST interpreter with profiling, write collapsed stacks for flamegraph.pl to file\n"
+		"--profile-top <n>\tfunctions and statements in profile report, default 10\n"
+		"--time-passes\treport wall time, cpu time, peak memory and counts of each phase\n"
+		"--stats[=json]\tsame as --time-passes, optionally as JSON\n"
+		"--cache <dir>\treuse generated output of unchanged files from dir\n"
 		"-h\tshow usage\n"
 		"-v\tshow version\n"
 	);
@@ -28,9 +129,49 @@ void version()
 	printf("clamc version %s\n", ver);
 }
 
+void work(void* arg);
+void report(void* user, const SourceLocation* loc, bool isError, const char* text);
+void compile(Job* job);
+void runRepeated(Options* opt, const Module* module, const Program* program);
+void runner(void* arg);
+void runMain(Runner* r);
+void reportRun(void* user, const SourceLocation* loc, bool isError, const char* text);
+void batch(Options* opt, const Module* module, const Program* program, Stats* stats);
+bool loadCached(Job* job, const CacheKey* key, const char* name);
+void writeUnit(const char* name, const char* ext, Rope* content);
+void writeProfile(Options* opt, Profile* prof);
+
+//module name from file name, characters not allowed in C identifier are replaced
+void unitName(const char* path, char* name, int size)
+{
+	const char* begin = path;
+	for (const char* p = path; *p; ++p)
+	{
+		if (*p == '/' || *p == '\\')
+			begin = p + 1;
+	}
+
+	const char* end = strrchr(begin, '.');
+	if (!end || end == begin)
+		end = begin + strlen(begin);
+
+	int len = 0;
+	if (begin < end && isdigit((unsigned char)*begin))
+		name[len++] = '_';
+	for (const char* p = begin; p < end && len < size - 1; ++p)
+		name[len++] = isalnum((unsigned char)*p) ? *p : '_';
+	name[len] = 0;
+}
+
 int main(int argc, char** argv)
 {
-	bool run = false;
+	Options opt;
+	memset(&opt, 0, sizeof(opt));
+	opt.jobs = 1;
+	opt.profileTop = 10;
+
+	Cache cache;
+	const char* cacheDir = NULL;
 
 	//options
 	--argc;
@@ -42,7 +183,90 @@ int main(int argc, char** argv)
 		else if (strcmp(*argv, "-v") == 0)
 			version();
 		else if (strcmp(*argv, "-r") == 0)
-			run = true;
+			opt.run = true;
+		else if (strcmp(*argv, "--ast") == 0)
+			opt.ast = true;
+		else if (strcmp(*argv, "--jit") == 0)
+			opt.jit = true;
+		else if (strcmp(*argv, "--stack") == 0 && argc > 1)
+		{
+			opt.stack = atoi(argv[1]);
+			--argc;
+			++argv;
+		}
+		else if (strcmp(*argv, "--prelex") == 0)
+			opt.prelex = true;
+		else if (strcmp(*argv, "-S") == 0)
+			opt.assembly = true;
+		else if (strcmp(*argv, "-c") == 0)
+			opt.unit = true;
+		else if (strcmp(*argv, "--emit-module") == 0)
+			opt.emitModule = true;
+		else if (strcmp(*argv, "-j") == 0 && argc > 1)
+		{
+			opt.jobs = atoi(argv[1]);
+			if (opt.jobs <= 0)
+				opt.jobs = Thread_cpuCount();
+			--argc;
+			++argv;
+		}
+		else if (strcmp(*argv, "--repeat") == 0 && argc > 1)
+		{
+			opt.repeat = atoi(argv[1]);
+			--argc;
+			++argv;
+		}
+		else if (strcmp(*argv, "--batch") == 0 && argc > 1)
+		{
+			opt.batch = argv[1];
+			--argc;
+			++argv;
+		}
+		else if (strcmp(*argv, "--rows") == 0 && argc > 1)
+		{
+			opt.rows = argv[1];
+			--argc;
+			++argv;
+		}
+		else if (strcmp(*argv, "--results") == 0 && argc > 1)
+		{
+			opt.results = argv[1];
+			--argc;
+			++argv;
+		}
+		else if (strcmp(*argv, "--binary") == 0)
+			opt.binary = true;
+		else if (strcmp(*argv, "--profile") == 0 && argc > 1)
+		{
+			opt.profile = argv[1];
+			--argc;
+			++argv;
+		}
+		else if (strcmp(*argv, "--profile-top") == 0 && argc > 1)
+		{
+			opt.profileTop = atoi(argv[1]);
+			--argc;
+			++argv;
+		}
+		else if (strcmp(*argv, "--time-passes") == 0 || strcmp(*argv, "--stats") == 0)
+			opt.timePasses = true;
+		else if (strcmp(*argv, "--stats=json") == 0)
+		{
+			opt.timePasses = true;
+			opt.statsJson = true;
+		}
+		else if (strcmp(*argv, "--cache") == 0 && argc > 1)
+		{
+			cacheDir = argv[1];
+			--argc;
+			++argv;
+		}
+		else if (strcmp(*argv, "--bench-lex") == 0 && argc > 1)
+		{
+			opt.benchLex = atoi(argv[1]);
+			--argc;
+			++argv;
+		}
 		else if ((*argv)[0] == '-')
 		{
 			printf("unknown options '%s'\n", *argv);
@@ -58,11 +282,200 @@ int main(int argc, char** argv)
 	if (!argc)
 		return 0;
 
+	if (opt.unit && opt.assembly)
+		error(NULL, "'-c' can not be used with '-S'");
+	if (opt.emitModule && (opt.run || opt.unit || opt.assembly))
+		error(NULL, "'--emit-module' can not be used with '-r', '-c' or '-S'");
+	if (opt.batch && (opt.run || opt.unit || opt.assembly || opt.emitModule))
+		error(NULL, "'--batch' can not be used with '-r', '-c', '-S' or '--emit-module'");
+	if (opt.batch && (!opt.rows || argc > 1))
+		error(NULL, "'--batch' needs '--rows' and one source file");
+	if (opt.profile && (!opt.run || opt.repeat > 1 || argc > 1))
+		error(NULL, "'--profile' needs '-r' and one source file, and can not be used with '--repeat'");
+	if (opt.profile)
+		opt.ast = true;  //profiler is in AST interpreter
+
+	if (cacheDir)
+	{
+		Cache_init(&cache, cacheDir);
+		opt.cache = &cache;
+	}
+
+	Pool pool;
+	pool.jobs = malloc(argc * sizeof(Job));
+	pool.count = argc;
+	pool.next = 0;
+	Mutex_init(&pool.lock);
+	if (!pool.jobs)
+		fatal(NULL, "out of memory");
+
+	for (int i = 0; i < argc; ++i)
+	{
+		pool.jobs[i].filename = argv[i];
+		pool.jobs[i].options = &opt;
+		pool.jobs[i].opened = false;
+		pool.jobs[i].failed = false;
+		Rope_init(&pool.jobs[i].output);
+		Rope_init(&pool.jobs[i].errors);
+		Stats_init(&pool.jobs[i].stats, argv[i]);
+	}
+
+	//running and benchmark print as they go, keep them on this thread in order
+	int threads = opt.run || opt.batch || opt.benchLex > 0 ? 1 : opt.jobs;
+	if (threads > argc)
+		threads = argc;
+	pool.immediate = threads == 1 && (opt.run || opt.batch || opt.benchLex > 0);
+
+	Thread* workers = malloc(threads * sizeof(Thread));
+	if (!workers)
+		fatal(NULL, "out of memory");
+
+	int started = 0;
+	for (int i = 1; i < threads; ++i)
+	{
+		if (!Thread_start(&workers[started], work, &pool))
+			break;
+		started++;
+	}
+	work(&pool);
+	for (int i = 0; i < started; ++i)
+		Thread_join(&workers[i]);
+
+	//merge outputs and errors in input order
+	int ret = 0;
+	for (int i = 0; i < argc; ++i)
+	{
+		Job* job = &pool.jobs[i];
+		if (!job->opened || job->failed)
+			ret = -1;
+		if (!job->opened && !job->failed)
+			printf("open '%s' failed\n", job->filename);
+		Rope_write(&job->output, stdout);
+		fflush(stdout);
+		Rope_write(&job->errors, stderr);
+		Rope_destroy(&job->output);
+		Rope_destroy(&job->errors);
+	}
+
+	//stats go to stderr, stdout may be generated code
+	if (opt.timePasses)
+	{
+		Rope report;
+		Rope_init(&report);
+		if (opt.statsJson)
+			Rope_append(&report, "[");
+		for (int i = 0; i < argc; ++i)
+		{
+			if (!pool.jobs[i].opened)
+				continue;
+			if (opt.statsJson && report.length > 1)
+				Rope_append(&report, ",\n");
+			Stats_print(&pool.jobs[i].stats, &report, opt.statsJson);
+		}
+		if (opt.statsJson)
+			Rope_append(&report, "]\n");
+		Rope_write(&report, stderr);
+		Rope_destroy(&report);
+	}
+
+	free(workers);
+	free(pool.jobs);
+	Mutex_destroy(&pool.lock);
+	if (opt.cache)
+		Cache_destroy(opt.cache);
+
+	return ret;
+}
+
+void work(void* arg)
+{
+	Pool* pool = arg;
+	for (;;)
+	{
+		Mutex_lock(&pool->lock);
+		int index = pool->next++;
+		Mutex_unlock(&pool->lock);
+
+		if (index >= pool->count)
+			return;
+
+		//error stops only its job, memory of a stopped job is left to process exit
+		Job* job = &pool->jobs[index];
+		MessageHandler handler;
+		handler.sink = report;
+		handler.user = job;
+		Message_push(&handler);
+
+		if (setjmp(handler.jump) != 0)
+			job->failed = true;
+		else
+			compile(job);
+
+		Message_pop(&handler);
+
+		if (pool->immediate)
+		{
+			fflush(stdout);
+			Rope_write(&job->errors, stderr);
+			Rope_destroy(&job->errors);
+			Rope_init(&job->errors);
+		}
+	}
+}
+
+void report(void* user, const SourceLocation* loc, bool isError, const char* text)
+{
+	Job* job = user;
+	const char* kind = isError ? "error" : "warnning";
+	if (loc && loc->filename)
+		Rope_appendFormat(&job->errors, "%s:%d:%d %s: %s\n", loc->filename, loc->line, loc->colum, kind, text);
+	else
+		Rope_appendFormat(&job->errors, "clamc: %s: %s\n", kind, text);
+}
+
+void compile(Job* job)
+{
+	Options* opt = job->options;
+	Stats* stats = opt->timePasses ? &job->stats : NULL;
+
 	Source src;
-	if (!Source_open(&src, *argv))
+	Stats_begin(stats, "open");
+	if (!Source_open(&src, job->filename))
+		return;
+	job->opened = true;
+	Stats_end(stats);
+	Stats_count(stats, "bytes", src.size);
+
+	if (opt->benchLex > 0)
 	{
-		printf("open '%s' failed\n", *argv);
-		return -1;
+		Bench_lex(&src, opt->benchLex, opt->prelex);
+		Source_destroy(&src);
+		return;
+	}
+
+	char name[256];
+	if (opt->unit || opt->emitModule)
+		unitName(src.name, name, sizeof(name));
+
+	//output of unchanged source is reused without compiling
+	CacheKey key;
+	bool cached = opt->cache && !opt->run && !opt->batch && !opt->emitModule;
+	if (cached)
+	{
+		char options[512];
+		snprintf(options, sizeof(options), "%s S=%d c=%s", opt->cache->build, opt->assembly, opt->unit ? name : "");
+		Cache_key(&key, src.data, src.size, options);
+
+		Stats_begin(stats, "cache");
+		bool hit = loadCached(job, &key, name);
+		Stats_end(stats);
+		Stats_count(stats, "hit", hit);
+
+		if (hit)
+		{
+			Source_destroy(&src);
+			return;
+		}
 	}
 
 	Lexer lex;
@@ -71,33 +484,426 @@ int main(int argc, char** argv)
 	Parser p;
 	Parser_init(&p);
 
-	Module* module = Parser_translate(&p, &lex);
+	Analyzer anly;
+	Analyzer_init(&anly);
+
+	//saved module is already analyzed, skip lexing and parsing
+	Module image;
+	Module_init(&image);
+
+	Module* module = &image;
+	if (Serializer_isImage(src.data, src.size))
+	{
+		Stats_begin(stats, "load");
+		if (!Serializer_load(&image, src.data, src.size))
+			error(NULL, "'%s' is not a valid module image", src.name);
+		Stats_end(stats);
+		Stats_countModule(stats, module);
+	}
+	else
+	{
+		if (opt->prelex)
+		{
+			Stats_begin(stats, "prelex");
+			if (!Lexer_prelex(&lex))
+				warning(NULL, "'%s' is too large to pre-lex, fallback to streaming lexer", src.name);
+			Stats_end(stats);
+			Stats_count(stats, "tokens", lex.tokens);
+		}
+
+		//streaming lexer runs inside parsing
+		long long tokens = lex.tokens;
+		Stats_begin(stats, "parse");
+		module = Parser_translate(&p, &lex);
+		Stats_end(stats);
+		Stats_count(stats, "tokens", lex.tokens - tokens);
+		Stats_countModule(stats, module);
+
+		Stats_begin(stats, "analyze");
+		Analyzer_analyze(&anly, module);
+		Stats_end(stats);
+		Stats_count(stats, "flat_expressions", module->flat.exprs.size);
+	}
+
+	if (opt->emitModule)
+	{
+		Stats_begin(stats, "emit-module");
+		Serializer ser;
+		Serializer_init(&ser);
+
+		Rope out;
+		Rope_init(&out);
+		Serializer_save(&ser, module, &out);
+		writeUnit(name, "cmod", &out);
+		Stats_end(stats);
+		Stats_count(stats, "bytes", out.length);
 
-	if (run)
+		Rope_destroy(&out);
+		Serializer_destroy(&ser);
+	}
+	else if (opt->batch && opt->ast)
+		batch(opt, module, NULL, stats);
+	else if (opt->run && opt->ast && opt->repeat > 1)
 	{
+		Stats_begin(stats, "run");
+		runRepeated(opt, module, NULL);
+		Stats_end(stats);
+		Stats_count(stats, "runs", opt->repeat);
+	}
+	else if (opt->run && opt->ast)
+	{
+		Stats_begin(stats, "run");
 		Executor exec;
 		Executor_init(&exec);
+		if (opt->stack > 0)
+			exec.maxStack = opt->stack;
+
+		Profile prof;
+		if (opt->profile)
+		{
+			Profile_init(&prof, module);
+			exec.profile = &prof;
+		}
+
 		Executor_run(&exec, module);
+
+		Executor_destroy(&exec);
+		Stats_end(stats);
+
+		if (opt->profile)
+		{
+			writeProfile(opt, &prof);
+			Profile_destroy(&prof);
+		}
 	}
-	else
+	else if (opt->run || opt->batch)
 	{
-		Analyzer anly;
-		Analyzer_init(&anly);
+		Program prog;
+		Program_init(&prog);
 
-		Analyzer_analyze(&anly, module);
+		Compiler c;
+		Compiler_init(&c);
+
+		Stats_begin(stats, "compile");
+		Compiler_compile(&c, module, &prog);
+		Stats_end(stats);
+		if (stats)
+		{
+			long long code = 0;
+			for (int i = 0; i < prog.chunks.size; ++i)
+				code += ((Chunk*)Vector_get(&prog.chunks, i))->code.size;
+			Stats_count(stats, "chunks", prog.chunks.size);
+			Stats_count(stats, "instructions", code);
+		}
+
+		if (opt->batch)
+			batch(opt, module, &prog, stats);
+		else if (opt->repeat > 1)
+		{
+			Stats_begin(stats, "run");
+			runRepeated(opt, module, &prog);
+			Stats_end(stats);
+			Stats_count(stats, "runs", opt->repeat);
+		}
+		else
+		{
+			Stats_begin(stats, "run");
+			Jit native;
+			Jit_init(&native);
+
+			VM vm;
+			VM_init(&vm);
+			if (opt->stack > 0)
+				vm.maxRegisters = opt->stack;
+			if (opt->jit)
+				vm.jit = &native;
+			VM_run(&vm, &prog);
 
+			VM_destroy(&vm);
+			Jit_destroy(&native);
+			Stats_end(stats);
+		}
+
+		Compiler_destroy(&c);
+		Program_destroy(&prog);
+	}
+	else
+	{
+		Stats_begin(stats, "generate");
 		Generator gen;
-		Generator_init(&gen, GENERATE_TARGE_C);
+		Generator_init(&gen, opt->assembly ? GENERATE_TARGE_X64 : GENERATE_TARGE_C);
+
+		if (opt->unit)
+		{
+			gen.unit.data = name;
+			gen.unit.length = strlen(name);
+		}
 
 		Generator_generate(&gen, module);
 
-		StringBuffer src;
-		StringBuffer_init(&src);
+		if (opt->unit)
+		{
+			Rope header;
+			Rope_init(&header);
+			Generator_getHeader(&gen, &header);
+
+			Rope source;
+			Rope_init(&source);
+			Generator_getSource(&gen, &source);
+			Stats_end(stats);
+			Stats_count(stats, "bytes", header.length + source.length);
 
-		Generator_getSource(&gen, &src);
+			Stats_begin(stats, "write");
+			if (cached)
+			{
+				Cache_store(opt->cache, &key, "h", &header);
+				Cache_store(opt->cache, &key, "c", &source);
+			}
 
-		printf(String_FMT, String_arg(src));
+			writeUnit(name, "h", &header);
+			writeUnit(name, "c", &source);
+			Stats_end(stats);
+
+			Rope_destroy(&header);
+			Rope_destroy(&source);
+		}
+		else
+		{
+			Generator_getSource(&gen, &job->output);
+			Stats_end(stats);
+			Stats_count(stats, "bytes", job->output.length);
+
+			if (cached)
+			{
+				Stats_begin(stats, "write");
+				Cache_store(opt->cache, &key, "out", &job->output);
+				Stats_end(stats);
+			}
+		}
+
+		Generator_destroy(&gen);
+	}
+
+	//module nodes reference source text, release source last
+	Module_destroy(&image);
+	Analyzer_destroy(&anly);
+	Parser_destroy(&p);
+	Lexer_destroy(&lex);
+	Source_destroy(&src);
+}
+
+void runRepeated(Options* opt, const Module* module, const Program* program)
+{
+	if (program && program->main < 0)
+		error(NULL, "function 'main' not found");
+
+	int threads = opt->jobs < opt->repeat ? opt->jobs : opt->repeat;
+	Runner* runners = malloc(threads * sizeof(Runner));
+	Thread* workers = malloc(threads * sizeof(Thread));
+	if (!runners || !workers)
+		fatal(NULL, "out of memory");
+
+	for (int i = 0; i < threads; ++i)
+	{
+		runners[i].options = opt;
+		runners[i].module = module;
+		runners[i].program = program;
+		runners[i].runs = opt->repeat / threads + (i < opt->repeat % threads);
+		runners[i].result = 0;
+		runners[i].failed = false;
+	}
+
+	double beg = Timer_now();
+
+	//this thread takes the first share, runs of threads failed to start are added to it
+	int started = 0;
+	for (int i = 1; i < threads; ++i)
+	{
+		if (!Thread_start(&workers[i], runner, &runners[i]))
+		{
+			for (int j = i; j < threads; ++j)
+				runners[0].runs += runners[j].runs;
+			break;
+		}
+		started++;
+	}
+	runner(&runners[0]);
+	for (int i = 1; i <= started; ++i)
+		Thread_join(&workers[i]);
+
+	double elapsed = Timer_now() - beg;
+	if (elapsed <= 0)
+		elapsed = 1e-9;
+
+	for (int i = 0; i < threads; ++i)
+	{
+		if (runners[i].failed)
+		{
+			SourceLocation loc = runners[i].location;
+			char message[sizeof(runners[i].message)];
+			strcpy(message, runners[i].message);
+			free(workers);
+			free(runners);
+			error(loc.filename ? &loc : NULL, "%s", message);
+		}
 	}
 
-	return 0;
-}
\ No newline at end of file
+	printf("main return %d\n", runners[0].result);
+	printf("runs: %d by %d threads in %.3f ms, %.0f runs/s\n", opt->repeat, started + 1, elapsed * 1000, opt->repeat / elapsed);
+
+	free(workers);
+	free(runners);
+}
+
+void runner(void* arg)
+{
+	Runner* r = arg;
+
+	//error stops only this runner, memory of a stopped runner is left to process exit
+	MessageHandler handler;
+	handler.sink = reportRun;
+	handler.user = r;
+	Message_push(&handler);
+
+	if (setjmp(handler.jump) != 0)
+		r->failed = true;
+	else
+		runMain(r);
+
+	Message_pop(&handler);
+}
+
+void runMain(Runner* r)
+{
+	Options* opt = r->options;
+
+	if (!r->program)
+	{
+		Executor exec;
+		Executor_init(&exec);
+		if (opt->stack > 0)
+			exec.maxStack = opt->stack;
+
+		for (int i = 0; i < r->runs; ++i)
+			r->result = Executor_execute(&exec, r->module);
+
+		Executor_destroy(&exec);
+		return;
+	}
+
+	Jit native;
+	Jit_init(&native);
+
+	VM vm;
+	VM_init(&vm);
+	if (opt->stack > 0)
+		vm.maxRegisters = opt->stack;
+	if (opt->jit)
+		vm.jit = &native;
+
+	for (int i = 0; i < r->runs; ++i)
+	{
+		VM_load(&vm, r->program);
+		r->result = VM_call(&vm, r->program->main, NULL, 0);
+	}
+
+	VM_destroy(&vm);
+	Jit_destroy(&native);
+}
+
+void reportRun(void* user, const SourceLocation* loc, bool isError, const char* text)
+{
+	//running reports errors only, each stops its runner
+	Runner* r = user;
+	if (!isError)
+		return;
+
+	r->location = loc ? *loc : (SourceLocation){ NULL, 0, 0 };
+	snprintf(r->message, sizeof(r->message), "%s", text);
+}
+
+void batch(Options* opt, const Module* module, const Program* program, Stats* stats)
+{
+	Batch b;
+	Batch_init(&b, module, program, opt->batch);
+	b.jit = opt->jit;
+	b.stack = opt->stack;
+
+	Stats_begin(stats, "rows");
+	Batch_load(&b, opt->rows, opt->binary);
+	Stats_end(stats);
+	Stats_count(stats, "rows", b.rows.size / b.argc);
+
+	Stats_begin(stats, "batch");
+	Batch_run(&b, opt->jobs);
+	Stats_end(stats);
+
+	FILE* out = stdout;
+	if (opt->results)
+	{
+		out = fopen(opt->results, opt->binary ? "wb" : "w");
+		if (!out)
+			error(NULL, "open '%s' failed", opt->results);
+	}
+#ifdef _WIN32
+	else if (opt->binary)
+		_setmode(_fileno(stdout), _O_BINARY);
+#endif
+
+	Stats_begin(stats, "write");
+	Batch_write(&b, out, opt->binary);
+
+	if (out != stdout && fclose(out) != 0)
+		error(NULL, "write '%s' failed", opt->results);
+	Stats_end(stats);
+	Batch_destroy(&b);
+}
+
+bool loadCached(Job* job, const CacheKey* key, const char* name)
+{
+	Cache* cache = job->options->cache;
+	if (!job->options->unit)
+		return Cache_load(cache, key, "out", &job->output);
+
+	Rope header;
+	Rope_init(&header);
+
+	Rope source;
+	Rope_init(&source);
+
+	bool hit = Cache_load(cache, key, "h", &header) && Cache_load(cache, key, "c", &source);
+	if (hit)
+	{
+		writeUnit(name, "h", &header);
+		writeUnit(name, "c", &source);
+	}
+
+	Rope_destroy(&header);
+	Rope_destroy(&source);
+	return hit;
+}
+
+void writeUnit(const char* name, const char* ext, Rope* content)
+{
+	char path[300];
+	snprintf(path, sizeof(path), "%s.%s", name, ext);
+	if (!Rope_writeFile(content, path))
+		error(NULL, "write '%s' failed", path);
+}
+
+void writeProfile(Options* opt, Profile* prof)
+{
+	Rope stacks;
+	Rope_init(&stacks);
+	Profile_writeStacks(prof, &stacks);
+	if (!Rope_writeFile(&stacks, opt->profile))
+		error(NULL, "write '%s' failed", opt->profile);
+	Rope_destroy(&stacks);
+
+	//report goes to stderr like stats, stdout has main return
+	Rope report;
+	Rope_init(&report);
+	Profile_report(prof, &report, opt->profileTop);
+	Rope_write(&report, stderr);
+	Rope_destroy(&report);
+}
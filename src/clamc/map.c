@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "map.h"
+#include "message.h"
+
+static MapEntry* _Map_find(MapEntry* entries, int cap, String key, unsigned int hash);
+static void _Map_grow(Map* map);
+
+void Map_init(Map* map)
+{
+	map->entries = NULL;
+	map->size = 0;
+	map->cap = 0;
+}
+
+void Map_destroy(Map* map)
+{
+	free(map->entries);
+	Map_init(map);
+}
+
+bool Map_put(Map* map, String key, void* value)
+{
+	if ((map->size + 1) * 2 > map->cap)  //keep load factor under 0.5
+		_Map_grow(map);
+
+	unsigned int hash = String_hash(key);
+	MapEntry* entry = _Map_find(map->entries, map->cap, key, hash);
+	if (entry->value)
+		return false;
+
+	entry->key = key;
+	entry->hash = hash;
+	entry->value = value;
+	map->size++;
+	return true;
+}
+
+void* Map_get(const Map* map, String key)
+{
+	if (!map->size)
+		return NULL;
+
+	return _Map_find(map->entries, map->cap, key, String_hash(key))->value;
+}
+
+MapEntry* _Map_find(MapEntry* entries, int cap, String key, unsigned int hash)
+{
+	unsigned int mask = cap - 1;
+	for (unsigned int i = hash & mask; ; i = (i + 1) & mask)  //linear probing
+	{
+		MapEntry* entry = &entries[i];
+		if (!entry->value)
+			return entry;
+		if (entry->hash == hash && String_equalsString(entry->key, key))
+			return entry;
+	}
+}
+
+void _Map_grow(Map* map)
+{
+	int cap = map->cap ? map->cap * 2 : 16;
+	MapEntry* entries = calloc(cap, sizeof(MapEntry));
+	if (!entries)
+		error(NULL, "out of memory");
+
+	for (int i = 0; i < map->cap; ++i)  //rehash
+	{
+		MapEntry* entry = &map->entries[i];
+		if (entry->value)
+			*_Map_find(entries, cap, entry->key, entry->hash) = *entry;
+	}
+
+	free(map->entries);
+	map->entries = entries;
+	map->cap = cap;
+}
@@ -0,0 +1,31 @@
+#ifndef CLAM_MAP_H
+#define CLAM_MAP_H
+
+#include <stdbool.h>
+
+#include "strings.h"
+
+struct MapEntry
+{
+	String key;
+	unsigned int hash;
+	void* value;  //NULL means empty entry
+};
+typedef struct MapEntry MapEntry;
+
+//open addressing hash map, String -> pointer
+struct Map
+{
+	MapEntry* entries;
+	int size;
+	int cap;  //power of 2
+};
+typedef struct Map Map;
+
+void Map_init(Map* map);
+void Map_destroy(Map* map);
+
+bool Map_put(Map* map, String key, void* value);  //keep existed value and return false if key existed
+void* Map_get(const Map* map, String key);
+
+#endif
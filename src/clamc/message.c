@@ -4,34 +4,75 @@
 
 #include "message.h"
 
-void warning(SourceLocation* loc, const char* fmt, ...)
+#ifdef _MSC_VER
+#define MESSAGE_THREAD_LOCAL __declspec(thread)
+#else
+#define MESSAGE_THREAD_LOCAL _Thread_local
+#endif
+
+#define MESSAGE_MAX_TEXT 1024
+
+static MESSAGE_THREAD_LOCAL MessageHandler* handler;
+
+static void _Message_report(const SourceLocation* loc, bool isError, const char* fmt, va_list vp);
+
+void Message_push(MessageHandler* h)
+{
+	h->prev = handler;
+	handler = h;
+}
+
+void Message_pop(MessageHandler* h)
+{
+	if (handler == h)
+		handler = h->prev;
+}
+
+void warning(const SourceLocation* loc, const char* fmt, ...)
 {
 	va_list vp;
 	va_start(vp, fmt);
-	(loc && loc->filename) ? fprintf(stderr, "%s:%d:%d warnning: ", loc->filename, loc->line, loc->colum) : fprintf(stderr, "clamc: warnning: ");
-	vfprintf(stderr, fmt, vp);
-	fprintf(stderr, "\n");
+	_Message_report(loc, false, fmt, vp);
 	va_end(vp);
 }
 
-void error(SourceLocation* loc, const char* fmt, ...)
+void error(const SourceLocation* loc, const char* fmt, ...)
 {
 	va_list vp;
 	va_start(vp, fmt);
-	(loc && loc->filename) ? fprintf(stderr, "%s:%d:%d error: ", loc->filename, loc->line, loc->colum) : fprintf(stderr, "clamc: error: ");
-	vfprintf(stderr, fmt, vp);
-	fprintf(stderr, "\n");
+	_Message_report(loc, true, fmt, vp);
 	va_end(vp);
+
+	if (handler)
+		longjmp(handler->jump, 1);
 	exit(-1);
 }
 
-void fatal(SourceLocation* loc, const char* fmt, ...)
+void fatal(const SourceLocation* loc, const char* fmt, ...)
 {
 	va_list vp;
 	va_start(vp, fmt);
-	(loc && loc->filename) ? fprintf(stderr, "%s:%d:%d error: ", loc->filename, loc->line, loc->colum) : fprintf(stderr, "clamc: error: ");
-	vfprintf(stderr, fmt, vp);
-	fprintf(stderr, "\n");
+	_Message_report(loc, true, fmt, vp);
 	va_end(vp);
+
+	if (handler)
+		longjmp(handler->jump, 1);
 	exit(-1);
 }
+
+void _Message_report(const SourceLocation* loc, bool isError, const char* fmt, va_list vp)
+{
+	if (handler)
+	{
+		char text[MESSAGE_MAX_TEXT];
+		vsnprintf(text, sizeof(text), fmt, vp);
+		if (handler->sink)
+			handler->sink(handler->user, loc, isError, text);
+		return;
+	}
+
+	const char* kind = isError ? "error" : "warnning";
+	(loc && loc->filename) ? fprintf(stderr, "%s:%d:%d %s: ", loc->filename, loc->line, loc->colum, kind) : fprintf(stderr, "clamc: %s: ", kind);
+	vfprintf(stderr, fmt, vp);
+	fprintf(stderr, "\n");
+}
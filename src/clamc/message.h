@@ -1,10 +1,30 @@
 #ifndef CLAM_MESSAGE_H
 #define CLAM_MESSAGE_H
 
+#include <setjmp.h>
+#include <stdbool.h>
+
 #include "source_location.h"
 
-void warning(SourceLocation* location, const char* fmt, ...);
-void error(SourceLocation* location, const char* fmt, ...);
-void fatal(SourceLocation* location, const char* fmt, ...);
+//receives formatted diagnostic text without location prefix
+typedef void(*MessageSink)(void* user, const SourceLocation* location, bool isError, const char* text);
+
+//diagnostics of current thread go to innermost pushed handler,
+//error and fatal long jump to its jump buffer instead of exit
+struct MessageHandler
+{
+	MessageSink sink;
+	void* user;
+	jmp_buf jump;
+	struct MessageHandler* prev;
+};
+typedef struct MessageHandler MessageHandler;
+
+void Message_push(MessageHandler* handler);
+void Message_pop(MessageHandler* handler);
+
+void warning(const SourceLocation* location, const char* fmt, ...);
+void error(const SourceLocation* location, const char* fmt, ...);
+void fatal(const SourceLocation* location, const char* fmt, ...);
 
-#endif
\ No newline at end of file
+#endif
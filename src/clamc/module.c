@@ -5,12 +5,18 @@ void Module_init(Module* mod)
 {
 	Vector_init(&mod->declarations, sizeof(Declaration));
 	Vector_init(&mod->functions, sizeof(Declaration));
+	Map_init(&mod->functionMap);
+	Arena_init(&mod->arena);
+	FlatCode_init(&mod->flat);
 }
 
 void Module_destroy(Module* mod)
 {
 	Vector_destroy(&mod->declarations);
 	Vector_destroy(&mod->functions);
+	Map_destroy(&mod->functionMap);
+	Arena_destroy(&mod->arena);  //release all nodes and their lists at once
+	FlatCode_destroy(&mod->flat);
 }
 
 void Module_addDeclaration(Module* mod, Declaration* decl)
@@ -18,4 +24,19 @@ void Module_addDeclaration(Module* mod, Declaration* decl)
 	Vector_add(&mod->declarations, decl);
 	if (decl->type == DECL_TYPE_FUNCTION)
 		Vector_add(&mod->functions, decl);
-}
\ No newline at end of file
+}
+
+void Module_buildFunctionMap(Module* mod)
+{
+	//functions vector not grow any more, declaration pointers are stable
+	for (int i = 0; i < mod->functions.size; ++i)
+	{
+		Declaration* decl = Vector_get(&mod->functions, i);
+		Map_put(&mod->functionMap, decl->function.name, decl);  //first definition wins
+	}
+}
+
+Declaration* Module_findFunction(const Module* mod, String name)
+{
+	return Map_get(&mod->functionMap, name);
+}
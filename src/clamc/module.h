@@ -3,16 +3,25 @@
 
 #include "ast.h"
 #include "vector.h"
+#include "map.h"
+#include "arena.h"
+#include "flat.h"
 
+//an analyzed module is not modified by running it, executors only read it
 struct Module
 {
 	Vector declarations;
 	Vector functions;
+	Map functionMap;  //Map<String, Declaration*>, built after all declarations added
+	Arena arena;      //all expression and statement nodes
+	FlatCode flat;    //expressions evaluated by executor, built after analyzing
 };
 typedef struct Module Module;
 
 void Module_init(Module* mod);
 void Module_destroy(Module* mod);
 void Module_addDeclaration(Module* mod, Declaration* decl);
+void Module_buildFunctionMap(Module* mod);
+Declaration* Module_findFunction(const Module* mod, String name);
 
 #endif
\ No newline at end of file
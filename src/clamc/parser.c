@@ -30,27 +30,35 @@ static Expression* _Parser_primaryExpression(Parser* p);
 static Token* _Parser_until(Parser* p, TokenValue value, const char* msg);
 static Token* _Parser_expect(Parser* p, TokenValue value, const char* msg);
 
+static void _Parser_listAdd(Parser* p, const void* elem, int elemSize);
+static Vector _Parser_listEnd(Parser* p, int begin, int elemSize);
+
 
 bool Parser_init(Parser* p)
 {
 	Module_init(&p->module);
 	p->lex = NULL;
+	Vector_init(&p->scratch, 1);
 	return true;
 }
 
 void Parser_destroy(Parser* p)
 {
 	Module_destroy(&p->module);
+	Vector_destroy(&p->scratch);
 }
 
 Module* Parser_translate(Parser* p, Lexer* lex)
 {
 	p->lex = lex;
+	p->scratch.size = 0;
 
 	Lexer_next(p->lex);
 	while (Lexer_peek(p->lex)->value != TOKEN_VALUE_EOF)
 		_Parser_toplevel(p);
 
+	Module_buildFunctionMap(&p->module);
+
 	p->lex = NULL;
 	return &p->module;
 }
@@ -113,7 +121,7 @@ Declaration _Parser_declaration(Parser* p)
 		_Parser_expect(p, TOKEN_VALUE_SEM, "expected ';'");
 		break;
 
-	default:
+	default:
 		error(&token->location, "unexpected '" String_FMT "'", String_arg(token->literal));
 	}
 
@@ -156,8 +164,7 @@ Type _Parser_typeDesc(Parser* p)
 
 Vector _Parser_parameterList(Parser* p)
 {
-	Vector list;
-	Vector_init(&list, sizeof(Parameter));
+	int begin = p->scratch.size;
 
 	Token* token = Lexer_peek(p->lex);
 	Lexer_next(p->lex);
@@ -176,7 +183,7 @@ Vector _Parser_parameterList(Parser* p)
 		param.name = token->literal;
 		Lexer_next(p->lex);
 
-		Vector_add(&list, &param);
+		_Parser_listAdd(p, &param, sizeof(Parameter));
 
 		if (token->value == TOKEN_VALUE_COMMA)
 			Lexer_next(p->lex);
@@ -185,7 +192,7 @@ Vector _Parser_parameterList(Parser* p)
 	}
 	_Parser_expect(p, TOKEN_VALUE_RP, "expected ')'");
 
-	return list;
+	return _Parser_listEnd(p, begin, sizeof(Parameter));
 }
 
 Vector _Parser_compoundStatement(Parser* p)
@@ -193,8 +200,7 @@ Vector _Parser_compoundStatement(Parser* p)
 	Token* token = Lexer_peek(p->lex);
 	_Parser_expect(p, TOKEN_VALUE_LC, "expected '{'");
 
-	Vector cs;
-	Vector_init(&cs, sizeof(Statement));
+	int begin = p->scratch.size;
 
 	Statement stat;
 	Statement_init(&stat);
@@ -203,13 +209,13 @@ Vector _Parser_compoundStatement(Parser* p)
 	while (token->value != TOKEN_VALUE_EOF && token->value != TOKEN_VALUE_RC)
 	{
 		stat = _Parser_statement(p);
-		Vector_add(&cs, &stat);
+		_Parser_listAdd(p, &stat, sizeof(Statement));
 	}
 
 	_Parser_expect(p, TOKEN_VALUE_RC, "expected '}'");
 	Lexer_next(p->lex);
 
-	return cs;
+	return _Parser_listEnd(p, begin, sizeof(Statement));
 }
 
 Statement _Parser_statement(Parser* p)
@@ -237,14 +243,14 @@ Statement _Parser_statement(Parser* p)
 		_Parser_expect(p, TOKEN_VALUE_RP, "expected ')'");
 		Lexer_next(p->lex);
 
-		stat.ifStat.statement = Statement_alloc(sizeof(Statement));
+		stat.ifStat.statement = Statement_alloc(&p->module.arena);
 		*stat.ifStat.statement = _Parser_statement(p);
 
 		token = Lexer_peek(p->lex);
 		if (token->value == TOKEN_VALUE_ELSE)
 		{
 			Lexer_next(p->lex);
-			stat.ifStat.elseStat = Statement_alloc(sizeof(Statement));
+			stat.ifStat.elseStat = Statement_alloc(&p->module.arena);
 			*stat.ifStat.elseStat = _Parser_statement(p);
 		}
 
@@ -402,7 +408,7 @@ Expression* _Parser_conditionExpression(Parser* p)
 	if (token->value != TOKEN_VALUE_QUES)
 		return cond;
 
-	Expression* expr = Expression_create(EXPR_TYPE_COND, &loc);
+	Expression* expr = Expression_create(&p->module.arena, EXPR_TYPE_COND, &loc);
 	expr->condExpr.expr1 = cond;
 
 	Lexer_next(p->lex);
@@ -428,7 +434,7 @@ Expression* _Parser_logicOrExpression(Parser* p)
 	{
 		Lexer_next(p->lex);
 		Expression* right = _Parser_logicAndExpression(p);
-		left = Expression_createBinary(&loc, EXPR_TYPE_OR, left, right);
+		left = Expression_createBinary(&p->module.arena, &loc, EXPR_TYPE_OR, left, right);
 		token = Lexer_peek(p->lex);
 		loc = token->location;
 	}
@@ -448,7 +454,7 @@ Expression* _Parser_logicAndExpression(Parser* p)
 	{
 		Lexer_next(p->lex);
 		Expression* right = _Parser_equalityExpression(p);
-		left = Expression_createBinary(&loc, EXPR_TYPE_AND, left, right);
+		left = Expression_createBinary(&p->module.arena, &loc, EXPR_TYPE_AND, left, right);
 		token = Lexer_peek(p->lex);
 		loc = token->location;
 	}
@@ -481,7 +487,7 @@ Expression* _Parser_equalityExpression(Parser* p)
 		Lexer_next(p->lex);
 
 		Expression* right = _Parser_relationExpression(p);
-		left = Expression_createBinary(&loc, exprType, left, right);
+		left = Expression_createBinary(&p->module.arena, &loc, exprType, left, right);
 		token = Lexer_peek(p->lex);
 		loc = token->location;
 	}
@@ -525,7 +531,7 @@ Expression* _Parser_relationExpression(Parser* p)
 		Lexer_next(p->lex);
 
 		Expression* right = _Parser_additiveExpression(p);
-		left = Expression_createBinary(&loc, exprType, left, right);
+		left = Expression_createBinary(&p->module.arena, &loc, exprType, left, right);
 		token = Lexer_peek(p->lex);
 		loc = token->location;
 	}
@@ -557,7 +563,7 @@ Expression* _Parser_additiveExpression(Parser* p)
 		Lexer_next(p->lex);
 
 		Expression* right = _Parser_multiplicativeExpression(p);
-		left = Expression_createBinary(&loc, exprType, left, right);
+		left = Expression_createBinary(&p->module.arena, &loc, exprType, left, right);
 		token = Lexer_peek(p->lex);
 		loc = token->location;
 	}
@@ -595,7 +601,7 @@ Expression* _Parser_multiplicativeExpression(Parser* p)
 		Lexer_next(p->lex);
 
 		Expression* right = _Parser_bitopExpression(p);
-		left = Expression_createBinary(&loc, exprType, left, right);
+		left = Expression_createBinary(&p->module.arena, &loc, exprType, left, right);
 		token = Lexer_peek(p->lex);
 		loc = token->location;
 	}
@@ -633,7 +639,7 @@ Expression* _Parser_bitopExpression(Parser* p)
 		Lexer_next(p->lex);
 
 		Expression* right = _Parser_bitShiftExpression(p);
-		left = Expression_createBinary(&loc, exprType, left, right);
+		left = Expression_createBinary(&p->module.arena, &loc, exprType, left, right);
 		token = Lexer_peek(p->lex);
 		loc = token->location;
 	}
@@ -666,7 +672,7 @@ Expression* _Parser_bitShiftExpression(Parser* p)
 		Lexer_next(p->lex);
 
 		Expression* right = _Parser_unaryExpression(p);
-		left = Expression_createBinary(&loc, exprType, left, right);
+		left = Expression_createBinary(&p->module.arena, &loc, exprType, left, right);
 		token = Lexer_peek(p->lex);
 		loc = token->location;		
 	}
@@ -705,7 +711,7 @@ Expression* _Parser_unaryExpression(Parser* p)
 	Lexer_next(p->lex);
 
 	Expression* right = _Parser_unaryExpression(p);
-	return Expression_createUnary(&loc, exprType, right);
+	return Expression_createUnary(&p->module.arena, &loc, exprType, right);
 }
 
 Expression* _Parser_postfixExpression(Parser* p)
@@ -722,7 +728,7 @@ Expression* _Parser_postfixExpression(Parser* p)
 		switch (token->value)
 		{
 		case TOKEN_VALUE_LP:
-			expr = Expression_createCall(&loc, expr);
+			expr = Expression_createCall(&p->module.arena, &loc, expr);
 			expr->callExpr.args = _Parser_argumentList(p);
 			break;
 		}
@@ -739,18 +745,18 @@ Expression* _Parser_primaryExpression(Parser* p)
 	switch (token->value)
 	{
 	case TOKEN_VALUE_LITERAL_INT:
-		expr = Expression_createLiteral(EXPR_TYPE_INT, token);
+		expr = Expression_createLiteral(&p->module.arena, EXPR_TYPE_INT, token);
 		Lexer_next(p->lex);
 		break;
 
 	case TOKEN_VALUE_TRUE:
 	case TOKEN_VALUE_FALSE:
-		expr = Expression_createLiteral(EXPR_TYPE_BOOL, token);
+		expr = Expression_createLiteral(&p->module.arena, EXPR_TYPE_BOOL, token);
 		Lexer_next(p->lex);
 		break;
 
 	case TOKEN_VALUE_IDENT:
-		expr = Expression_createIdent(&token->location, token);
+		expr = Expression_createIdent(&p->module.arena, &token->location, token);
 		Lexer_next(p->lex);
 		break;
 
@@ -760,6 +766,10 @@ Expression* _Parser_primaryExpression(Parser* p)
 		_Parser_expect(p, TOKEN_VALUE_RP, "expected ')'");
 		Lexer_next(p->lex);
 		break;
+
+	default:
+		error(&token->location, "expected expression");
+		break;
 	}
 
 	return expr;
@@ -770,14 +780,13 @@ Vector _Parser_argumentList(Parser* p)
 	_Parser_expect(p, TOKEN_VALUE_LP, "expected '('");
 	Lexer_next(p->lex);
 
-	Vector list;
-	Vector_init(&list, sizeof(Expression));
+	int begin = p->scratch.size;
 
 	Token* token = Lexer_peek(p->lex);
 	while (token->value != TOKEN_VALUE_EOF && token->value != TOKEN_VALUE_RP)
 	{
 		Expression* expr = _Parser_expression(p);
-		Vector_add(&list, expr);
+		_Parser_listAdd(p, expr, sizeof(Expression));
 
 		token = Lexer_peek(p->lex);
 		if (token->value == TOKEN_VALUE_COMMA)
@@ -789,7 +798,7 @@ Vector _Parser_argumentList(Parser* p)
 	_Parser_expect(p, TOKEN_VALUE_RP, "expected ')'");
 	Lexer_next(p->lex);
 
-	return list;
+	return _Parser_listEnd(p, begin, sizeof(Expression));
 }
 
 Token* _Parser_until(Parser* p, TokenValue value, const char* msg)
@@ -815,3 +824,30 @@ Token* _Parser_expect(Parser* p, TokenValue value, const char* msg)
 	error(&token->location, msg);
 	return NULL;
 }
+
+void _Parser_listAdd(Parser* p, const void* elem, int elemSize)
+{
+	//scratch is shared by nested lists, inner list ends before outer list adds again
+	Vector* scratch = &p->scratch;
+	int size = scratch->size;
+	if (size + elemSize > scratch->cap)
+		Vector_reserve(scratch, size + elemSize > scratch->cap * 2 ? size + elemSize : scratch->cap * 2);
+
+	memcpy((char*)scratch->data + size, elem, elemSize);
+	scratch->size = size + elemSize;
+}
+
+Vector _Parser_listEnd(Parser* p, int begin, int elemSize)
+{
+	//exact size copy in module arena, nothing to release if a syntax error stops parsing
+	int bytes = p->scratch.size - begin;
+
+	Vector list;
+	Vector_init(&list, elemSize);
+	Vector_resizeArena(&list, bytes / elemSize, &p->module.arena);
+	if (bytes)
+		memcpy(list.data, (char*)p->scratch.data + begin, bytes);
+
+	p->scratch.size = begin;
+	return list;
+}
@@ -9,6 +9,7 @@ struct Parser
 {
 	Module module;
 	Lexer* lex;
+	Vector scratch;  //Vector<char>, elements of lists being parsed, copied to module arena when list ends
 };
 typedef struct Parser Parser;
 
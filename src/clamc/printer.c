@@ -145,6 +145,42 @@ static const char* typeIdToString[] =
 	"TYPE_BOOL",
 };
 
+static const char* opCodeToString[] =
+{
+	"NOP",
+	"LOADK",
+	"MOVE",
+	"GETGLOBAL",
+	"SETGLOBAL",
+	"NEGI",
+	"BITNOTI",
+	"NOTB",
+	"INCI",
+	"DECI",
+	"ADDI",
+	"SUBI",
+	"MULI",
+	"DIVI",
+	"MODI",
+	"BITANDI",
+	"BITORI",
+	"XORI",
+	"SHLI",
+	"SHRI",
+	"EQI",
+	"NEI",
+	"LTI",
+	"LEI",
+	"GTI",
+	"GEI",
+	"JMP",
+	"JMPF",
+	"JMPT",
+	"CALL",
+	"RET",
+	"RETV",
+};
+
 static const char* boolToString[] =
 {
 	"false",
@@ -168,6 +204,7 @@ static void _Printer_expression(Printer* p, Expression* expr);
 static void _Printer_condtionExpression(Printer* p, Expression* expr);
 static void _Printer_binaryExpression(Printer* p, Expression* expr);
 static void _Printer_callExpression(Printer* p, Expression* expr);
+static void _Printer_instruction(Printer* p, Program* program, Instruction* ins, int pc);
 static void _Printer_indent(Printer* p);
 
 void Printer_init(Printer* p)
@@ -194,6 +231,22 @@ void Printer_printAst(Printer* p, Module* module)
 		_Printer_declaration(p, Vector_get(&p->module->declarations, i));
 }
 
+void Printer_printProgram(Printer* p, Program* program)
+{
+	printf("globals=%d\n", program->globalCount);
+
+	for (int i = 0; i < program->chunks.size; ++i)
+	{
+		Chunk* chunk = Vector_get(&program->chunks, i);
+		printf("(chunk %d) " String_FMT " argc=%d frameSize=%d\n", i, String_arg(chunk->name), chunk->argc, chunk->frameSize);
+
+		p->level++;
+		for (int pc = 0; pc < chunk->code.size; ++pc)
+			_Printer_instruction(p, program, Vector_get(&chunk->code, pc), pc);
+		p->level--;
+	}
+}
+
 void _Printer_declaration(Printer* p, Declaration* decl)
 {
 	_Printer_indent(p); printf("(declaration)\n");
@@ -390,6 +443,10 @@ void _Printer_expression(Printer* p, Expression* expr)
 	_Printer_indent(p); printf("(expression)\n");
 	_Printer_indent(p); printf("location=" SC_FMT "\n", SC_arg(expr->location));
 	_Printer_indent(p); printf("type=%s\n", exprTypeToString[expr->type]);
+	if (expr->valueType != TYPE_INIT)
+	{
+		_Printer_indent(p); printf("valueType=%s\n", typeIdToString[expr->valueType]);
+	}
 
 	switch (expr->type)
 	{
@@ -409,7 +466,7 @@ void _Printer_expression(Printer* p, Expression* expr)
 		break;
 
 	case EXPR_TYPE_IDENT:
-		_Printer_indent(p); printf("identExpr=" String_FMT "\n", String_arg(expr->identExpr));
+		_Printer_indent(p); printf("identExpr=" String_FMT "\n", String_arg(expr->identExpr.name));
 		break;
 
 	case EXPR_TYPE_PLUS:
@@ -516,6 +573,61 @@ void _Printer_callExpression(Printer* p, Expression* expr)
 
 }
 
+void _Printer_instruction(Printer* p, Program* program, Instruction* ins, int pc)
+{
+	_Printer_indent(p); printf("%04d %-10s", pc, opCodeToString[ins->op]);
+
+	switch (ins->op)
+	{
+	case OP_LOADK:
+		printf("r%d, %d\n", ins->a, ins->imm);
+		break;
+
+	case OP_MOVE:
+	case OP_NEGI:
+	case OP_BITNOTI:
+	case OP_NOTB:
+		printf("r%d, r%d\n", ins->a, ins->b);
+		break;
+
+	case OP_GETGLOBAL:
+		printf("r%d, g%d\n", ins->a, ins->b);
+		break;
+
+	case OP_SETGLOBAL:
+		printf("g%d, r%d\n", ins->a, ins->b);
+		break;
+
+	case OP_INCI:
+	case OP_DECI:
+	case OP_RET:
+		printf("r%d\n", ins->a);
+		break;
+
+	case OP_JMP:
+		printf("-> %04d\n", pc + 1 + ins->imm);
+		break;
+
+	case OP_JMPF:
+	case OP_JMPT:
+		printf("r%d, -> %04d\n", ins->a, pc + 1 + ins->imm);
+		break;
+
+	case OP_CALL:
+		printf("r%d, " String_FMT "\n", ins->a, String_arg(((Chunk*)Vector_get(&program->chunks, ins->b))->name));
+		break;
+
+	case OP_NOP:
+	case OP_RETV:
+		printf("\n");
+		break;
+
+	default:
+		printf("r%d, r%d, r%d\n", ins->a, ins->b, ins->c);
+		break;
+	}
+}
+
 void _Printer_indent(Printer* p)
 {
 	for (int i = 0; i < p->level; ++i)
@@ -3,6 +3,7 @@
 
 #include "module.h"
 #include "lexer.h"
+#include "bytecode.h"
 
 struct Printer
 {
@@ -16,5 +17,6 @@ void Printer_destroy(Printer* p);
 
 void Printer_printLex(Printer* p, Lexer* lex);
 void Printer_printAst(Printer* p, Module* module);
+void Printer_printProgram(Printer* p, Program* program);
 
 #endif
\ No newline at end of file
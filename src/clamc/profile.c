@@ -0,0 +1,211 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "profile.h"
+#include "timer.h"
+
+static int _Profile_child(Profile* prof, int parent, int function);
+static void _Profile_path(Profile* prof, int node, Rope* out);
+static int _Profile_compareFunction(const void* a, const void* b);
+static int _Profile_compareStatement(const void* a, const void* b);
+
+void Profile_init(Profile* prof, const Module* module)
+{
+	prof->module = module;
+	Vector_init(&prof->functions, sizeof(ProfileFunction));
+	Map_init(&prof->statements);
+	Vector_init(&prof->order, sizeof(ProfileStatement*));
+	Arena_init(&prof->arena);
+	Vector_init(&prof->nodes, sizeof(ProfileNode));
+	Vector_init(&prof->frames, sizeof(ProfileFrame));
+
+	Vector_resize(&prof->functions, module->functions.size);
+	if (module->functions.size)
+		memset(prof->functions.data, 0, module->functions.size * sizeof(ProfileFunction));
+}
+
+void Profile_destroy(Profile* prof)
+{
+	Vector_destroy(&prof->functions);
+	Map_destroy(&prof->statements);
+	Vector_destroy(&prof->order);
+	Arena_destroy(&prof->arena);
+	Vector_destroy(&prof->nodes);
+	Vector_destroy(&prof->frames);
+}
+
+void Profile_enter(Profile* prof, int function)
+{
+	int parent = -1;
+	if (prof->frames.size)
+		parent = ((ProfileFrame*)Vector_get(&prof->frames, prof->frames.size - 1))->node;
+
+	ProfileFunction* func = Vector_get(&prof->functions, function);
+	func->calls++;
+	func->active++;
+
+	ProfileFrame frame;
+	frame.node = _Profile_child(prof, parent, function);
+	frame.children = 0;
+	frame.begin = Timer_now();  //last, not to count profiling itself
+	Vector_add(&prof->frames, &frame);
+}
+
+void Profile_exit(Profile* prof)
+{
+	double end = Timer_now();
+	ProfileFrame* frame = Vector_get(&prof->frames, prof->frames.size - 1);
+	double elapsed = end - frame->begin;
+	double exclusive = elapsed - frame->children;
+
+	ProfileNode* node = Vector_get(&prof->nodes, frame->node);
+	node->exclusive += exclusive;
+
+	ProfileFunction* func = Vector_get(&prof->functions, node->function);
+	func->exclusive += exclusive;
+	if (--func->active == 0)
+		func->inclusive += elapsed;
+
+	prof->frames.size--;
+	if (prof->frames.size)
+		((ProfileFrame*)Vector_get(&prof->frames, prof->frames.size - 1))->children += elapsed;
+}
+
+void Profile_statement(Profile* prof, const Statement* stat)
+{
+	String key = { (const char*)&stat->location, sizeof(SourceLocation) };
+	ProfileStatement* s = Map_get(&prof->statements, key);
+	if (!s)
+	{
+		s = Arena_alloc(&prof->arena, sizeof(ProfileStatement));
+		s->location = stat->location;
+		s->count = 0;
+
+		//key refers to copied location, statement node is not needed later
+		key.data = (const char*)&s->location;
+		Map_put(&prof->statements, key, s);
+		Vector_add(&prof->order, &s);
+	}
+	s->count++;
+}
+
+void Profile_writeStacks(Profile* prof, Rope* out)
+{
+	for (int i = 0; i < prof->nodes.size; ++i)
+	{
+		ProfileNode* node = Vector_get(&prof->nodes, i);
+		long long ns = (long long)(node->exclusive * 1e9);
+		if (ns <= 0)
+			continue;
+
+		_Profile_path(prof, i, out);
+		Rope_appendFormat(out, " %lld\n", ns);
+	}
+}
+
+void Profile_report(Profile* prof, Rope* out, int top)
+{
+	int count = prof->functions.size;
+	ProfileFunction* base = prof->functions.data;
+	ProfileFunction** funcs = malloc((count + 1) * sizeof(ProfileFunction*));
+	for (int i = 0; i < count; ++i)
+		funcs[i] = base + i;
+	qsort(funcs, count, sizeof(ProfileFunction*), _Profile_compareFunction);
+
+	Rope_append(out, "top functions by exclusive time:\n");
+	Rope_appendFormat(out, "  %-20s %12s %14s %14s\n", "function", "calls", "inclusive ms", "exclusive ms");
+	for (int i = 0; i < count && i < top; ++i)
+	{
+		ProfileFunction* func = funcs[i];
+		if (!func->calls)
+			break;
+
+		const Declaration* decl = Vector_get(&prof->module->functions, (int)(func - base));
+		Rope_appendFormat(out, "  %-20.*s %12lld %14.3f %14.3f\n", String_arg(decl->function.name),
+			func->calls, func->inclusive * 1000, func->exclusive * 1000);
+	}
+	free(funcs);
+
+	//equal counts are ordered by location
+	int size = prof->order.size;
+	ProfileStatement** stats = malloc((size + 1) * sizeof(ProfileStatement*));
+	if (size)
+		memcpy(stats, prof->order.data, size * sizeof(ProfileStatement*));
+	qsort(stats, size, sizeof(ProfileStatement*), _Profile_compareStatement);
+
+	Rope_append(out, "top statements by count:\n");
+	Rope_appendFormat(out, "  %-20s %12s\n", "location", "count");
+	for (int i = 0; i < size && i < top; ++i)
+	{
+		char loc[64];
+		snprintf(loc, sizeof(loc), "%d:%d", stats[i]->location.line, stats[i]->location.colum);
+		Rope_appendFormat(out, "  %-20s %12lld\n", loc, stats[i]->count);
+	}
+	free(stats);
+}
+
+int _Profile_child(Profile* prof, int parent, int function)
+{
+	//root calls are linked as siblings of node 0 chain
+	int first = -1;
+	if (parent >= 0)
+		first = ((ProfileNode*)Vector_get(&prof->nodes, parent))->child;
+	else if (prof->nodes.size)
+		first = 0;
+
+	int last = -1;
+	for (int i = first; i >= 0; i = ((ProfileNode*)Vector_get(&prof->nodes, i))->next)
+	{
+		if (((ProfileNode*)Vector_get(&prof->nodes, i))->function == function)
+			return i;
+		last = i;
+	}
+
+	ProfileNode node;
+	node.function = function;
+	node.parent = parent;
+	node.child = -1;
+	node.next = -1;
+	node.exclusive = 0;
+	Vector_add(&prof->nodes, &node);
+
+	int index = prof->nodes.size - 1;
+	if (last >= 0)
+		((ProfileNode*)Vector_get(&prof->nodes, last))->next = index;
+	else if (parent >= 0)
+		((ProfileNode*)Vector_get(&prof->nodes, parent))->child = index;
+	return index;
+}
+
+void _Profile_path(Profile* prof, int node, Rope* out)
+{
+	ProfileNode* n = Vector_get(&prof->nodes, node);
+	if (n->parent >= 0)
+	{
+		_Profile_path(prof, n->parent, out);
+		Rope_append(out, ";");
+	}
+
+	const Declaration* decl = Vector_get(&prof->module->functions, n->function);
+	Rope_appendN(out, decl->function.name.data, decl->function.name.length);
+}
+
+int _Profile_compareFunction(const void* a, const void* b)
+{
+	const ProfileFunction* fa = *(ProfileFunction* const*)a;
+	const ProfileFunction* fb = *(ProfileFunction* const*)b;
+	if (fa->exclusive != fb->exclusive)
+		return fa->exclusive < fb->exclusive ? 1 : -1;
+	return fa < fb ? -1 : fa > fb;
+}
+
+int _Profile_compareStatement(const void* a, const void* b)
+{
+	const ProfileStatement* sa = *(ProfileStatement* const*)a;
+	const ProfileStatement* sb = *(ProfileStatement* const*)b;
+	if (sa->count != sb->count)
+		return sa->count < sb->count ? 1 : -1;
+	if (sa->location.line != sb->location.line)
+		return sa->location.line - sb->location.line;
+	return sa->location.colum - sb->location.colum;
+}
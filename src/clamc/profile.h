@@ -0,0 +1,70 @@
+#ifndef CLAM_PROFILE_H
+#define CLAM_PROFILE_H
+
+#include "module.h"
+#include "map.h"
+#include "arena.h"
+#include "vector.h"
+#include "rope.h"
+
+struct ProfileFunction
+{
+	long long calls;
+	double inclusive;  //seconds, recursive calls are counted once
+	double exclusive;  //seconds
+	int active;        //calls on stack
+};
+typedef struct ProfileFunction ProfileFunction;
+
+struct ProfileStatement
+{
+	SourceLocation location;
+	long long count;
+};
+typedef struct ProfileStatement ProfileStatement;
+
+//call tree node, one per distinct call stack
+struct ProfileNode
+{
+	int function;
+	int parent;      //-1 for root calls
+	int child;       //first child, -1 if none
+	int next;        //next sibling
+	double exclusive;
+};
+typedef struct ProfileNode ProfileNode;
+
+struct ProfileFrame
+{
+	int node;
+	double begin;
+	double children;  //inclusive time of callees
+};
+typedef struct ProfileFrame ProfileFrame;
+
+//instrumenting profile of executor, calls and time per function and count per statement
+struct Profile
+{
+	const Module* module;
+	Vector functions;   //Vector<ProfileFunction>, indexed like module->functions
+	Map statements;     //Map<SourceLocation bytes, ProfileStatement*>
+	Vector order;       //Vector<ProfileStatement*>, first execution order
+	Arena arena;        //ProfileStatement nodes
+	Vector nodes;       //Vector<ProfileNode>
+	Vector frames;      //Vector<ProfileFrame>, current call stack
+};
+typedef struct Profile Profile;
+
+void Profile_init(Profile* prof, const Module* module);
+void Profile_destroy(Profile* prof);
+
+void Profile_enter(Profile* prof, int function);
+void Profile_exit(Profile* prof);
+void Profile_statement(Profile* prof, const Statement* stat);
+
+//collapsed stacks for flamegraph.pl, "main;f;g <exclusive nanoseconds>" per line
+void Profile_writeStacks(Profile* prof, Rope* out);
+//top functions by exclusive time and top statements by count
+void Profile_report(Profile* prof, Rope* out, int top);
+
+#endif
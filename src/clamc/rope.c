@@ -0,0 +1,236 @@
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+
+#include "rope.h"
+#include "message.h"
+
+#ifndef _WIN32
+#include <sys/uio.h>
+#include <limits.h>
+#include <errno.h>
+#if defined(IOV_MAX) && IOV_MAX < 1024
+#define ROPE_MAX_IOV IOV_MAX
+#else
+#define ROPE_MAX_IOV 1024
+#endif
+#endif
+
+static RopeChunk* _Rope_newChunk(Rope* rope, int cap);
+static char* _Rope_space(Rope* rope, int length);
+static bool _Rope_equalsFile(Rope* rope, const char* path);
+
+void Rope_init(Rope* rope)
+{
+	Vector_init(&rope->chunks, sizeof(RopeChunk));
+	rope->length = 0;
+}
+
+void Rope_destroy(Rope* rope)
+{
+	for (int i = 0; i < rope->chunks.size; ++i)
+		free(((RopeChunk*)Vector_get(&rope->chunks, i))->data);
+	Vector_destroy(&rope->chunks);
+	rope->length = 0;
+}
+
+void Rope_append(Rope* rope, const char* s)
+{
+	Rope_appendN(rope, s, strlen(s));
+}
+
+void Rope_appendN(Rope* rope, const char* s, int length)
+{
+	if (length <= 0)
+		return;
+
+	//fill the last chunk, the rest goes to a new one
+	if (rope->chunks.size)
+	{
+		RopeChunk* last = Vector_get(&rope->chunks, rope->chunks.size - 1);
+		int n = last->cap - last->length;
+		if (n > length)
+			n = length;
+		memcpy(last->data + last->length, s, n);
+		last->length += n;
+		rope->length += n;
+		s += n;
+		length -= n;
+	}
+
+	if (length > 0)
+		memcpy(_Rope_space(rope, length), s, length);
+}
+
+void Rope_appendString(Rope* rope, String* s)
+{
+	Rope_appendN(rope, s->data, s->length);
+}
+
+void Rope_appendFormat(Rope* rope, const char* fmt, ...)
+{
+	char tmp[256];
+	va_list vp;
+	va_start(vp, fmt);
+	int len = vsnprintf(tmp, sizeof(tmp), fmt, vp);
+	va_end(vp);
+
+	if (len < (int)sizeof(tmp))
+	{
+		Rope_appendN(rope, tmp, len);
+		return;
+	}
+
+	//long output, format again into chunk with room for terminator
+	char* dst = _Rope_space(rope, len + 1);
+	va_start(vp, fmt);
+	vsnprintf(dst, len + 1, fmt, vp);
+	va_end(vp);
+
+	RopeChunk* last = Vector_get(&rope->chunks, rope->chunks.size - 1);
+	last->length--;
+	rope->length--;
+}
+
+void Rope_splice(Rope* rope, Rope* src)
+{
+	for (int i = 0; i < src->chunks.size; ++i)
+		Vector_add(&rope->chunks, Vector_get(&src->chunks, i));
+	rope->length += src->length;
+
+	Vector_resize(&src->chunks, 0);
+	src->length = 0;
+}
+
+void Rope_copy(Rope* rope, StringBuffer* buf)
+{
+	StringBuffer_reserve(buf, buf->length + rope->length);
+	for (int i = 0; i < rope->chunks.size; ++i)
+	{
+		RopeChunk* chunk = Vector_get(&rope->chunks, i);
+		StringBuffer_appendN(buf, chunk->data, chunk->length);
+	}
+}
+
+void Rope_write(Rope* rope, FILE* f)
+{
+	fflush(f);
+
+#ifdef _WIN32
+	for (int i = 0; i < rope->chunks.size; ++i)
+	{
+		RopeChunk* chunk = Vector_get(&rope->chunks, i);
+		fwrite(chunk->data, 1, chunk->length, f);
+	}
+	fflush(f);
+#else
+	struct iovec iov[ROPE_MAX_IOV];
+	int fd = fileno(f);
+	int i = 0;
+
+	while (i < rope->chunks.size)
+	{
+		int count = 0;
+		for (; i < rope->chunks.size && count < ROPE_MAX_IOV; ++i)
+		{
+			RopeChunk* chunk = Vector_get(&rope->chunks, i);
+			if (chunk->length == 0)
+				continue;
+			iov[count].iov_base = chunk->data;
+			iov[count].iov_len = chunk->length;
+			count++;
+		}
+
+		//writev may stop early on pipes, continue from the first unwritten byte
+		struct iovec* cur = iov;
+		while (count > 0)
+		{
+			ssize_t n = writev(fd, cur, count);
+			if (n < 0)
+			{
+				if (errno == EINTR)
+					continue;
+				error(NULL, "write output failed");
+			}
+
+			while (count > 0 && (size_t)n >= cur->iov_len)
+			{
+				n -= cur->iov_len;
+				cur++;
+				count--;
+			}
+			if (count > 0)
+			{
+				cur->iov_base = (char*)cur->iov_base + n;
+				cur->iov_len -= n;
+			}
+		}
+	}
+#endif
+}
+
+bool Rope_writeFile(Rope* rope, const char* path)
+{
+	//unchanged output keeps its timestamp, dependents are not rebuilt
+	if (_Rope_equalsFile(rope, path))
+		return true;
+
+	FILE* f = fopen(path, "wb");
+	if (!f)
+		return false;
+
+	Rope_write(rope, f);
+	fclose(f);
+	return true;
+}
+
+RopeChunk* _Rope_newChunk(Rope* rope, int cap)
+{
+	RopeChunk chunk;
+	chunk.data = malloc(cap);
+	if (!chunk.data)
+		fatal(NULL, "out of memory");
+	chunk.length = 0;
+	chunk.cap = cap;
+
+	Vector_add(&rope->chunks, &chunk);
+	return Vector_get(&rope->chunks, rope->chunks.size - 1);
+}
+
+//reserve length contiguous bytes at the end
+char* _Rope_space(Rope* rope, int length)
+{
+	RopeChunk* last = rope->chunks.size ? Vector_get(&rope->chunks, rope->chunks.size - 1) : NULL;
+	if (!last || last->cap - last->length < length)
+		last = _Rope_newChunk(rope, length > ROPE_CHUNK_SIZE ? length : ROPE_CHUNK_SIZE);
+
+	char* p = last->data + last->length;
+	last->length += length;
+	rope->length += length;
+	return p;
+}
+
+bool _Rope_equalsFile(Rope* rope, const char* path)
+{
+	FILE* f = fopen(path, "rb");
+	if (!f)
+		return false;
+
+	char buf[4096];
+	bool equal = true;
+	for (int i = 0; i < rope->chunks.size && equal; ++i)
+	{
+		RopeChunk* chunk = Vector_get(&rope->chunks, i);
+		for (int pos = 0; pos < chunk->length && equal; pos += sizeof(buf))
+		{
+			int n = chunk->length - pos < (int)sizeof(buf) ? chunk->length - pos : (int)sizeof(buf);
+			equal = fread(buf, 1, n, f) == (size_t)n && memcmp(buf, chunk->data + pos, n) == 0;
+		}
+	}
+
+	if (equal)
+		equal = fgetc(f) == EOF;
+
+	fclose(f);
+	return equal;
+}
@@ -0,0 +1,43 @@
+#ifndef CLAM_ROPE_H
+#define CLAM_ROPE_H
+
+#include <stdio.h>
+#include <stdbool.h>
+
+#include "vector.h"
+#include "strings.h"
+
+#define ROPE_CHUNK_SIZE (64 * 1024)
+
+struct RopeChunk
+{
+	char* data;
+	int length;
+	int cap;
+};
+typedef struct RopeChunk RopeChunk;
+
+//segmented text buffer, appending never moves written bytes
+struct Rope
+{
+	Vector chunks;  //Vector<RopeChunk>
+	int length;
+};
+typedef struct Rope Rope;
+
+void Rope_init(Rope* rope);
+void Rope_destroy(Rope* rope);
+
+void Rope_append(Rope* rope, const char* s);
+void Rope_appendN(Rope* rope, const char* s, int length);
+void Rope_appendString(Rope* rope, String* s);
+void Rope_appendFormat(Rope* rope, const char* fmt, ...);
+
+//move all chunks of src to the end of rope, src becomes empty
+void Rope_splice(Rope* rope, Rope* src);
+
+void Rope_copy(Rope* rope, StringBuffer* buf);
+void Rope_write(Rope* rope, FILE* f);  //gathered write of all chunks
+bool Rope_writeFile(Rope* rope, const char* path);  //keeps file untouched if content is same
+
+#endif
@@ -0,0 +1,649 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "serializer.h"
+
+struct ModuleReader
+{
+	Module* module;
+	const char* ptr;
+	const char* end;
+	String* strings;
+	int stringCount;
+	Vector calls;  //Vector<CallFixup>, resolved after functions vector is complete
+	int frameSize; //of function being read, -1 at top level, slots are checked against it
+	int globals;   //global variants read so far
+	int maxGlobal; //largest global slot referenced, function may reference later variant
+	bool failed;
+};
+typedef struct ModuleReader ModuleReader;
+
+struct CallFixup
+{
+	Expression* expr;
+	int function;  //index of module->functions
+};
+typedef struct CallFixup CallFixup;
+
+static void _Serializer_declaration(Serializer* s, Declaration* decl, int frameSize);
+static void _Serializer_statement(Serializer* s, Statement* stat);
+static void _Serializer_expression(Serializer* s, Expression* expr);
+static void _Serializer_location(Serializer* s, SourceLocation* loc);
+static void _Serializer_type(Serializer* s, Type* type);
+static void _Serializer_string(Serializer* s, String str);
+static void _Serializer_int(Serializer* s, int value);
+
+static void _Serializer_readDeclaration(ModuleReader* r, Declaration* decl);
+static void _Serializer_readStatement(ModuleReader* r, Statement* stat);
+static Expression* _Serializer_newExpression(ModuleReader* r, bool optional);
+static void _Serializer_readExpression(ModuleReader* r, Expression* expr);
+static void _Serializer_readLocation(ModuleReader* r, SourceLocation* loc);
+static void _Serializer_readType(ModuleReader* r, Type* type);
+static String _Serializer_readString(ModuleReader* r);
+static int _Serializer_readInt(ModuleReader* r);
+static int _Serializer_readRange(ModuleReader* r, int min, int max);
+static bool _Serializer_readTable(ModuleReader* r);
+
+void Serializer_init(Serializer* s)
+{
+	Map_init(&s->strings);
+	Vector_init(&s->table, sizeof(String));
+	Vector_init(&s->body, sizeof(int));
+	s->module = NULL;
+}
+
+void Serializer_destroy(Serializer* s)
+{
+	Map_destroy(&s->strings);
+	Vector_destroy(&s->table);
+	Vector_destroy(&s->body);
+}
+
+void Serializer_save(Serializer* s, Module* module, Rope* out)
+{
+	s->module = module;
+
+	//frame size is set on module->functions by analyzer, declarations are in same order
+	int function = 0;
+	_Serializer_int(s, module->declarations.size);
+	for (int i = 0; i < module->declarations.size; ++i)
+	{
+		Declaration* decl = Vector_get(&module->declarations, i);
+		int frameSize = 0;
+		if (decl->type == DECL_TYPE_FUNCTION)
+			frameSize = ((Declaration*)Vector_get(&module->functions, function++))->function.frameSize;
+		_Serializer_declaration(s, decl, frameSize);
+	}
+
+	//header
+	int header[3];
+	int bytes = 0;
+	for (int i = 0; i < s->table.size; ++i)
+		bytes += ((String*)Vector_get(&s->table, i))->length;
+
+	header[0] = SERIALIZER_VERSION;
+	header[1] = s->table.size;
+	header[2] = bytes;
+	Rope_appendN(out, SERIALIZER_MAGIC, 4);
+	Rope_appendN(out, (const char*)header, sizeof(header));
+
+	//string table, lengths then bytes padded to 4
+	for (int i = 0; i < s->table.size; ++i)
+	{
+		int length = ((String*)Vector_get(&s->table, i))->length;
+		Rope_appendN(out, (const char*)&length, sizeof(length));
+	}
+	for (int i = 0; i < s->table.size; ++i)
+		Rope_appendString(out, Vector_get(&s->table, i));
+	Rope_appendN(out, "\0\0\0", (4 - bytes % 4) % 4);
+
+	Rope_appendN(out, s->body.data, s->body.size * sizeof(int));
+}
+
+bool Serializer_isImage(const char* data, long long size)
+{
+	return size >= 4 && memcmp(data, SERIALIZER_MAGIC, 4) == 0;
+}
+
+bool Serializer_load(Module* module, const char* data, long long size)
+{
+	ModuleReader r;
+	r.module = module;
+	r.ptr = data;
+	r.end = data + size;
+	r.strings = NULL;
+	r.stringCount = 0;
+	r.frameSize = -1;
+	r.globals = 0;
+	r.maxGlobal = -1;
+	r.failed = !Serializer_isImage(data, size);
+	Vector_init(&r.calls, sizeof(CallFixup));
+	r.ptr += 4;
+
+	if (!r.failed && _Serializer_readInt(&r) != SERIALIZER_VERSION)
+		r.failed = true;
+
+	if (!r.failed && _Serializer_readTable(&r))
+	{
+		int count = _Serializer_readRange(&r, 0, (int)((r.end - r.ptr) / sizeof(int)));
+		for (int i = 0; i < count && !r.failed; ++i)
+		{
+			Declaration decl;
+			Declaration_init(&decl);
+			_Serializer_readDeclaration(&r, &decl);
+			Module_addDeclaration(module, &decl);
+		}
+	}
+
+	//functions vector is complete, pointers to its elements are stable now
+	for (int i = 0; i < r.calls.size && !r.failed; ++i)
+	{
+		CallFixup* call = Vector_get(&r.calls, i);
+		if (call->function >= module->functions.size)
+			r.failed = true;
+		else if (call->function >= 0)
+		{
+			Declaration* decl = Vector_get(&module->functions, call->function);
+			if (decl->function.parameters.size != call->expr->callExpr.args.size)
+				r.failed = true;
+			call->expr->callExpr.decl = decl;
+		}
+	}
+
+	if (r.maxGlobal >= r.globals)
+		r.failed = true;
+
+	Module_buildFunctionMap(module);
+	if (!r.failed)
+		FlatCode_build(&module->flat, module);
+
+	Vector_destroy(&r.calls);
+	return !r.failed;
+}
+
+void _Serializer_declaration(Serializer* s, Declaration* decl, int frameSize)
+{
+	_Serializer_location(s, &decl->location);
+	_Serializer_int(s, decl->type);
+	_Serializer_int(s, decl->exported);
+
+	switch (decl->type)
+	{
+	case DECL_TYPE_FUNCTION:
+	{
+		FuncDecl* func = &decl->function;
+		_Serializer_type(s, &func->resType);
+		_Serializer_string(s, func->name);
+		_Serializer_int(s, frameSize);
+
+		_Serializer_int(s, func->parameters.size);
+		for (int i = 0; i < func->parameters.size; ++i)
+		{
+			Parameter* param = Vector_get(&func->parameters, i);
+			_Serializer_string(s, param->name);
+			_Serializer_type(s, &param->type);
+		}
+
+		_Serializer_int(s, func->block.size);
+		for (int i = 0; i < func->block.size; ++i)
+			_Serializer_statement(s, Vector_get(&func->block, i));
+		break;
+	}
+
+	case DECL_TYPE_VARIANT:
+		_Serializer_type(s, &decl->variant.type);
+		_Serializer_string(s, decl->variant.name);
+		_Serializer_expression(s, decl->variant.initExpr);
+		_Serializer_int(s, decl->variant.slot);
+		break;
+	}
+}
+
+void _Serializer_statement(Serializer* s, Statement* stat)
+{
+	_Serializer_location(s, &stat->location);
+	_Serializer_int(s, stat->type);
+
+	switch (stat->type)
+	{
+	case STATEMENT_TYPE_DECLARATION:
+		_Serializer_declaration(s, &stat->declaration, 0);
+		break;
+
+	case STATEMENT_TYPE_ASSIGN:
+	case STATEMENT_TYPE_ADD_ASSIGN:
+	case STATEMENT_TYPE_SUB_ASSIGN:
+	case STATEMENT_TYPE_MUL_ASSIGN:
+	case STATEMENT_TYPE_DIV_ASSIGN:
+	case STATEMENT_TYPE_MOD_ASSIGN:
+	case STATEMENT_TYPE_BITAND_ASSIGN:
+	case STATEMENT_TYPE_BITOR_ASSIGN:
+	case STATEMENT_TYPE_XOR_ASSIGN:
+	case STATEMENT_TYPE_LSHIFT_ASSIGN:
+	case STATEMENT_TYPE_RSHIFT_ASSIGN:
+		_Serializer_expression(s, stat->assign.leftExpr);
+		_Serializer_expression(s, stat->assign.rightExpr);
+		break;
+
+	case STATEMENT_TYPE_INC:
+	case STATEMENT_TYPE_DEC:
+		_Serializer_expression(s, stat->incExpr);
+		break;
+
+	case STATEMENT_TYPE_IF:
+		_Serializer_expression(s, stat->ifStat.condition);
+		_Serializer_statement(s, stat->ifStat.statement);
+		_Serializer_int(s, stat->ifStat.elseStat != NULL);
+		if (stat->ifStat.elseStat)
+			_Serializer_statement(s, stat->ifStat.elseStat);
+		break;
+
+	case STATEMENT_TYPE_RETURN:
+		_Serializer_expression(s, stat->returnExpr);
+		break;
+
+	case STATEMENT_TYPE_EXPRESSION:
+		_Serializer_expression(s, stat->expr);
+		break;
+
+	case STATEMENT_TYPE_COMPOUND:
+		_Serializer_int(s, stat->compound.size);
+		for (int i = 0; i < stat->compound.size; ++i)
+			_Serializer_statement(s, Vector_get(&stat->compound, i));
+		break;
+	}
+}
+
+//type -1 for NULL expression
+void _Serializer_expression(Serializer* s, Expression* expr)
+{
+	if (!expr)
+	{
+		_Serializer_int(s, -1);
+		return;
+	}
+
+	_Serializer_int(s, expr->type);
+	_Serializer_location(s, &expr->location);
+	_Serializer_int(s, expr->valueType);
+
+	switch (expr->type)
+	{
+	case EXPR_TYPE_INT:
+		_Serializer_int(s, expr->intExpr);
+		break;
+
+	case EXPR_TYPE_BOOL:
+		_Serializer_int(s, expr->boolExpr);
+		break;
+
+	case EXPR_TYPE_CALL:
+		//callee is always identifier of function, slot is not used
+		_Serializer_location(s, &expr->callExpr.func->location);
+		_Serializer_string(s, expr->callExpr.func->identExpr.name);
+		_Serializer_int(s, expr->callExpr.decl ? (int)(expr->callExpr.decl - (Declaration*)s->module->functions.data) : -1);
+		_Serializer_int(s, expr->callExpr.args.size);
+		for (int i = 0; i < expr->callExpr.args.size; ++i)
+			_Serializer_expression(s, Vector_get(&expr->callExpr.args, i));
+		break;
+
+	case EXPR_TYPE_IDENT:
+		_Serializer_string(s, expr->identExpr.name);
+		_Serializer_int(s, expr->identExpr.slot);
+		_Serializer_int(s, expr->identExpr.global);
+		break;
+
+	case EXPR_TYPE_PLUS:
+	case EXPR_TYPE_MINUS:
+	case EXPR_TYPE_NOT:
+	case EXPR_TYPE_NEG:
+		_Serializer_expression(s, expr->unaryExpr);
+		break;
+
+	case EXPR_TYPE_COND:
+		_Serializer_expression(s, expr->condExpr.expr1);
+		_Serializer_expression(s, expr->condExpr.expr2);
+		_Serializer_expression(s, expr->condExpr.expr3);
+		break;
+
+	default:  //binary
+		_Serializer_expression(s, expr->binaryExpr.leftExpr);
+		_Serializer_expression(s, expr->binaryExpr.rightExpr);
+		break;
+	}
+}
+
+void _Serializer_location(Serializer* s, SourceLocation* loc)
+{
+	String filename = { loc->filename, loc->filename ? (int)strlen(loc->filename) : -1 };
+	_Serializer_string(s, filename);
+	_Serializer_int(s, loc->line);
+	_Serializer_int(s, loc->colum);
+}
+
+void _Serializer_type(Serializer* s, Type* type)
+{
+	_Serializer_string(s, type->name);
+	_Serializer_int(s, type->id);
+}
+
+//index of string table, -1 for NULL
+void _Serializer_string(Serializer* s, String str)
+{
+	if (!str.data || str.length < 0)
+	{
+		_Serializer_int(s, -1);
+		return;
+	}
+
+	intptr_t index = (intptr_t)Map_get(&s->strings, str);
+	if (!index)
+	{
+		Vector_add(&s->table, &str);
+		index = s->table.size;
+		Map_put(&s->strings, str, (void*)index);
+	}
+	_Serializer_int(s, (int)index - 1);
+}
+
+void _Serializer_int(Serializer* s, int value)
+{
+	Vector_add(&s->body, &value);
+}
+
+void _Serializer_readDeclaration(ModuleReader* r, Declaration* decl)
+{
+	_Serializer_readLocation(r, &decl->location);
+	decl->type = _Serializer_readRange(r, DECL_TYPE_FUNCTION, DECL_TYPE_VARIANT);
+	decl->exported = _Serializer_readInt(r) != 0;
+
+	switch (decl->type)
+	{
+	case DECL_TYPE_FUNCTION:
+	{
+		FuncDecl* func = &decl->function;
+		FuncDecl_init(func);
+		_Serializer_readType(r, &func->resType);
+		func->name = _Serializer_readString(r);
+		func->frameSize = _Serializer_readRange(r, 0, 0xFFFFFF);
+		r->frameSize = func->frameSize;
+
+		Vector_resizeArena(&func->parameters, _Serializer_readRange(r, 0, func->frameSize), &r->module->arena);
+		for (int i = 0; i < func->parameters.size; ++i)
+		{
+			Parameter* param = Vector_get(&func->parameters, i);
+			Parameter_init(param);
+			param->name = _Serializer_readString(r);
+			_Serializer_readType(r, &param->type);
+		}
+
+		Vector_resizeArena(&func->block, _Serializer_readRange(r, 0, (int)((r->end - r->ptr) / sizeof(int))), &r->module->arena);
+		for (int i = 0; i < func->block.size; ++i)
+			_Serializer_readStatement(r, Vector_get(&func->block, i));
+
+		r->frameSize = -1;
+		break;
+	}
+
+	case DECL_TYPE_VARIANT:
+		_Serializer_readType(r, &decl->variant.type);
+		decl->variant.name = _Serializer_readString(r);
+		decl->variant.initExpr = _Serializer_newExpression(r, true);
+
+		//global variants are numbered in declaration order
+		if (r->frameSize >= 0)
+			decl->variant.slot = _Serializer_readRange(r, 0, r->frameSize - 1);
+		else
+		{
+			decl->variant.slot = _Serializer_readRange(r, r->globals, r->globals);
+			r->globals++;
+		}
+		break;
+	}
+}
+
+void _Serializer_readStatement(ModuleReader* r, Statement* stat)
+{
+	Statement_init(stat);
+	_Serializer_readLocation(r, &stat->location);
+	stat->type = _Serializer_readRange(r, STATEMENT_TYPE_EMPTY, STATEMENT_TYPE_COMPOUND);
+
+	switch (stat->type)
+	{
+	case STATEMENT_TYPE_DECLARATION:
+		_Serializer_readDeclaration(r, &stat->declaration);
+		break;
+
+	case STATEMENT_TYPE_ASSIGN:
+	case STATEMENT_TYPE_ADD_ASSIGN:
+	case STATEMENT_TYPE_SUB_ASSIGN:
+	case STATEMENT_TYPE_MUL_ASSIGN:
+	case STATEMENT_TYPE_DIV_ASSIGN:
+	case STATEMENT_TYPE_MOD_ASSIGN:
+	case STATEMENT_TYPE_BITAND_ASSIGN:
+	case STATEMENT_TYPE_BITOR_ASSIGN:
+	case STATEMENT_TYPE_XOR_ASSIGN:
+	case STATEMENT_TYPE_LSHIFT_ASSIGN:
+	case STATEMENT_TYPE_RSHIFT_ASSIGN:
+		stat->assign.leftExpr = _Serializer_newExpression(r, false);
+		stat->assign.rightExpr = _Serializer_newExpression(r, false);
+		break;
+
+	case STATEMENT_TYPE_INC:
+	case STATEMENT_TYPE_DEC:
+		stat->incExpr = _Serializer_newExpression(r, false);
+		break;
+
+	case STATEMENT_TYPE_IF:
+		stat->ifStat.condition = _Serializer_newExpression(r, false);
+		stat->ifStat.statement = Statement_alloc(&r->module->arena);
+		_Serializer_readStatement(r, stat->ifStat.statement);
+		stat->ifStat.elseStat = NULL;
+		if (_Serializer_readInt(r))
+		{
+			stat->ifStat.elseStat = Statement_alloc(&r->module->arena);
+			_Serializer_readStatement(r, stat->ifStat.elseStat);
+		}
+		break;
+
+	case STATEMENT_TYPE_RETURN:
+		stat->returnExpr = _Serializer_newExpression(r, true);
+		break;
+
+	case STATEMENT_TYPE_EXPRESSION:
+		stat->expr = _Serializer_newExpression(r, false);
+		break;
+
+	case STATEMENT_TYPE_COMPOUND:
+		Vector_init(&stat->compound, sizeof(Statement));
+		Vector_resizeArena(&stat->compound, _Serializer_readRange(r, 0, (int)((r->end - r->ptr) / sizeof(int))), &r->module->arena);
+		for (int i = 0; i < stat->compound.size; ++i)
+			_Serializer_readStatement(r, Vector_get(&stat->compound, i));
+		break;
+	}
+}
+
+//optional operand may be NULL, broken operand is replaced by literal so tree stays destroyable
+Expression* _Serializer_newExpression(ModuleReader* r, bool optional)
+{
+	int type = -1;
+	if (!r->failed && r->ptr + sizeof(type) <= r->end)
+		memcpy(&type, r->ptr, sizeof(type));
+
+	if (type == -1 && optional && !r->failed)
+	{
+		r->ptr += sizeof(type);
+		return NULL;
+	}
+
+	Expression* expr = Arena_alloc(&r->module->arena, sizeof(Expression));
+	_Serializer_readExpression(r, expr);
+	return expr;
+}
+
+void _Serializer_readExpression(ModuleReader* r, Expression* expr)
+{
+	memset(expr, 0, sizeof(Expression));
+	expr->flat = -1;
+	expr->type = _Serializer_readRange(r, EXPR_TYPE_INT, EXPR_TYPE_COND);
+	_Serializer_readLocation(r, &expr->location);
+	expr->valueType = _Serializer_readRange(r, TYPE_INIT, TYPE_BOOL);
+	if (r->failed)
+	{
+		expr->type = EXPR_TYPE_INT;
+		return;
+	}
+
+	switch (expr->type)
+	{
+	case EXPR_TYPE_INT:
+		expr->intExpr = _Serializer_readInt(r);
+		break;
+
+	case EXPR_TYPE_BOOL:
+		expr->boolExpr = _Serializer_readInt(r) != 0;
+		break;
+
+	case EXPR_TYPE_CALL:
+	{
+		CallFixup call;
+		Expression* func = Arena_alloc(&r->module->arena, sizeof(Expression));
+		memset(func, 0, sizeof(Expression));
+		func->type = EXPR_TYPE_IDENT;
+		func->flat = -1;
+		_Serializer_readLocation(r, &func->location);
+		func->identExpr.name = _Serializer_readString(r);
+
+		expr->callExpr.func = func;
+		expr->callExpr.decl = NULL;
+		call.expr = expr;
+		call.function = _Serializer_readInt(r);
+		Vector_add(&r->calls, &call);
+
+		Vector_init(&expr->callExpr.args, sizeof(Expression));
+		Vector_resizeArena(&expr->callExpr.args, _Serializer_readRange(r, 0, 0xFFFF), &r->module->arena);
+		for (int i = 0; i < expr->callExpr.args.size; ++i)
+			_Serializer_readExpression(r, Vector_get(&expr->callExpr.args, i));
+		break;
+	}
+
+	case EXPR_TYPE_IDENT:
+		expr->identExpr.name = _Serializer_readString(r);
+		expr->identExpr.slot = _Serializer_readInt(r);
+		expr->identExpr.global = _Serializer_readInt(r) != 0;
+		if (expr->identExpr.slot < 0 || (!expr->identExpr.global && expr->identExpr.slot >= r->frameSize))
+			r->failed = true;
+		if (expr->identExpr.global && expr->identExpr.slot > r->maxGlobal)
+			r->maxGlobal = expr->identExpr.slot;
+		break;
+
+	case EXPR_TYPE_PLUS:
+	case EXPR_TYPE_MINUS:
+	case EXPR_TYPE_NOT:
+	case EXPR_TYPE_NEG:
+		expr->unaryExpr = _Serializer_newExpression(r, false);
+		break;
+
+	case EXPR_TYPE_COND:
+		expr->condExpr.expr1 = _Serializer_newExpression(r, false);
+		expr->condExpr.expr2 = _Serializer_newExpression(r, false);
+		expr->condExpr.expr3 = _Serializer_newExpression(r, false);
+		break;
+
+	default:  //binary
+		expr->binaryExpr.leftExpr = _Serializer_newExpression(r, false);
+		expr->binaryExpr.rightExpr = _Serializer_newExpression(r, false);
+		break;
+	}
+}
+
+void _Serializer_readLocation(ModuleReader* r, SourceLocation* loc)
+{
+	loc->filename = _Serializer_readString(r).data;  //strings are null terminated in arena
+	loc->line = _Serializer_readInt(r);
+	loc->colum = _Serializer_readInt(r);
+}
+
+void _Serializer_readType(ModuleReader* r, Type* type)
+{
+	type->name = _Serializer_readString(r);
+	type->id = _Serializer_readRange(r, TYPE_INIT, TYPE_BOOL);
+}
+
+String _Serializer_readString(ModuleReader* r)
+{
+	String s;
+	String_init(&s);
+
+	int index = _Serializer_readRange(r, -1, r->stringCount - 1);
+	if (index >= 0)
+		s = r->strings[index];
+	return s;
+}
+
+int _Serializer_readInt(ModuleReader* r)
+{
+	int value = 0;
+	if (r->ptr + sizeof(value) > r->end)
+	{
+		r->failed = true;
+		return 0;
+	}
+
+	memcpy(&value, r->ptr, sizeof(value));
+	r->ptr += sizeof(value);
+	return value;
+}
+
+int _Serializer_readRange(ModuleReader* r, int min, int max)
+{
+	int value = _Serializer_readInt(r);
+	if (value < min || value > max)
+	{
+		r->failed = true;
+		return min;
+	}
+	return value;
+}
+
+//copy string bytes to arena, each string null terminated
+bool _Serializer_readTable(ModuleReader* r)
+{
+	long long remain = r->end - r->ptr;
+	int count = _Serializer_readRange(r, 0, (int)(remain / sizeof(int)));
+	int bytes = _Serializer_readRange(r, 0, (int)(remain > 0x7FFFFFFF ? 0x7FFFFFFF : remain));
+	if (r->failed || (long long)count * sizeof(int) + bytes > r->end - r->ptr)
+	{
+		r->failed = true;
+		return false;
+	}
+
+	const char* lengths = r->ptr;
+	const char* data = r->ptr + count * sizeof(int);
+	r->ptr = data + bytes + (4 - bytes % 4) % 4;
+
+	r->strings = Arena_alloc(&r->module->arena, count * sizeof(String) + bytes + count);
+	r->stringCount = count;
+	char* dst = (char*)(r->strings + count);
+
+	int pos = 0;
+	for (int i = 0; i < count; ++i)
+	{
+		int length;
+		memcpy(&length, lengths + i * sizeof(int), sizeof(length));
+		if (length < 0 || length > bytes - pos)
+		{
+			r->failed = true;
+			return false;
+		}
+
+		memcpy(dst, data + pos, length);
+		dst[length] = 0;
+		r->strings[i].data = dst;
+		r->strings[i].length = length;
+		dst += length + 1;
+		pos += length;
+	}
+
+	return true;
+}
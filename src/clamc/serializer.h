@@ -0,0 +1,35 @@
+#ifndef CLAM_SERIALIZER_H
+#define CLAM_SERIALIZER_H
+
+#include <stdbool.h>
+
+#include "module.h"
+#include "rope.h"
+
+#define SERIALIZER_MAGIC   "CLMD"
+#define SERIALIZER_VERSION 2
+
+//binary image of analyzed module: header, string table, then declarations,
+//statements and expressions in preorder as 32-bit integers, strings by index
+//nothing in the image is a pointer, it can be loaded from any address
+struct Serializer
+{
+	Map strings;  //Map<String, index + 1>
+	Vector table; //Vector<String>, string table in index order
+	Vector body;  //Vector<int>
+	Module* module;
+};
+typedef struct Serializer Serializer;
+
+void Serializer_init(Serializer* s);
+void Serializer_destroy(Serializer* s);
+
+void Serializer_save(Serializer* s, Module* module, Rope* out);
+
+bool Serializer_isImage(const char* data, long long size);
+
+//load image into initialized empty module, strings are copied to module arena
+//so data can be released after loading, return false if image is invalid
+bool Serializer_load(Module* module, const char* data, long long size);
+
+#endif
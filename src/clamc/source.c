@@ -2,6 +2,16 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
 
 #include "source.h"
 
@@ -10,10 +20,15 @@ enum _SoruceType
 	SOURCE_TYPE_INIT,
 	SOURCE_TYPE_STRING,
 	SOURCE_TYPE_FILE_DATA,
-	//SOURCE_TYPE_FILE_MAPPING,
+	SOURCE_TYPE_FILE_MAPPING,
 };
 typedef enum _SourceType SourceType;
 
+static long long _Source_fileSize(const char* filename);
+static char* _Source_readFile(const char* filename, long long size);
+static char* _Source_mapFile(const char* filename, long long size);
+static void _Source_unmapFile(char* data, long long size);
+
 void Source_init(Source* src, char* code)
 {
 	src->name = "<string>";
@@ -29,39 +44,32 @@ bool Source_open(Source* src, const char* filename)
 	if (!filename)
 		return false;
 
-	//open file
-	FILE* f = fopen(filename, "rb");
-	if (!f)
-		return false;
-
 	//get file size
-	int beg = ftell(f);
-	fseek(f, 0, SEEK_END);
-	int end = ftell(f);
-	int size = end - beg;
-	fseek(f, beg, SEEK_SET);
-
-	if (!size)
+	long long size = _Source_fileSize(filename);  //empty file is empty source
+	if (size < 0 || (unsigned long long)size >= (size_t)-1)
 		return false;
 
-	//TODO: mmap large file
+	//map large file, fallback to read if mapping failed
+	char* buf = NULL;
+	int type = SOURCE_TYPE_FILE_MAPPING;
+	if (size >= SOURCE_MAPPING_THRESHOLD)
+		buf = _Source_mapFile(filename, size);
 
-	char* buf = (char*)malloc(size + 1);
 	if (!buf)
 	{
-		fclose(f);
-		return false;
+		buf = _Source_readFile(filename, size);
+		type = SOURCE_TYPE_FILE_DATA;
 	}
-	buf[size] = 0;    //null terminal for debug
 
-	fread(buf, 1, size, f);
-	fclose(f);
+	if (!buf)
+		return false;
 
 	src->name = filename;
 	src->data = buf;
+	src->size = size;
 	src->end = buf + size;
 	src->iter = src->data;
-	src->type = SOURCE_TYPE_FILE_DATA;
+	src->type = type;
 
 	return true;
 }
@@ -69,13 +77,18 @@ bool Source_open(Source* src, const char* filename)
 void Source_destroy(Source* src)
 {
 	if (src->type == SOURCE_TYPE_FILE_DATA)
-	{
 		free(src->data);
-		src->name = NULL;
-		src->data = NULL;
-		src->end = NULL;
-		src->iter = NULL;
-	}
+	else if (src->type == SOURCE_TYPE_FILE_MAPPING)
+		_Source_unmapFile(src->data, src->size);
+	else
+		return;
+
+	src->name = NULL;
+	src->data = NULL;
+	src->end = NULL;
+	src->iter = NULL;
+	src->size = 0;
+	src->type = SOURCE_TYPE_INIT;
 }
 
 bool Source_isEof(Source* src)
@@ -93,7 +106,99 @@ const char* Source_next(Source* src)
 	return src->iter++;
 }
 
+long long Source_remain(Source* src)
+{
+	return src->end - src->iter;
+}
+
+void Source_skip(Source* src, long long n)
+{
+	src->iter += n;
+}
+
 void Source_reset(Source* src)
 {
 	src->iter = src->data;
-}
\ No newline at end of file
+}
+
+long long _Source_fileSize(const char* filename)
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	if (_stat64(filename, &st) != 0)
+		return -1;
+#else
+	struct stat st;
+	if (stat(filename, &st) != 0)
+		return -1;
+#endif
+	return (long long)st.st_size;
+}
+
+char* _Source_readFile(const char* filename, long long size)
+{
+	FILE* f = fopen(filename, "rb");
+	if (!f)
+		return NULL;
+
+	char* buf = (char*)malloc((size_t)size + 1);
+	if (!buf)
+	{
+		fclose(f);
+		return NULL;
+	}
+	buf[size] = 0;    //null terminal for debug
+
+	size_t n = fread(buf, 1, (size_t)size, f);
+	fclose(f);
+
+	if (n != (size_t)size)
+	{
+		free(buf);
+		return NULL;
+	}
+
+	return buf;
+}
+
+char* _Source_mapFile(const char* filename, long long size)
+{
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	CloseHandle(file);
+	if (!mapping)
+		return NULL;
+
+	//view keeps the mapping alive after handle closed
+	void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, (SIZE_T)size);
+	CloseHandle(mapping);
+	return (char*)data;
+#else
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0)
+		return NULL;
+
+	void* data = mmap(NULL, (size_t)size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		return NULL;
+
+#ifdef MADV_SEQUENTIAL
+	madvise(data, (size_t)size, MADV_SEQUENTIAL);  //lexer reads front to back once
+#endif
+	return (char*)data;
+#endif
+}
+
+void _Source_unmapFile(char* data, long long size)
+{
+#ifdef _WIN32
+	UnmapViewOfFile(data);
+#else
+	munmap(data, (size_t)size);
+#endif
+}
@@ -3,13 +3,15 @@
 
 #include <stdbool.h>
 
+#define SOURCE_MAPPING_THRESHOLD (1024 * 1024)
+
 struct Source
 {
 	const char* name;
 	char* data;
 	char* end;
 	char* iter;
-	int size;
+	long long size;
 	int type;
 };
 
@@ -18,7 +20,8 @@ typedef struct Source Source;
 //init source from code string
 void Source_init(Source* src, char* code);
 
-//open source file
+//open source file, file larger than SOURCE_MAPPING_THRESHOLD is memory mapped
+//mapped data is read only and not null terminated
 bool Source_open(Source* src, const char* filename);
 
 void Source_destroy(Source* src);
@@ -26,6 +29,8 @@ void Source_destroy(Source* src);
 bool Source_isEof(Source* src);
 const char* Source_peek(Source* src);
 const char* Source_next(Source* src);
+long long Source_remain(Source* src);
+void Source_skip(Source* src, long long n);
 void Source_reset(Source* src);
 
 #endif
\ No newline at end of file
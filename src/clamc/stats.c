@@ -0,0 +1,255 @@
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#ifdef _MSC_VER
+#pragma comment(lib, "psapi.lib")
+#endif
+#else
+#include <sys/resource.h>
+#endif
+
+#include "stats.h"
+#include "timer.h"
+
+struct _NodeCounts
+{
+	long long statements;
+	long long expressions;
+};
+typedef struct _NodeCounts NodeCounts;
+
+static long long _Stats_peakRss();
+static void _Stats_statement(NodeCounts* counts, const Statement* stat);
+static void _Stats_expression(NodeCounts* counts, const Expression* expr);
+
+void Stats_init(Stats* stats, const char* filename)
+{
+	stats->filename = filename;
+	stats->size = 0;
+	stats->wallBegin = 0;
+	stats->cpuBegin = 0;
+}
+
+void Stats_begin(Stats* stats, const char* phase)
+{
+	if (!stats || stats->size == STATS_MAX_PHASES)
+		return;
+
+	StatsPhase* p = &stats->phases[stats->size++];
+	p->name = phase;
+	p->wall = 0;
+	p->cpu = 0;
+	p->peakRss = 0;
+	p->countSize = 0;
+
+	stats->wallBegin = Timer_now();
+	stats->cpuBegin = Timer_threadCpu();
+}
+
+void Stats_end(Stats* stats)
+{
+	if (!stats || !stats->size)
+		return;
+
+	StatsPhase* p = &stats->phases[stats->size - 1];
+	p->wall = Timer_now() - stats->wallBegin;
+	p->cpu = Timer_threadCpu() - stats->cpuBegin;
+	p->peakRss = _Stats_peakRss();
+}
+
+void Stats_count(Stats* stats, const char* name, long long value)
+{
+	if (!stats || !stats->size)
+		return;
+
+	StatsPhase* p = &stats->phases[stats->size - 1];
+	if (p->countSize < STATS_MAX_COUNTS)
+	{
+		p->counts[p->countSize].name = name;
+		p->counts[p->countSize].value = value;
+		p->countSize++;
+	}
+}
+
+void Stats_countModule(Stats* stats, const Module* module)
+{
+	if (!stats)
+		return;
+
+	NodeCounts counts = { 0, 0 };
+	for (int i = 0; i < module->declarations.size; ++i)
+	{
+		const Declaration* decl = Vector_get(&module->declarations, i);
+		if (decl->type == DECL_TYPE_VARIANT && decl->variant.initExpr)
+			_Stats_expression(&counts, decl->variant.initExpr);
+
+		if (decl->type != DECL_TYPE_FUNCTION)
+			continue;
+
+		for (int j = 0; j < decl->function.block.size; ++j)
+			_Stats_statement(&counts, Vector_get(&decl->function.block, j));
+	}
+
+	Stats_count(stats, "declarations", module->declarations.size);
+	Stats_count(stats, "functions", module->functions.size);
+	Stats_count(stats, "statements", counts.statements);
+	Stats_count(stats, "expressions", counts.expressions);
+}
+
+void Stats_print(Stats* stats, Rope* out, bool json)
+{
+	double wall = 0;
+	double cpu = 0;
+	for (int i = 0; i < stats->size; ++i)
+	{
+		wall += stats->phases[i].wall;
+		cpu += stats->phases[i].cpu;
+	}
+
+	if (json)
+	{
+		//file names are printed as is, only quote and backslash are escaped
+		Rope_append(out, "{\"file\": \"");
+		for (const char* c = stats->filename; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				Rope_append(out, "\\");
+			Rope_appendN(out, c, 1);
+		}
+		Rope_appendFormat(out, "\", \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"phases\": [", wall * 1000, cpu * 1000);
+
+		for (int i = 0; i < stats->size; ++i)
+		{
+			StatsPhase* p = &stats->phases[i];
+			Rope_appendFormat(out, "%s\n  {\"name\": \"%s\", \"wall_ms\": %.3f, \"cpu_ms\": %.3f, \"peak_rss_kb\": %lld, \"counts\": {",
+				i ? "," : "", p->name, p->wall * 1000, p->cpu * 1000, p->peakRss / 1024);
+			for (int j = 0; j < p->countSize; ++j)
+				Rope_appendFormat(out, "%s\"%s\": %lld", j ? ", " : "", p->counts[j].name, p->counts[j].value);
+			Rope_append(out, "}}");
+		}
+
+		Rope_append(out, "]}");
+		return;
+	}
+
+	Rope_appendFormat(out, "time passes of '%s':\n", stats->filename);
+	Rope_appendFormat(out, "  %-14s %10s %10s %12s  %s\n", "phase", "wall ms", "cpu ms", "peak rss KB", "counts");
+	for (int i = 0; i < stats->size; ++i)
+	{
+		StatsPhase* p = &stats->phases[i];
+		Rope_appendFormat(out, "  %-14s %10.3f %10.3f %12lld", p->name, p->wall * 1000, p->cpu * 1000, p->peakRss / 1024);
+		for (int j = 0; j < p->countSize; ++j)
+			Rope_appendFormat(out, "%s%s=%lld", j ? " " : "  ", p->counts[j].name, p->counts[j].value);
+		Rope_append(out, "\n");
+	}
+	Rope_appendFormat(out, "  %-14s %10.3f %10.3f\n", "total", wall * 1000, cpu * 1000);
+}
+
+long long _Stats_peakRss()
+{
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc)))
+		return 0;
+	return (long long)pmc.PeakWorkingSetSize;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0)
+		return 0;
+#ifdef __APPLE__
+	return (long long)usage.ru_maxrss;  //bytes
+#else
+	return (long long)usage.ru_maxrss * 1024;  //KB
+#endif
+#endif
+}
+
+void _Stats_statement(NodeCounts* counts, const Statement* stat)
+{
+	counts->statements++;
+
+	switch (stat->type)
+	{
+	case STATEMENT_TYPE_DECLARATION:
+		if (stat->declaration.variant.initExpr)
+			_Stats_expression(counts, stat->declaration.variant.initExpr);
+		break;
+
+	case STATEMENT_TYPE_ASSIGN:
+	case STATEMENT_TYPE_ADD_ASSIGN:
+	case STATEMENT_TYPE_SUB_ASSIGN:
+	case STATEMENT_TYPE_MUL_ASSIGN:
+	case STATEMENT_TYPE_DIV_ASSIGN:
+	case STATEMENT_TYPE_MOD_ASSIGN:
+	case STATEMENT_TYPE_BITAND_ASSIGN:
+	case STATEMENT_TYPE_BITOR_ASSIGN:
+	case STATEMENT_TYPE_XOR_ASSIGN:
+	case STATEMENT_TYPE_LSHIFT_ASSIGN:
+	case STATEMENT_TYPE_RSHIFT_ASSIGN:
+		_Stats_expression(counts, stat->assign.leftExpr);
+		_Stats_expression(counts, stat->assign.rightExpr);
+		break;
+
+	case STATEMENT_TYPE_INC:
+	case STATEMENT_TYPE_DEC:
+		_Stats_expression(counts, stat->incExpr);
+		break;
+
+	case STATEMENT_TYPE_IF:
+		_Stats_expression(counts, stat->ifStat.condition);
+		_Stats_statement(counts, stat->ifStat.statement);
+		if (stat->ifStat.elseStat)
+			_Stats_statement(counts, stat->ifStat.elseStat);
+		break;
+
+	case STATEMENT_TYPE_RETURN:
+		if (stat->returnExpr)
+			_Stats_expression(counts, stat->returnExpr);
+		break;
+
+	case STATEMENT_TYPE_EXPRESSION:
+		_Stats_expression(counts, stat->expr);
+		break;
+
+	case STATEMENT_TYPE_COMPOUND:
+		for (int i = 0; i < stat->compound.size; ++i)
+			_Stats_statement(counts, Vector_get(&stat->compound, i));
+		break;
+	}
+}
+
+void _Stats_expression(NodeCounts* counts, const Expression* expr)
+{
+	counts->expressions++;
+
+	switch (expr->type)
+	{
+	case EXPR_TYPE_CALL:
+		for (int i = 0; i < expr->callExpr.args.size; ++i)
+			_Stats_expression(counts, Vector_get(&expr->callExpr.args, i));
+		break;
+
+	case EXPR_TYPE_PLUS:
+	case EXPR_TYPE_MINUS:
+	case EXPR_TYPE_NOT:
+	case EXPR_TYPE_NEG:
+		_Stats_expression(counts, expr->unaryExpr);
+		break;
+
+	case EXPR_TYPE_COND:
+		_Stats_expression(counts, expr->condExpr.expr1);
+		_Stats_expression(counts, expr->condExpr.expr2);
+		_Stats_expression(counts, expr->condExpr.expr3);
+		break;
+
+	case EXPR_TYPE_INT:
+	case EXPR_TYPE_BOOL:
+	case EXPR_TYPE_IDENT:
+		break;
+
+	default:
+		_Stats_expression(counts, expr->binaryExpr.leftExpr);
+		_Stats_expression(counts, expr->binaryExpr.rightExpr);
+		break;
+	}
+}
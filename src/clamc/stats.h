@@ -0,0 +1,53 @@
+#ifndef CLAM_STATS_H
+#define CLAM_STATS_H
+
+#include <stdbool.h>
+
+#include "module.h"
+#include "rope.h"
+
+#define STATS_MAX_PHASES 16
+#define STATS_MAX_COUNTS 8
+
+struct StatsCount
+{
+	const char* name;
+	long long value;
+};
+typedef struct StatsCount StatsCount;
+
+struct StatsPhase
+{
+	const char* name;
+	double wall;         //seconds
+	double cpu;          //seconds of thread compiling the file, without threads of --repeat and --batch
+	long long peakRss;   //bytes of whole process at end of phase, 0 if unknown
+	StatsCount counts[STATS_MAX_COUNTS];
+	int countSize;
+};
+typedef struct StatsPhase StatsPhase;
+
+//phases of compiling one file, all functions do nothing on NULL stats
+struct Stats
+{
+	const char* filename;
+	StatsPhase phases[STATS_MAX_PHASES];
+	int size;
+	double wallBegin;  //of current phase
+	double cpuBegin;
+};
+typedef struct Stats Stats;
+
+void Stats_init(Stats* stats, const char* filename);
+
+void Stats_begin(Stats* stats, const char* phase);
+void Stats_end(Stats* stats);
+
+//add count to last phase
+void Stats_count(Stats* stats, const char* name, long long value);
+void Stats_countModule(Stats* stats, const Module* module);
+
+//human readable table or one JSON object
+void Stats_print(Stats* stats, Rope* out, bool json);
+
+#endif
@@ -29,7 +29,28 @@ bool String_equalsString(String s1, String s2)
 
 int String_toInt(String* s, int base)
 {
-	return strtol(s->data, NULL, base);
+	//parse by length, literal may be the last bytes of a mapped file without null terminal
+	unsigned int value = 0;
+	for (int i = 0; i < s->length; ++i)
+	{
+		int c = tolower((unsigned char)s->data[i]);
+		int digit = isdigit(c) ? c - '0' : isalpha(c) ? c - 'a' + 10 : base;
+		if (digit >= base)
+			break;
+		value = value * base + digit;
+	}
+	return (int)value;
+}
+
+unsigned int String_hash(String s)
+{
+	unsigned int hash = 2166136261u;  //FNV-1a
+	for (int i = 0; i < s.length; ++i)
+	{
+		hash ^= (unsigned char)s.data[i];
+		hash *= 16777619u;
+	}
+	return hash;
 }
 
 void StringBuffer_init(StringBuffer* buf)
@@ -64,10 +85,10 @@ void StringBuffer_reserve(StringBuffer* buf, int cap)
 
 	if (buf->cap < cap)
 	{
-		buf->data = realloc(buf->data, cap + 1);
+		buf->data = realloc(buf->data, cap + 1);  //one more for terminator
 		if (!buf->data)
 			fatal(NULL, 0, 0, "out of memory");
-		buf->cap = cap + 1;
+		buf->cap = cap;
 	}
 }
 
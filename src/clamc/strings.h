@@ -15,6 +15,7 @@ bool String_equals(String s1, const char* s2);
 bool String_equalsN(String s1, const char* s2, int length);
 bool String_equalsString(String s1, String s2);
 int String_toInt(String* s, int base);
+unsigned int String_hash(String s);
 
 #define String_literal(s) { (s), sizeof((s)) - 1 }
 #define String_FMT "%.*s"
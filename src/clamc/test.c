@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <ctype.h>
 #include <stdint.h>
 
 #include "source.h"
@@ -9,9 +10,20 @@
 #include "executor.h"
 #include "analyzer.h"
 #include "printer.h"
+#include "compiler.h"
+#include "vm.h"
+#include "jit.h"
 
 #include "vector.h"
 #include "stack.h"
+#include "map.h"
+#include "thread.h"
+#include "cache.h"
+#include "serializer.h"
+#include "clam.h"
+#include "batch.h"
+#include "stats.h"
+#include "profile.h"
 
 
 struct TestCase
@@ -68,6 +80,85 @@ static void test_stack(const char* arg)
 		printf("stack.pop=%d\n", *(int*)Stack_pop(&stack));
 }
 
+static void test_map(const char* arg)
+{
+	Map map;
+	Map_init(&map);
+
+	static const char* names[] = { "main", "foo", "bar", "a1", "a2", "a3", "a4", "a5", "a6", "a7", "a8", "a9", "a10", "a11", "a12", "a13", "a14" };
+	int count = sizeof(names) / sizeof(names[0]);
+
+	for (int i = 0; i < count; ++i)
+	{
+		String key = { names[i], strlen(names[i]) };
+		Map_put(&map, key, (void*)names[i]);
+	}
+
+	String dup = String_literal("foo");
+	printf("put duplicate=%d\n", Map_put(&map, dup, "other"));
+
+	for (int i = 0; i < count; ++i)
+	{
+		String key = { names[i], strlen(names[i]) };
+		printf("map[%s]=%s\n", names[i], (const char*)Map_get(&map, key));
+	}
+
+	String none = String_literal("none");
+	printf("map[none]=%s size=%d cap=%d\n", Map_get(&map, none) ? "found" : "NULL", map.size, map.cap);
+
+	Map_destroy(&map);
+}
+
+struct ThreadCounter
+{
+	Mutex lock;
+	int count;
+};
+typedef struct ThreadCounter ThreadCounter;
+
+static void _test_thread_count(void* arg)
+{
+	ThreadCounter* counter = arg;
+	for (int i = 0; i < 10000; ++i)
+	{
+		Mutex_lock(&counter->lock);
+		counter->count++;
+		Mutex_unlock(&counter->lock);
+	}
+}
+
+static void test_thread(const char* arg)
+{
+	ThreadCounter counter;
+	Mutex_init(&counter.lock);
+	counter.count = 0;
+
+	Thread threads[4];
+	for (int i = 0; i < 4; ++i)
+		Thread_start(&threads[i], _test_thread_count, &counter);
+	for (int i = 0; i < 4; ++i)
+		Thread_join(&threads[i]);
+
+	printf("count=%d cpu>0=%d\n", counter.count, Thread_cpuCount() > 0);
+	Mutex_destroy(&counter.lock);
+}
+
+static void test_cache(const char* arg)
+{
+	const char* code = "export int main() { return 0; }";
+	CacheKey key1;
+	CacheKey key2;
+	CacheKey key3;
+
+	Cache_key(&key1, code, strlen(code), "0123456789abcdef S=0 c=");
+	Cache_key(&key2, code, strlen(code), "0123456789abcdef S=1 c=");
+	Cache_key(&key3, code, strlen(code) - 1, "0123456789abcdef S=0 c=");
+
+	printf("key=%s size=%lld check=%016llx\n", key1.name, key1.size, key1.check);
+	printf("options differ=%d source differ=%d\n", strcmp(key1.name, key2.name) != 0, strcmp(key1.name, key3.name) != 0);
+	printf("check differ=%d %d\n", key1.check != key2.check, key1.check != key3.check);
+}
+
 static void test_string(const char* arg)
 {
 	String s = String_literal("hello");
@@ -124,6 +215,115 @@ static void test_lexer(const char* code)
 	Printer_printLex(&p, &lex);
 }
 
+static void test_lexer_location(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source src;
+	Source_init(&src, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &src);
+
+	//recount line and column byte by byte for every token
+	int line = 1;
+	const char* lineStart = code;
+	const char* iter = code;
+	for (Token* token = Lexer_next(&lex); token->value != TOKEN_VALUE_EOF; token = Lexer_next(&lex))
+	{
+		for (; iter < token->literal.data; iter++)
+		{
+			if (*iter == '\n')
+			{
+				line++;
+				lineStart = iter + 1;
+			}
+		}
+
+		int colum = (int)(token->literal.data - lineStart) + 1;
+		if (token->location.line != line || token->location.colum != colum)
+			error(&token->location, "'" String_FMT "' should be at %d:%d", String_arg(token->literal), line, colum);
+
+		char next = token->literal.data[token->literal.length];
+		if (token->type == TOKEN_TYPE_IDENT && (isalnum((unsigned char)next) || next == '_'))
+			error(&token->location, "identifier '" String_FMT "' is cut", String_arg(token->literal));
+
+		printf(String_FMT "\t(%d:%d)\n", String_arg(token->literal), token->location.line, token->location.colum);
+	}
+	Lexer_destroy(&lex);
+}
+
+static void test_keyword(const char* code)
+{
+	//every keyword must be found, even when several share a length and first char
+	for (int i = 0; i < Lexer_keywordCount(); i++)
+	{
+		String keyword = Lexer_keyword(i);
+		char buf[16];
+		snprintf(buf, sizeof(buf), String_FMT, String_arg(keyword));
+
+		Source src;
+		Source_init(&src, buf);
+		Lexer lex;
+		Lexer_init(&lex, &src);
+
+		Token* token = Lexer_next(&lex);
+		if (token->type == TOKEN_TYPE_IDENT || token->literal.length != keyword.length)
+			error(NULL, "keyword '%s' is not found", buf);
+		printf("keyword %s: %d %d\n", buf, token->type, token->value);
+		Lexer_destroy(&lex);
+	}
+
+	//words near a keyword must stay identifiers
+	printf("source code:\n%s\n\n", code);
+
+	Source src;
+	Source_init(&src, code);
+	Lexer lex;
+	Lexer_init(&lex, &src);
+
+	for (Token* token = Lexer_next(&lex); token->type != TOKEN_TYPE_EOF; token = Lexer_next(&lex))
+	{
+		if (token->type != TOKEN_TYPE_IDENT)
+			error(&token->location, "'" String_FMT "' is not an identifier", String_arg(token->literal));
+	}
+	Lexer_destroy(&lex);
+}
+
+static void test_prelex(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source src;
+	Source_init(&src, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &src);
+	Lexer_prelex(&lex);
+
+	printf("buffered tokens: %d\n", lex.buffer.size);
+	Lexer_next(&lex);
+	printf("lookahead: %d %d %d\n", Lexer_lookahead(&lex, 0), Lexer_lookahead(&lex, 1), Lexer_lookahead(&lex, lex.buffer.size));
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Source_reset(&src);
+	Lexer_destroy(&lex);
+	Lexer_init(&lex, &src);
+	Lexer_prelex(&lex);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Printer p;
+	Printer_init(&p);
+
+	printf("AST dump:\n");
+	Printer_printAst(&p, module);
+
+	Lexer_destroy(&lex);
+}
+
 static void test_parser(const char* code)
 {
 	printf("source code:\n%s\n\n", code);
@@ -168,6 +368,32 @@ static void test_analyzer(const char* code)
 	printf("sematic analysis done.\n");
 }
 
+static void test_annotation(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Analyzer anly;
+	Analyzer_init(&anly);
+	Analyzer_analyze(&anly, module);
+
+	Printer p;
+	Printer_init(&p);
+
+	printf("annotated AST dump:\n");
+	Printer_printAst(&p, module);
+}
+
 static void test_executor(const char* code)
 {
 	printf("source code:\n%s\n\n", code);
@@ -194,6 +420,366 @@ static void test_executor(const char* code)
 	Executor_run(&exec, module);
 }
 
+struct SharedRun
+{
+	const Module* module;
+	int results[100];
+};
+typedef struct SharedRun SharedRun;
+
+static void _test_shared_run(void* arg)
+{
+	SharedRun* run = arg;
+
+	Executor exec;
+	Executor_init(&exec);
+	for (int i = 0; i < 100; ++i)
+		run->results[i] = Executor_execute(&exec, run->module);
+	Executor_destroy(&exec);
+}
+
+static void test_shared(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Analyzer anly;
+	Analyzer_init(&anly);
+	Analyzer_analyze(&anly, module);
+
+	//one module run by executors on 4 threads at once
+	SharedRun runs[4];
+	Thread threads[4];
+	for (int i = 0; i < 4; ++i)
+	{
+		runs[i].module = module;
+		Thread_start(&threads[i], _test_shared_run, &runs[i]);
+	}
+	for (int i = 0; i < 4; ++i)
+		Thread_join(&threads[i]);
+
+	int same = 0;
+	for (int i = 0; i < 4; ++i)
+	{
+		for (int j = 0; j < 100; ++j)
+			same += runs[i].results[j] == runs[0].results[0];
+	}
+	printf("main return %d, same=%d\n", runs[0].results[0], same);
+
+	Analyzer_destroy(&anly);
+	Parser_destroy(&parser);
+	Lexer_destroy(&lex);
+}
+
+static void test_batch(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Analyzer anly;
+	Analyzer_init(&anly);
+	Analyzer_analyze(&anly, module);
+
+	Program prog;
+	Program_init(&prog);
+
+	Compiler c;
+	Compiler_init(&c);
+	Compiler_compile(&c, module, &prog);
+
+	const char* rows = "1, 2\n3,4\r\n\n-5,true\n7,false";
+
+	//same rows by vm on 2 threads and by AST executor
+	for (int i = 0; i < 2; ++i)
+	{
+		Batch batch;
+		Batch_init(&batch, module, i ? NULL : &prog, "f");
+		Batch_parse(&batch, "rows", rows, strlen(rows), false);
+		Batch_run(&batch, 2);
+
+		printf("%s results:", i ? "executor" : "vm");
+		for (int j = 0; j < batch.results.size; ++j)
+			printf(" %d", *(int*)Vector_get(&batch.results, j));
+		printf("\n");
+
+		Batch_destroy(&batch);
+	}
+
+	//empty rows file gives no results
+	Batch empty;
+	Batch_init(&empty, module, &prog, "f");
+	Batch_parse(&empty, "empty", "", 0, false);
+	Batch_run(&empty, 2);
+	printf("empty results: %d\n", empty.results.size);
+	Batch_destroy(&empty);
+
+	Compiler_destroy(&c);
+	Program_destroy(&prog);
+	Analyzer_destroy(&anly);
+	Parser_destroy(&parser);
+	Lexer_destroy(&lex);
+}
+
+static void test_stats(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Stats stats;
+	Stats_init(&stats, "stats");
+
+	Stats_begin(&stats, "parse");
+	Module* module = Parser_translate(&parser, &lex);
+	Stats_end(&stats);
+	Stats_count(&stats, "tokens", lex.tokens);
+	Stats_countModule(&stats, module);
+
+	//times differ between runs, print counts only
+	StatsPhase* phase = &stats.phases[0];
+	printf("phases=%d %s wall>=0=%d cpu>=0=%d\n", stats.size, phase->name, phase->wall >= 0, phase->cpu >= 0);
+	for (int i = 0; i < phase->countSize; ++i)
+		printf("%s=%lld\n", phase->counts[i].name, phase->counts[i].value);
+
+	Parser_destroy(&parser);
+	Lexer_destroy(&lex);
+}
+
+static void test_profile(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Analyzer anly;
+	Analyzer_init(&anly);
+	Analyzer_analyze(&anly, module);
+
+	Profile prof;
+	Profile_init(&prof, module);
+
+	Executor exec;
+	Executor_init(&exec);
+	exec.profile = &prof;
+	printf("main return: %d\n", Executor_execute(&exec, module));
+
+	//times differ between runs, print calls and counts only
+	for (int i = 0; i < module->functions.size; ++i)
+	{
+		const Declaration* decl = Vector_get(&module->functions, i);
+		ProfileFunction* func = Vector_get(&prof.functions, i);
+		printf(String_FMT " calls=%lld\n", String_arg(decl->function.name), func->calls);
+	}
+	for (int i = 0; i < prof.order.size; ++i)
+	{
+		ProfileStatement* stat = *(ProfileStatement**)Vector_get(&prof.order, i);
+		printf("%d:%d count=%lld\n", stat->location.line, stat->location.colum, stat->count);
+	}
+
+	Executor_destroy(&exec);
+	Profile_destroy(&prof);
+	Analyzer_destroy(&anly);
+	Parser_destroy(&parser);
+	Lexer_destroy(&lex);
+}
+
+static void test_serializer(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Analyzer anly;
+	Analyzer_init(&anly);
+	Analyzer_analyze(&anly, module);
+
+	Serializer ser;
+	Serializer_init(&ser);
+
+	Rope out;
+	Rope_init(&out);
+	Serializer_save(&ser, module, &out);
+
+	StringBuffer image;
+	StringBuffer_init(&image);
+	Rope_copy(&out, &image);
+
+	//loaded module must not reference parsed module
+	Parser_destroy(&parser);
+
+	Module truncated;
+	Module_init(&truncated);
+	printf("truncated load=%d\n", Serializer_load(&truncated, image.data, image.length - 4));
+	Module_destroy(&truncated);
+
+	Module loaded;
+	Module_init(&loaded);
+	printf("load=%d\n", Serializer_load(&loaded, image.data, image.length));
+
+	printf("interpret output:\n");
+
+	Executor exec;
+	Executor_init(&exec);
+	Executor_run(&exec, &loaded);
+
+	Executor_destroy(&exec);
+	Module_destroy(&loaded);
+	StringBuffer_destroy(&image);
+	Rope_destroy(&out);
+	Serializer_destroy(&ser);
+}
+
+static void _test_library_sink(void* user, const SourceLocation* loc, bool isError, const char* text)
+{
+	printf("%s %s:%d:%d %s\n", isError ? "error" : "warnning", loc ? loc->filename : "-", loc ? loc->line : 0, loc ? loc->colum : 0, text);
+}
+
+static void test_library(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	ClamProgram* clam = Clam_compile("library", code, _test_library_sink, NULL);
+	printf("compile=%d\n", clam != NULL);
+	if (!clam)
+		return;
+
+	//globals are reset for each run
+	for (int i = 0; i < 2; i++)
+	{
+		int result = 0;
+		bool done = Clam_run(clam, "main", NULL, 0, &result, _test_library_sink, NULL);
+		printf("main done=%d result=%d\n", done, result);
+	}
+
+	int args[] = { 7, 1 };
+	int result = 0;
+	bool done = Clam_run(clam, "f", args, 2, &result, _test_library_sink, NULL);
+	printf("f done=%d result=%d\n", done, result);
+
+	Clam_free(clam);
+}
+
+static void test_vm(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Analyzer anly;
+	Analyzer_init(&anly);
+	Analyzer_analyze(&anly, module);
+
+	Program prog;
+	Program_init(&prog);
+
+	Compiler c;
+	Compiler_init(&c);
+	Compiler_compile(&c, module, &prog);
+
+	Printer p;
+	Printer_init(&p);
+
+	printf("bytecode dump:\n");
+	Printer_printProgram(&p, &prog);
+
+	printf("vm output:\n");
+
+	VM vm;
+	VM_init(&vm);
+	VM_run(&vm, &prog);
+}
+
+static void test_jit(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Analyzer anly;
+	Analyzer_init(&anly);
+	Analyzer_analyze(&anly, module);
+
+	Program prog;
+	Program_init(&prog);
+
+	Compiler c;
+	Compiler_init(&c);
+	Compiler_compile(&c, module, &prog);
+
+	Jit jit;
+	Jit_init(&jit);
+
+	printf("jit output:\n");
+
+	VM vm;
+	VM_init(&vm);
+	vm.jit = &jit;
+	VM_run(&vm, &prog);
+}
+
 static void test_generator(const char* code)
 {
 	printf("source code:\n%s\n\n", code);
@@ -217,13 +803,88 @@ static void test_generator(const char* code)
 	Generator_init(&gen, GENERATE_TARGE_C);
 	Generator_generate(&gen, module);
 
-	StringBuffer buf;
-	StringBuffer_init(&buf);
+	Rope src;
+	Rope_init(&src);
+
+	Generator_getSource(&gen, &src);
+
+	printf("generate C header:\n");
+	Rope_write(&gen.header, stdout);
+	printf("\n\ngenerate C source:\n");
+	Rope_write(&src, stdout);
+	printf("\n\n");
+}
+
+static void test_unit(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Analyzer anly;
+	Analyzer_init(&anly);
+	Analyzer_analyze(&anly, module);
+
+	Generator gen;
+	Generator_init(&gen, GENERATE_TARGE_C);
+	gen.unit = (String)String_literal("unit");
+	Generator_generate(&gen, module);
+
+	Rope header;
+	Rope_init(&header);
+	Generator_getHeader(&gen, &header);
+
+	Rope src;
+	Rope_init(&src);
+	Generator_getSource(&gen, &src);
+
+	printf("generate unit.h:\n");
+	Rope_write(&header, stdout);
+	printf("\n\ngenerate unit.c:\n");
+	Rope_write(&src, stdout);
+	printf("\n\n");
+}
+
+static void test_x64(const char* code)
+{
+	printf("source code:\n%s\n\n", code);
+
+	Source source;
+	Source_init(&source, code);
+
+	Lexer lex;
+	Lexer_init(&lex, &source);
+
+	Parser parser;
+	Parser_init(&parser);
+
+	Module* module = Parser_translate(&parser, &lex);
+
+	Analyzer anly;
+	Analyzer_init(&anly);
+	Analyzer_analyze(&anly, module);
+
+	Generator gen;
+	Generator_init(&gen, GENERATE_TARGE_X64);
+	Generator_generate(&gen, module);
 
-	Generator_getSource(&gen, &buf);
+	Rope src;
+	Rope_init(&src);
 
-	printf("generate C header:\n" String_FMT "\n\n", String_arg(gen.header));
-	printf("generate C source:\n" String_FMT "\n\n", String_arg(buf));
+	Generator_getSource(&gen, &src);
+
+	printf("generate x86-64 assembly:\n");
+	Rope_write(&src, stdout);
+	printf("\n\n");
 }
 
 #define TEST(base, name, code)       { base, #base, name, code, false },
@@ -233,14 +894,29 @@ static TestCase tests[] =
 {
 	TEST(test_vector, "basic", "")
 	TEST(test_stack,  "basic", "")
+	TEST(test_map,    "basic", "")
+	TEST(test_thread, "basic", "")
+	TEST(test_cache,  "basic", "")
 	TEST(test_string, "basic", "")
 	TEST(test_string_buffer, "basic", "")
 
 	TEST(test_lexer, "eof"    , "")
 	TEST(test_lexer, "keyword", "export void int bool true false if else return")
+	TEST(test_lexer, "keyword_like", "i iff in ints vo voids bools tru falsy el elses exports ret returned Int If")
 	TEST(test_lexer, "punct"  , "(){},;")
+	TEST(test_lexer_location, "space_tab", "a\t\t\t\t\t\t\t\t \t\t\t\t\t\t\t\t\t\tb \t \t \t \t \t \t \t \t \t \t \t \t \t \t \t \t \tc")
+	TEST(test_lexer_location, "space_crlf", "a\r\n\r\n\r\n\r\n\r\n\r\n\r\n\r\n\r\n  b\r\n\t\r\n\t\r\n\t\r\n\t\r\n\t\r\n\tc\r\n")
+	TEST(test_lexer_location, "space_newline_last", "a               \nb               \n               \ncdefghijklmnopqrstuvwxyz")
+	TEST(test_lexer_location, "space_eof", "a\n \n \n \n \n \n \n \n \n                ")
+	TEST(test_lexer_location, "ident_long", "abcdefghijklmnop abcdefghijklmnopq ABCDEFGHIJKLMNOPQRSTUVWXYZ012345 _bcdefghijklmnopqrstuvwxyz_012345 returnabcdefghijk x0123456789abcdef+y")
+	TEST(test_lexer_location, "ident_eof", "x abcdefghijklmnopqrstuvwxyz0123456")
+	TEST(test_keyword, "lookup", "iff ifs int8 intx voids bool1 trues elses falses exported returns iF Void eXport retur els fals")
 	TEST(test_lexer, "operator", "= + - * / % ++ -- += -= *= /= %= ! != == < > <= >= & | ^ ~ << >> &= |= ^= <<= >>= && || ? :")
 
+	TEST(test_prelex, "basic",      "export int main() { return 0; }")
+	TEST(test_prelex, "expression", "int a = 1 + 2 * 3; bool b = a >= 7 && a != 0; export int main() { return a << 1 >> 1; }")
+	TEST_WRONG(test_prelex, "unexpected_eof", "export int main() { return 0;")
+
 	TEST(test_parser, "basic",                "export int main() { return 0; }")
 	TEST(test_parser, "functions1",           "void print() {} int foo() { return 0; } bool check() { return true; }")
 	TEST(test_parser, "functions2",           "int a = 0; bool b = true; int foo() { return a; } bool check() { return b; }")
@@ -386,6 +1062,7 @@ static TestCase tests[] =
 	TEST_WRONG(test_analyzer, "basic_wrong1",                "int main() { return 0; }")
 	TEST_WRONG(test_analyzer, "basic_wrong2",                "export void main() { return 0; }")
 	TEST_WRONG(test_analyzer, "basic_wrong3",                "export int main() { return foo(); }")
+	TEST_WRONG(test_analyzer, "basic_wrong4",                "export int main(int a) { return a; }")
 	TEST_WRONG(test_analyzer, "global_variant_wrong1",       "export int a = 0; int a = 1;")
 	TEST_WRONG(test_analyzer, "global_variant_wrong2",       "void a;")
 	TEST_WRONG(test_analyzer, "global_variant_wrong3",       "int a = \"1\";")
@@ -473,6 +1150,10 @@ static TestCase tests[] =
 	TEST_WRONG(test_analyzer, "rshift_statement_wrong1",    "int a = 1; export int main() { a >>= true; return a; }")
 	TEST_WRONG(test_analyzer, "rshift_statement_wrong1",    "int a = 1; export int main() { a >>= b; return a; }")
 	TEST_WRONG(test_analyzer, "rshift_statement_wrong1",    "int a = 2; int b = a >>= 1;")
+	TEST_WRONG(test_analyzer, "constant_div_zero_wrong1",   "int a = 1 / (2 - 2);")
+	TEST_WRONG(test_analyzer, "constant_div_zero_wrong2",   "export int main() { int a = 4; a %= true ? 0 : 1; return a; }")
+	TEST_WRONG(test_analyzer, "shift_range_wrong1",         "int a = 1 << 32;")
+	TEST_WRONG(test_analyzer, "shift_range_wrong2",         "export int main() { int a = 1; a >>= 0 - 1; return a; }")
 
 
 	TEST(test_executor, "basic",                "export int main() { return 12345; }")
@@ -489,9 +1170,13 @@ static TestCase tests[] =
 	TEST(test_executor, "local_variant4",       "export int main() { int a = 1; { int a = 2; return a; } }")
 	TEST(test_executor, "multi_block1",         "export int main() { int a = 1; { int a = 2; { int b = a; return b; } } }")
 	TEST(test_executor, "multi_block2",         "export int main() { int a = 1; { int b = 2; } int b = 3; { int a = 4; int b = 5;} return b; }")
+	TEST(test_executor, "multi_block3",         "export int main() { int a = 1; { int b = a + 1; a = b; } { int c = 5; a += c; } return a; }")
 	TEST(test_executor, "function_argument1",   "int foo(int a, int b) { return a; } export int main() { return foo(1, 2); }")
 	TEST(test_executor, "function_argument2",   "int foo(int a, int b) { return a; } int bar() { return 6; } export int main() { return foo(bar(), 2); }")
 	TEST(test_executor, "function_argument3",   "int f1(int a) { return a; } int f2(int b) { return b; } int f3(int c) { return c; } export int main() { return f1(f2(f3(4))); }")
+	TEST(test_executor, "function_argument4",   "int sub(int a, int b) { return a - b; } export int main() { int x = 7; return sub(sub(x, 1), x - 5); }")
+	TEST(test_executor, "recursion",            "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); } export int main() { return fib(15); }")
+	TEST(test_executor, "deep_recursion",       "int depth(int n) { int a = n; if (n == 0) return 0; return depth(n - 1) + 1; } export int main() { return depth(5000); }")
 	TEST(test_executor, "variant_assign1",      "int a = 0; export int main() { a = 1; return a; }")
 	TEST(test_executor, "variant_assign2",      "export int main() { int a = 1; a = 2; return a; }")
 	TEST(test_executor, "variant_assign3",      "export int main() { int a = 2; return a = 3; }")
@@ -565,11 +1250,66 @@ static TestCase tests[] =
 	TEST(test_executor, "xor_assign_statement",    "int a = 3; export int main() { a ^= 2; return a; }")
 	TEST(test_executor, "lshift_assign_statement", "int a = 1; export int main() { a <<= 1; return a; }")
 	TEST(test_executor, "rshift_assign_statement", "int a = 2; export int main() { a >>= 1; return a; }")
+	TEST(test_executor, "constant_fold1",          "int a = 10 / 3 * 3 + 10 % 3; bool b = a == 10 && !(a < 0); export int main() { return b ? a << 2 >> 1 : -1; }")
+	TEST(test_executor, "constant_fold2",          "export int main() { int x = 5; bool t = 1 < 2 || x > 0; return (3 > 4 ? x : x * 2) + -(~0); }")
+	TEST(test_executor, "bool_condition",          "bool pick(bool c, bool x, bool y) { return c ? x : y; } export int main() { bool r = pick(true, false, true); return r == false ? 1 : 2; }")
+	TEST(test_executor, "condition_branch",        "int n = 100; int bump() { n += 5; return n; } export int main() { bool c = false; int z = 0; int a = c ? bump() : 5; int b = z != 0 ? 10 / z : 7; int d = !c ? bump() : 0; return a + b + d + n; }")
+	TEST(test_executor, "argument_order",          "int n = 1; int bump() { n += 1; return n; } int pair(int a, int b) { return a * 10 + b; } export int main() { return pair(bump(), bump()); }")
+	TEST(test_executor, "nested_call_args",        "int g = add(1, 2); int add(int a, int b) { return a + b; } int pick(bool c, int x, int y) { return c ? x : y; } export int main() { int v = 4; return add(pick(v > g, add(v, g), -v), add(pick(false, 1, 2) * 3, g)); }")
 
 	TEST_WRONG(test_executor, "div_expression_wrong", "int a = 10; int b = 0; export int main() { return a / b; }")
 	TEST_WRONG(test_executor, "mod_expression_wrong", "int a = 10; int b = 0; export int main() { return a % b; }")
 	TEST_WRONG(test_executor, "div_assign_statement_wrong", "int a = 10; int b = 0; export int main() { a /= b; return 0; }")
 	TEST_WRONG(test_executor, "mod_assign_statement_wrong", "int a = 10; int b = 0; export int main() { a %= b; return 0; }")
+	TEST_WRONG(test_executor, "stack_overflow",             "int f(int n) { return f(n + 1); } export int main() { return f(0); }")
+
+	TEST(test_vm, "basic",                "export int main() { return 12345; }")
+	TEST(test_vm, "void_function",        "void foo() { } export int main() { foo(); return 0; }")
+	TEST(test_vm, "function_call1",       "int foo() { return 1; } export int main() { return foo(); }")
+	TEST(test_vm, "function_call2",       "export int main() { return bar(); } int bar() { return foo(); } int foo() { return 666; }")
+	TEST(test_vm, "global_variant1",      "int a = 666; export int main() { return a; }")
+	TEST(test_vm, "global_variant2",      "export int main() { return a; }\nint a = 1234;")
+	TEST(test_vm, "global_variant_init1", "int a = foo(); int foo() { return 1234; } export int main() { return a; }")
+	TEST(test_vm, "local_variant1",       "export int main() { int a = 123; { int b = a; return b; } }")
+	TEST(test_vm, "local_variant2",       "export int main() { int a = 1; { int a = 2; return a; } }")
+	TEST(test_vm, "multi_block",          "export int main() { int a = 1; { int b = 2; } int b = 3; { int a = 4; int b = 5;} return b; }")
+	TEST(test_vm, "function_argument1",   "int foo(int a, int b) { return b; } export int main() { return foo(1, 2); }")
+	TEST(test_vm, "function_argument2",   "int f1(int a) { return a; } int f2(int b) { return b; } int f3(int c) { return c; } export int main() { return f1(f2(f3(4))); }")
+	TEST(test_vm, "function_argument3",   "int add(int a, int b) { return a + b; } export int main() { int x = 3; return add(add(x, 1), add(2, x)); }")
+	TEST(test_vm, "recursion",            "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); } export int main() { return fib(20); }")
+	TEST(test_vm, "variant_assign1",      "int a = 0; export int main() { a = 1; return a; }")
+	TEST(test_vm, "variant_assign2",      "export int main() { int a = 1; int b = 2; int c = 3; a = b = c = 4; return a; }")
+	TEST(test_vm, "operation1",           "int a = -1; int b = -a; int c = -a + -b; int d = +a - -b; export int main() { return d; }")
+	TEST(test_vm, "operation2",           "int a = 1 * 2 + 3 * 4 - 6 / 2 + 19 % 2; export int main() { return a; }")
+	TEST(test_vm, "operation3",           "int a = (1 + 1) * 2; int b = (1 + 1) * (2 + 2); export int main() { return a * b; }")
+	TEST(test_vm, "operation4",           "export int main() { int a = 3; return (a & 1) | (a ^ 6) << 1 >> 1 | ~a; }")
+	TEST(test_vm, "inc_dec_statement",    "int a = 1; export int main() { int b = 5; a++; a++; b--; return a * b; }")
+	TEST(test_vm, "assign_statement",     "int a = 2; export int main() { int b = 3; a += b; a -= 1; a *= b; a /= 2; a %= 4; a <<= 3; a >>= 1; a |= 1; a &= 7; a ^= 2; return a; }")
+	TEST(test_vm, "if_statement1",        "export int main() { bool a = false; if (a) { return 1; } else return 2; return 0; }")
+	TEST(test_vm, "if_statement2",        "export int main() { if (true) if (!false) return 1; else return 2; else return 3;  return 0; }")
+	TEST(test_vm, "if_statement3",        "export int main() { if (!true) if (true) return 1; else return 2; else return 3;  return 0; }")
+	TEST(test_vm, "compare_expression",   "export int main() { int a = 2; if (a == 2 && a != 3 && a < 3 && a <= 2 && a > 1 && a >= 2) return 1; return 0; }")
+	TEST(test_vm, "equals_expression",    "bool b = 1 + 1 == 2; bool d = b == false; export int main() { if (d) return 1; return 0; }")
+	TEST(test_vm, "and_expression",       "int a = 0; bool set() { a = 1; return true; } export int main() { if (false && set()) return 2; return a; }")
+	TEST(test_vm, "or_expression",        "int a = 0; bool set() { a = 1; return true; } export int main() { if (true || set()) return a; return 2; }")
+	TEST(test_vm, "cond_expression",      "export int main() { int a = 5; int b = a > 3 ? a * 2 : a; return b; }")
+	TEST(test_vm, "argument_order",       "int n = 1; int bump() { n += 1; return n; } int pair(int a, int b) { return a * 10 + b; } export int main() { return pair(bump(), bump()); }")
+	TEST(test_vm, "constant_fold",        "export int main() { int a = 1 + 2 * 3; return true ? a << (4 - 3) : 0; }")
+	TEST_WRONG(test_vm, "div_expression_wrong", "int a = 10; int b = 0; export int main() { return a / b; }")
+	TEST_WRONG(test_vm, "mod_assign_statement_wrong", "int a = 10; int b = 0; export int main() { a %= b; return 0; }")
+	TEST_WRONG(test_vm, "stack_overflow",       "int f() { return f(); } export int main() { return f(); }")
+	TEST_WRONG(test_vm, "stack_overflow_argument", "int f(int n) { return f(n + 1); } export int main() { return f(0); }")
+
+	TEST(test_jit, "basic",           "export int main() { return 0; }")
+	TEST(test_jit, "global_variant",  "int a = 7; int b = foo(); int foo() { return a * 2; } export int main() { return a + b; }")
+	TEST(test_jit, "expression",      "export int main() { int a = -17; int b = 5; bool c = a < b && !(b == 0) || false; return c ? a / b + a % b + (b << 2) + (a >> 1) : 0; }")
+	TEST(test_jit, "statement",       "int g = 1; export int main() { int a = 3; { int b = a; a += b; } if (a > 5) g <<= a; else g = 0; a ^= 1; a++; return g - a; }")
+	TEST(test_jit, "argument_order",  "int n = 1; int bump() { n += 1; return n; } int pair(int a, int b) { return a * 10 + b; } export int main() { return pair(bump(), bump()); }")
+	TEST(test_jit, "deep_recursion",  "int d(int n) { if (n == 0) return 0; return d(n - 1) + 1; } export int main() { return d(200000); }")
+	TEST(test_jit, "recursion",       "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); } export int main() { return fib(20); }")
+	TEST_WRONG(test_jit, "div_zero",  "int z = 0; int f(int a) { return 10 / a; } export int main() { return f(z); }")
+	TEST_WRONG(test_jit, "stack_overflow", "int f(int n) { return f(n + 1); } export int main() { return f(0); }")
+	TEST_WRONG(test_jit, "stack_overflow_call", "int f() { return f(); } export int main() { return f(); }")
 
 	TEST(test_generator, "basic",               "export int main() { return 0; }")
 	TEST(test_generator, "function_call1",      "int foo() { return 1; } export int main() { return foo(); }")
@@ -656,6 +1396,40 @@ static TestCase tests[] =
 	TEST(test_generator, "xor_assign_statement",    "int a = 3; export int main() { a ^= 2; return a; }")
 	TEST(test_generator, "lshift_assign_statement", "int a = 1; export int main() { a <<= 1; return a; }")
 	TEST(test_generator, "rshift_assign_statement", "int a = 2; export int main() { a >>= 1; return a; }")
+	TEST(test_generator, "constant_fold",           "int a = 2 * 3 + 1; bool b = true && 1 > 2; export int main() { int c = a + 4 * 2; return false || b ? c : -(c - 1); }")
+
+	TEST(test_annotation, "expression", "int a = 1; bool f(int x) { return x > a; } export int main() { bool b = f(2) == !false; return b ? a + 1 : -a; }")
+
+	TEST(test_shared, "executor",       "int g = 3; int h = f(4); int f(int x) { g += x; return g * 2; } export int main() { int s = 0; if (h > 10) { s = f(1) + g; } s <<= 1; return s; }")
+
+	TEST(test_batch, "rows",            "int n = 0; int g(int x) { n += 1; return x * n; } export int f(int a, int b) { return g(a) - b; }")
+	TEST_WRONG(test_batch, "row_values", "export int f(int a, bool b) { return a; } export int main() { return 0; }")
+
+	TEST(test_stats, "counts",         "int a = 1 + 2; int f(int x) { if (x > a) { x -= 1; } else x++; return f(x) * -x; } export int main() { return a ? 0 : 1; }")
+
+	TEST(test_profile, "calls",         "int g(int x) { return x * 2; } int f(int n) { if (n <= 1) return g(n); return f(n - 1) + g(n); } export int main() { int s = 0; s += f(3); return s; }")
+
+	TEST(test_serializer, "basic",      "export int main() { return 0; }")
+	TEST(test_serializer, "module",     "int a = foo(); bool t = a > 1; int foo() { return 3; } int add(int x, int y) { int s = x + y; return s; } export int main() { int b = -a; if (t && !false) { b += add(a, 2) * 2; } else b = 0; b++; return t ? b % 7 << 1 : ~b; }")
+
+	TEST(test_library, "run",           "int g = 1; export int f(int a, bool b) { return b ? a * g : -a; } export int main() { g += 1; return g; }")
+	TEST(test_library, "compile_error", "export int main() { return 1 }")
+	TEST(test_library, "missing_operand", "export int f(int a) { return a +; }")
+	TEST(test_library, "missing_argument", "int g(int a) { return a; } export int f(int a) { if (a > 0) { return g(,); } return 0; }")
+	TEST(test_library, "trailing_comma",  "int g(int a) { return a; } export int f(int a, bool b) { return g(g(a),); } export int main() { return g(2,); }")
+	TEST(test_library, "type_error",    "export int main() { return true; }")
+	TEST(test_library, "runtime_error", "int z = 0; int f(int a, int b) { return a; } export int main() { return 1 / z; }")
+
+	TEST(test_unit, "basic",          "export int main() { return 0; }")
+	TEST(test_unit, "export",         "int a = foo(); export int b = 1; int foo() { return b + 1; } export int bar(int x) { return foo() + x; } export int main() { return bar(a); }")
+
+	TEST(test_x64, "basic",           "export int main() { return 0; }")
+	TEST(test_x64, "global_variant",  "int a = 7; int b = foo(); int foo() { return a * 2; } export int main() { return a + b; }")
+	TEST(test_x64, "local_variant",   "export int main() { int a = 1; int b = 2; int c = 3; int d = 4; int e = 5; int f = 6; int g = 7; return a + b + c + d + e + f + g; }")
+	TEST(test_x64, "function_call",   "int f(int a, int b, int c, int d, int e, int g, int h, bool i) { return i ? a - b + c * d - e + g * h : 0; } export int main() { return f(1, 2, 3, 4, 5, 6, 7, true); }")
+	TEST(test_x64, "recursion",       "int fib(int n) { if (n < 2) return n; return fib(n - 1) + fib(n - 2); } export int main() { return fib(10); }")
+	TEST(test_x64, "expression",      "export int main() { int a = -17; int b = 5; bool c = a < b && !(b == 0) || false; return c ? a / b + a % b + (b << 2) + (a >> 1) : 0; }")
+	TEST(test_x64, "statement",       "int g = 1; export int main() { int a = 3; { int b = a; a += b; } if (a > 5) g <<= a; else g = 0; a ^= 1; return g - a; }")
 
 };
 #undef TEST
@@ -815,6 +1589,14 @@ int main(int argc, char** argv)
 		{
 			TEST(test_lexer, file, buf)
 		}
+		else if (strcmp(base, "lexer_location") == 0)
+		{
+			TEST(test_lexer_location, file, buf)
+		}
+		else if (strcmp(base, "keyword") == 0)
+		{
+			TEST(test_keyword, file, buf)
+		}
 		else if (strcmp(base, "parser") == 0)
 		{
 			TEST(test_parser, file, buf)
@@ -823,14 +1605,58 @@ int main(int argc, char** argv)
 		{
 			TEST(test_analyzer, file, buf)
 		}
+		else if (strcmp(base, "annotation") == 0)
+		{
+			TEST(test_annotation, file, buf)
+		}
 		else if (strcmp(base, "executor") == 0)
 		{
 			TEST(test_executor, file, buf)
 		}
+		else if (strcmp(base, "vm") == 0)
+		{
+			TEST(test_vm, file, buf)
+		}
+		else if (strcmp(base, "jit") == 0)
+		{
+			TEST(test_jit, file, buf)
+		}
 		else if (strcmp(base, "generator") == 0)
 		{
 			TEST(test_generator, file, buf)
 		}
+		else if (strcmp(base, "shared") == 0)
+		{
+			TEST(test_shared, file, buf)
+		}
+		else if (strcmp(base, "batch") == 0)
+		{
+			TEST(test_batch, file, buf)
+		}
+		else if (strcmp(base, "stats") == 0)
+		{
+			TEST(test_stats, file, buf)
+		}
+		else if (strcmp(base, "profile") == 0)
+		{
+			TEST(test_profile, file, buf)
+		}
+		else if (strcmp(base, "serializer") == 0)
+		{
+			TEST(test_serializer, file, buf)
+		}
+		else if (strcmp(base, "library") == 0)
+		{
+			TEST(test_library, file, buf)
+		}
+		else if (strcmp(base, "unit") == 0)
+		{
+			TEST(test_unit, file, buf)
+		}
+		else if (strcmp(base, "x64") == 0)
+		{
+			TEST(test_x64, file, buf)
+		}
 		else
 		{
 			printf("unknown base %s!\n", base);
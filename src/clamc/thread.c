@@ -0,0 +1,153 @@
+#ifdef __linux__
+#define _GNU_SOURCE  //pthread_getattr_np
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "thread.h"
+
+#ifdef _MSC_VER
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif
+
+#define THREAD_STACK_RESERVE (256 * 1024)  //left for error reporting below stack limit
+
+#ifdef _WIN32
+static DWORD WINAPI _Thread_entry(LPVOID arg);
+#else
+static void* _Thread_entry(void* arg);
+#endif
+static uintptr_t _Thread_stackLow();
+
+static THREAD_LOCAL uintptr_t stackLow;  //lowest address of current thread stack, 0 if not queried yet
+
+bool Thread_start(Thread* t, ThreadFunc func, void* arg)
+{
+	t->func = func;
+	t->arg = arg;
+#ifdef _WIN32
+	t->handle = CreateThread(NULL, THREAD_STACK, _Thread_entry, t, STACK_SIZE_PARAM_IS_A_RESERVATION, NULL);
+	return t->handle != NULL;
+#else
+	pthread_attr_t attr;
+	pthread_attr_init(&attr);
+	pthread_attr_setstacksize(&attr, THREAD_STACK);
+	bool started = pthread_create(&t->handle, &attr, _Thread_entry, t) == 0;
+	pthread_attr_destroy(&attr);
+	return started;
+#endif
+}
+
+void Thread_join(Thread* t)
+{
+#ifdef _WIN32
+	WaitForSingleObject(t->handle, INFINITE);
+	CloseHandle(t->handle);
+#else
+	pthread_join(t->handle, NULL);
+#endif
+}
+
+uintptr_t Thread_stackLimit(size_t budget)
+{
+	char marker;
+	uintptr_t here = (uintptr_t)&marker;
+	uintptr_t limit = here > budget ? here - budget : 0;
+
+	//main thread stack is only as large as system allows, which may be less than budget
+	uintptr_t low = _Thread_stackLow();
+	if (low && low + THREAD_STACK_RESERVE > limit)
+		limit = low + THREAD_STACK_RESERVE;
+	return limit;
+}
+
+int Thread_cpuCount()
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (int)n : 1;
+#endif
+}
+
+#ifdef _WIN32
+DWORD WINAPI _Thread_entry(LPVOID arg)
+{
+	Thread* t = arg;
+	t->func(t->arg);
+	return 0;
+}
+#else
+void* _Thread_entry(void* arg)
+{
+	Thread* t = arg;
+	t->func(t->arg);
+	return NULL;
+}
+#endif
+
+uintptr_t _Thread_stackLow()
+{
+	if (stackLow)
+		return stackLow;
+
+#if defined(_WIN32)
+	ULONG_PTR low, high;
+	GetCurrentThreadStackLimits(&low, &high);
+	stackLow = (uintptr_t)low;
+#elif defined(__linux__)
+	pthread_attr_t attr;
+	if (pthread_getattr_np(pthread_self(), &attr) == 0)
+	{
+		void* addr;
+		size_t size;
+		if (pthread_attr_getstack(&attr, &addr, &size) == 0)
+			stackLow = (uintptr_t)addr;
+		pthread_attr_destroy(&attr);
+	}
+#endif
+	return stackLow;
+}
+
+void Mutex_init(Mutex* m)
+{
+#ifdef _WIN32
+	InitializeSRWLock((PSRWLOCK)&m->lock);
+#else
+	pthread_mutex_init(&m->lock, NULL);
+#endif
+}
+
+void Mutex_destroy(Mutex* m)
+{
+#ifndef _WIN32
+	pthread_mutex_destroy(&m->lock);
+#endif
+}
+
+void Mutex_lock(Mutex* m)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive((PSRWLOCK)&m->lock);
+#else
+	pthread_mutex_lock(&m->lock);
+#endif
+}
+
+void Mutex_unlock(Mutex* m)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive((PSRWLOCK)&m->lock);
+#else
+	pthread_mutex_unlock(&m->lock);
+#endif
+}
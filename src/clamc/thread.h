@@ -0,0 +1,52 @@
+#ifndef CLAM_THREAD_H
+#define CLAM_THREAD_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef _WIN32
+#include <pthread.h>
+#endif
+
+#define THREAD_STACK (8 * 1024 * 1024)  //interpreters recurse in C, do not depend on system default
+
+typedef void(*ThreadFunc)(void* arg);
+
+struct Thread
+{
+#ifdef _WIN32
+	void* handle;
+#else
+	pthread_t handle;
+#endif
+	ThreadFunc func;
+	void* arg;
+};
+typedef struct Thread Thread;
+
+bool Thread_start(Thread* t, ThreadFunc func, void* arg);
+void Thread_join(Thread* t);
+
+//calls of current thread overflow below returned address, budget bytes below caller
+//or near the end of thread stack if that comes first
+uintptr_t Thread_stackLimit(size_t budget);
+
+int Thread_cpuCount();
+
+struct Mutex
+{
+#ifdef _WIN32
+	void* lock;  //SRWLOCK
+#else
+	pthread_mutex_t lock;
+#endif
+};
+typedef struct Mutex Mutex;
+
+void Mutex_init(Mutex* m);
+void Mutex_destroy(Mutex* m);
+void Mutex_lock(Mutex* m);
+void Mutex_unlock(Mutex* m);
+
+#endif
@@ -0,0 +1,9 @@
+#ifndef CLAM_TIMER_H
+#define CLAM_TIMER_H
+
+//monotonic clock in seconds
+double Timer_now();
+//cpu time of calling thread in seconds
+double Timer_threadCpu();
+
+#endif
@@ -28,3 +28,58 @@ void Token_reset(Token* token, SourceLocation loc, TokenType type, TokenValue va
 	token->value = value;
 	token->base = TOKEN_NUM_DEC;
 }
+
+void TokenBuffer_init(TokenBuffer* buf)
+{
+	Vector_init(&buf->types, sizeof(unsigned char));
+	Vector_init(&buf->values, sizeof(unsigned char));
+	Vector_init(&buf->offsets, sizeof(unsigned int));
+	Vector_init(&buf->lengths, sizeof(int));
+	Vector_init(&buf->lines, sizeof(int));
+	Vector_init(&buf->colums, sizeof(int));
+	buf->size = 0;
+}
+
+void TokenBuffer_destroy(TokenBuffer* buf)
+{
+	Vector_destroy(&buf->types);
+	Vector_destroy(&buf->values);
+	Vector_destroy(&buf->offsets);
+	Vector_destroy(&buf->lengths);
+	Vector_destroy(&buf->lines);
+	Vector_destroy(&buf->colums);
+	buf->size = 0;
+}
+
+void TokenBuffer_add(TokenBuffer* buf, Token* token, const char* data)
+{
+	int i = buf->size++;
+	if (buf->size > buf->types.cap)
+	{
+		int cap = buf->types.cap ? buf->types.cap * 2 : 1024;
+		Vector_reserve(&buf->types, cap);
+		Vector_reserve(&buf->values, cap);
+		Vector_reserve(&buf->offsets, cap);
+		Vector_reserve(&buf->lengths, cap);
+		Vector_reserve(&buf->lines, cap);
+		Vector_reserve(&buf->colums, cap);
+	}
+
+	((unsigned char*)buf->types.data)[i] = (unsigned char)token->type;
+	((unsigned char*)buf->values.data)[i] = (unsigned char)token->value;
+	((unsigned int*)buf->offsets.data)[i] = token->literal.data ? (unsigned int)(token->literal.data - data) : 0;
+	((int*)buf->lengths.data)[i] = token->literal.length;
+	((int*)buf->lines.data)[i] = token->location.line;
+	((int*)buf->colums.data)[i] = token->location.colum;
+}
+
+void TokenBuffer_get(TokenBuffer* buf, int index, const char* data, Token* token)
+{
+	token->type = ((unsigned char*)buf->types.data)[index];
+	token->value = ((unsigned char*)buf->values.data)[index];
+	token->base = TOKEN_NUM_DEC;
+	token->literal.data = data + ((unsigned int*)buf->offsets.data)[index];
+	token->literal.length = ((int*)buf->lengths.data)[index];
+	token->location.line = ((int*)buf->lines.data)[index];
+	token->location.colum = ((int*)buf->colums.data)[index];
+}
@@ -3,6 +3,7 @@
 
 #include "source_location.h"
 #include "strings.h"
+#include "vector.h"
 
 enum TokenType
 {
@@ -118,4 +119,24 @@ void Token_init(Token* token, const char* filename);
 void Token_destroy(Token* token);
 void Token_reset(Token* token, SourceLocation loc, TokenType type, TokenValue value);
 
+//pre-lexed tokens in structure of arrays, literal kept as offset into source data
+struct TokenBuffer
+{
+	Vector types;    //Vector<unsigned char>
+	Vector values;   //Vector<unsigned char>
+	Vector offsets;  //Vector<unsigned int>
+	Vector lengths;  //Vector<int>
+	Vector lines;    //Vector<int>
+	Vector colums;   //Vector<int>
+	int size;
+};
+typedef struct TokenBuffer TokenBuffer;
+
+void TokenBuffer_init(TokenBuffer* buf);
+void TokenBuffer_destroy(TokenBuffer* buf);
+void TokenBuffer_add(TokenBuffer* buf, Token* token, const char* data);
+
+//fill token from buffer, keep token location filename
+void TokenBuffer_get(TokenBuffer* buf, int index, const char* data, Token* token);
+
 #endif
\ No newline at end of file
@@ -6,26 +6,26 @@ void Type_init(Type* typ)
 	typ->id = TYPE_INIT;
 }
 
-Type errorType =
+const Type errorType =
 {
 	String_literal("error-type"),
 	TYPE_INIT
 };
 
-Type voidType =
+const Type voidType =
 {
 	String_literal("void"),
 	TYPE_VOID
 };
 
-Type intType =
+const Type intType =
 {
 	String_literal("int"),
 	TYPE_INT
 };
 
 
-Type boolType =
+const Type boolType =
 {
 	String_literal("bool"),
 	TYPE_BOOL
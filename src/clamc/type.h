@@ -19,10 +19,10 @@ struct Type
 };
 typedef struct Type Type;
 
-extern Type errorType;
-extern Type voidType;
-extern Type intType;
-extern Type boolType;
+extern const Type errorType;
+extern const Type voidType;
+extern const Type intType;
+extern const Type boolType;
 
 void Type_init(Type* typ);
 
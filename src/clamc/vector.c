@@ -55,7 +55,21 @@ void Vector_add(Vector* vec, void* elem)
 	vec->size++;
 }
 
-void* Vector_get(Vector* vec, int index)
+void Vector_resizeArena(Vector* vec, int size, Arena* arena)
+{
+	if (size > vec->cap)
+	{
+		//old storage stays in arena until arena is released
+		void* data = Arena_alloc(arena, (size_t)vec->elemSize * size);
+		if (vec->size)
+			memcpy(data, vec->data, (size_t)vec->elemSize * vec->size);
+		vec->data = data;
+		vec->cap = size;
+	}
+	vec->size = size;
+}
+
+void* Vector_get(const Vector* vec, int index)
 {
 	return (char*)vec->data + index * vec->elemSize;
 }
@@ -1,6 +1,8 @@
 #ifndef CLAM_VECTOR_H
 #define CLAM_VECTOR_H
 
+#include "arena.h"
+
 struct Vector
 {
 	void* data;
@@ -15,6 +17,9 @@ void Vector_destroy(Vector* vec);
 void Vector_reserve(Vector* vec, int cap);
 void Vector_resize(Vector* vec, int size);
 void Vector_add(Vector* vec, void* elem);
-void* Vector_get(Vector* vec, int index);
+void* Vector_get(const Vector* vec, int index);
+
+//storage from arena instead of heap, released with arena and never by Vector_destroy
+void Vector_resizeArena(Vector* vec, int size, Arena* arena);
 
 #endif
\ No newline at end of file
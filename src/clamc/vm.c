@@ -0,0 +1,298 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "vm.h"
+#include "jit.h"
+#include "message.h"
+
+struct Frame
+{
+	int chunk;
+	int pc;
+	int base;
+};
+typedef struct Frame Frame;
+
+static int _VM_call(VM* vm, int entry, int base);
+static int* _VM_reserve(VM* vm, int size);
+
+void VM_init(VM* vm)
+{
+	Vector_init(&vm->registers, sizeof(int));
+	Stack_init(&vm->frames, sizeof(Frame));
+	Vector_init(&vm->globals, sizeof(int));
+	Vector_reserve(&vm->registers, 1024);
+	vm->program = NULL;
+	vm->maxRegisters = VM_MAX_REGISTERS;
+	vm->jit = NULL;
+}
+
+void VM_destroy(VM* vm)
+{
+	Vector_destroy(&vm->registers);
+	Stack_destroy(&vm->frames);
+	Vector_destroy(&vm->globals);
+}
+
+void VM_run(VM* vm, const Program* program)
+{
+	VM_load(vm, program);
+
+	if (program->main < 0)
+		error(NULL, "function 'main' not found");
+
+	//call main
+	int ret = VM_call(vm, program->main, NULL, 0);  //analyzer allows no parameters
+
+	//output main return
+	printf("main return %d\n", ret);
+}
+
+void VM_load(VM* vm, const Program* program)
+{
+	vm->program = program;
+	Vector_resize(&vm->frames, 0);
+	if (vm->jit && vm->jit->program != program)  //keep compiled code when loading same program again
+		Jit_prepare(vm->jit, program);
+	if (vm->jit)
+		Jit_reset(vm->jit);
+
+	//global variants
+	Vector_resize(&vm->globals, program->globalCount);
+	if (program->globalCount)
+		memset(vm->globals.data, 0, program->globalCount * sizeof(int));
+	_VM_call(vm, program->init, 0);
+}
+
+int VM_call(VM* vm, int entry, const int* args, int count)
+{
+	//frames left by a call aborted with error are dropped
+	Vector_resize(&vm->frames, 0);
+	if (vm->jit)
+		Jit_reset(vm->jit);
+
+	int* r = _VM_reserve(vm, count);
+	if (count)
+		memcpy(r, args, count * sizeof(int));
+
+	return _VM_call(vm, entry, 0);
+}
+
+int VM_execute(VM* vm, int entry, int base)
+{
+	Chunk* chunk = Vector_get(&vm->program->chunks, entry);
+	Instruction* code = chunk->code.data;
+	int* globals = vm->globals.data;
+	int* r = _VM_reserve(vm, base + chunk->frameSize) + base;
+	int depth = vm->frames.size;  //frames above it are pushed by this execution
+	int pc = 0;
+	int value;
+	Frame frame;
+	Chunk* callee;
+
+	for (;;)
+	{
+		Instruction* ins = &code[pc++];
+
+		switch (ins->op)
+		{
+		case OP_NOP:
+			break;
+
+		case OP_LOADK:
+			r[ins->a] = ins->imm;
+			break;
+
+		case OP_MOVE:
+			r[ins->a] = r[ins->b];
+			break;
+
+		case OP_GETGLOBAL:
+			r[ins->a] = globals[ins->b];
+			break;
+
+		case OP_SETGLOBAL:
+			globals[ins->a] = r[ins->b];
+			break;
+
+		case OP_NEGI:
+			r[ins->a] = -r[ins->b];
+			break;
+
+		case OP_BITNOTI:
+			r[ins->a] = ~r[ins->b];
+			break;
+
+		case OP_NOTB:
+			r[ins->a] = !r[ins->b];
+			break;
+
+		case OP_INCI:
+			r[ins->a]++;
+			break;
+
+		case OP_DECI:
+			r[ins->a]--;
+			break;
+
+		case OP_ADDI:
+			r[ins->a] = r[ins->b] + r[ins->c];
+			break;
+
+		case OP_SUBI:
+			r[ins->a] = r[ins->b] - r[ins->c];
+			break;
+
+		case OP_MULI:
+			r[ins->a] = r[ins->b] * r[ins->c];
+			break;
+
+		case OP_DIVI:
+		case OP_MODI:
+			if (r[ins->c] == 0)
+				error(Vector_get(&chunk->locations, pc - 1), "right value is zero, division by zero");
+
+			if (ins->op == OP_DIVI)
+				r[ins->a] = r[ins->b] / r[ins->c];
+			else
+				r[ins->a] = r[ins->b] % r[ins->c];
+			break;
+
+		case OP_BITANDI:
+			r[ins->a] = r[ins->b] & r[ins->c];
+			break;
+
+		case OP_BITORI:
+			r[ins->a] = r[ins->b] | r[ins->c];
+			break;
+
+		case OP_XORI:
+			r[ins->a] = r[ins->b] ^ r[ins->c];
+			break;
+
+		case OP_SHLI:
+			r[ins->a] = r[ins->b] << r[ins->c];
+			break;
+
+		case OP_SHRI:
+			r[ins->a] = r[ins->b] >> r[ins->c];
+			break;
+
+		case OP_EQI:
+			r[ins->a] = r[ins->b] == r[ins->c];
+			break;
+
+		case OP_NEI:
+			r[ins->a] = r[ins->b] != r[ins->c];
+			break;
+
+		case OP_LTI:
+			r[ins->a] = r[ins->b] < r[ins->c];
+			break;
+
+		case OP_LEI:
+			r[ins->a] = r[ins->b] <= r[ins->c];
+			break;
+
+		case OP_GTI:
+			r[ins->a] = r[ins->b] > r[ins->c];
+			break;
+
+		case OP_GEI:
+			r[ins->a] = r[ins->b] >= r[ins->c];
+			break;
+
+		case OP_JMP:
+			pc += ins->imm;
+			break;
+
+		case OP_JMPF:
+			if (!r[ins->a])
+				pc += ins->imm;
+			break;
+
+		case OP_JMPT:
+			if (r[ins->a])
+				pc += ins->imm;
+			break;
+
+		case OP_CALL:
+			//recursion always moves base up, see _Compiler_callExpression
+			callee = Vector_get(&vm->program->chunks, ins->b);
+			if (base + ins->a + callee->frameSize > vm->maxRegisters)
+				error(Vector_get(&chunk->locations, pc - 1), "stack overflow, call function '" String_FMT "'", String_arg(callee->name));
+
+			if (vm->jit && !vm->jit->interpret)
+			{
+				value = Jit_call(vm, ins->b, base + ins->a);
+				r = (int*)vm->registers.data + base;
+				r[ins->a] = value;
+				break;
+			}
+
+			//save caller
+			frame.chunk = entry;
+			frame.pc = pc;
+			frame.base = base;
+			Stack_push(&vm->frames, &frame);
+
+			//callee frame starts at argument registers
+			entry = ins->b;
+			base += ins->a;
+			chunk = callee;
+			code = chunk->code.data;
+			r = _VM_reserve(vm, base + chunk->frameSize) + base;
+			pc = 0;
+			break;
+
+		case OP_RET:
+		case OP_RETV:
+			value = ins->op == OP_RET ? r[ins->a] : 0;
+			if (vm->frames.size == depth)
+				return value;
+
+			//result register of caller is the callee base
+			r[0] = value;
+
+			//restore caller
+			frame = *(Frame*)Stack_pop(&vm->frames);
+			entry = frame.chunk;
+			base = frame.base;
+			chunk = Vector_get(&vm->program->chunks, entry);
+			code = chunk->code.data;
+			r = (int*)vm->registers.data + base;
+			pc = frame.pc;
+			break;
+
+		default:
+			error(Vector_get(&chunk->locations, pc - 1), "invalid instruction %d", ins->op);
+		}
+	}
+
+	return 0;
+}
+
+int _VM_call(VM* vm, int entry, int base)
+{
+	if (vm->jit)
+		return Jit_call(vm, entry, base);
+
+	return VM_execute(vm, entry, base);
+}
+
+int* _VM_reserve(VM* vm, int size)
+{
+	if (size > vm->maxRegisters)
+		error(NULL, "stack overflow");
+
+	if (size > vm->registers.cap)
+	{
+		int cap = vm->registers.cap * 2;
+		Vector_reserve(&vm->registers, cap > size ? cap : size);
+	}
+
+	if (size > vm->registers.size)
+		vm->registers.size = size;
+
+	return vm->registers.data;
+}
@@ -0,0 +1,36 @@
+#ifndef CLAM_VM_H
+#define CLAM_VM_H
+
+#include "vector.h"
+#include "stack.h"
+#include "bytecode.h"
+
+struct Jit;
+
+#define VM_MAX_REGISTERS (4 * 1024 * 1024)  //4M * sizeof(int)
+
+//register based virtual machine, program is only read and can be shared by vms on different threads
+struct VM
+{
+	Vector registers;  //Vector<int>, frames are windows of it
+	Stack frames;      //Stack<Frame>, caller frames
+	Vector globals;    //Vector<int>
+	const Program* program;
+	int maxRegisters;  //stack overflow above it
+	struct Jit* jit;   //compiles chunks to machine code, NULL to interpret only
+};
+typedef struct VM VM;
+
+void VM_init(VM* vm);
+void VM_destroy(VM* vm);
+void VM_run(VM* vm, const Program* program);
+
+//reset globals and run their initializers, then chunks can be called
+void VM_load(VM* vm, const Program* program);
+//call chunk from top level with arguments in its first registers, returns its result
+int VM_call(VM* vm, int entry, const int* args, int count);
+
+//interpret chunk with frame at base, callees still go through jit if enabled
+int VM_execute(VM* vm, int entry, int base);
+
+#endif
@@ -0,0 +1,556 @@
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#include "x64.h"
+#include "constant.h"
+#include "message.h"
+
+#define X64_SAVED_REGISTERS 5
+#define X64_ARG_REGISTERS   6
+
+static const char* savedRegister32[] = { "%ebx", "%r12d", "%r13d", "%r14d", "%r15d" };
+static const char* savedRegister64[] = { "%rbx", "%r12",  "%r13",  "%r14",  "%r15"  };
+static const char* argRegister32[]   = { "%edi", "%esi",  "%edx",  "%ecx",  "%r8d",  "%r9d" };
+static const char* argRegister8[]    = { "%dil", "%sil",  "%dl",   "%cl",   "%r8b",  "%r9b" };
+
+static void _X64Generator_globals(X64Generator* gen);
+static void _X64Generator_function(X64Generator* gen, Declaration* decl);
+static void _X64Generator_globalInit(X64Generator* gen);
+static void _X64Generator_prologue(X64Generator* gen, int frameSize);
+static void _X64Generator_epilogue(X64Generator* gen);
+static void _X64Generator_statement(X64Generator* gen, Statement* stat);
+static void _X64Generator_ifStatement(X64Generator* gen, Statement* stat);
+static void _X64Generator_assignStatement(X64Generator* gen, Statement* stat);
+static void _X64Generator_incDecStatement(X64Generator* gen, Statement* stat);
+static void _X64Generator_expression(X64Generator* gen, Expression* expr);
+static void _X64Generator_conditionExpression(X64Generator* gen, Expression* expr);
+static void _X64Generator_logicExpression(X64Generator* gen, Expression* expr);
+static void _X64Generator_callExpression(X64Generator* gen, Expression* expr);
+static void _X64Generator_unaryExpression(X64Generator* gen, Expression* expr);
+static void _X64Generator_binaryExpression(X64Generator* gen, Expression* expr);
+static void _X64Generator_operate(X64Generator* gen, ExprType type, SourceLocation* loc);
+static bool _X64Generator_isOperand(X64Generator* gen, Expression* expr);
+static void _X64Generator_emitOperand(X64Generator* gen, const char* op, Expression* expr, const char* rest);
+static void _X64Generator_emitSlot(X64Generator* gen, const char* op, int slot, const char* rest);
+static void _X64Generator_emit(X64Generator* gen, const char* fmt, ...);
+static int _X64Generator_newLabel(X64Generator* gen);
+
+void X64Generator_init(X64Generator* gen)
+{
+	gen->module = NULL;
+	gen->out = NULL;
+	gen->func = NULL;
+	gen->saved = 0;
+	gen->depth = 0;
+	gen->label = 0;
+	gen->retLabel = 0;
+}
+
+void X64Generator_destroy(X64Generator* gen)
+{
+}
+
+void X64Generator_generate(X64Generator* gen, Module* module, Rope* out)
+{
+	gen->module = module;
+	gen->out = out;
+
+	_X64Generator_globals(gen);
+
+	Rope_append(out, "\t.text\n");
+	for (int i = 0; i < module->functions.size; i++)
+		_X64Generator_function(gen, Vector_get(&module->functions, i));
+
+	_X64Generator_globalInit(gen);
+
+	Rope_append(out, "\t.section .note.GNU-stack,\"\",@progbits\n");
+}
+
+void _X64Generator_globals(X64Generator* gen)
+{
+	//int and bool globals are both 4 bytes, bool keeps 0 or 1 in the low byte
+	bool data = false;
+	for (int i = 0; i < gen->module->declarations.size; i++)
+	{
+		Declaration* decl = Vector_get(&gen->module->declarations, i);
+		if (decl->type != DECL_TYPE_VARIANT)
+			continue;
+
+		if (!data)
+		{
+			Rope_append(gen->out, "\t.data\n");
+			data = true;
+		}
+
+		Constant value;
+		value.intValue = 0;
+		if (!decl->variant.initExpr || !Constant_evaluate(decl->variant.initExpr, &value))
+			value.intValue = 0;
+		else if (value.type == TYPE_BOOL)
+			value.intValue = value.boolValue;
+
+		if (decl->exported)
+			Rope_appendFormat(gen->out, "\t.globl " String_FMT "\n", String_arg(decl->variant.name));
+		Rope_append(gen->out, "\t.align 4\n");
+		Rope_appendFormat(gen->out, String_FMT ":\n\t.long %d\n", String_arg(decl->variant.name), value.intValue);
+	}
+}
+
+void _X64Generator_function(X64Generator* gen, Declaration* decl)
+{
+	FuncDecl* func = &decl->function;
+	gen->func = func;
+
+	if (decl->exported)
+		Rope_appendFormat(gen->out, "\t.globl " String_FMT "\n", String_arg(func->name));
+	Rope_appendFormat(gen->out, "\t.type " String_FMT ", @function\n", String_arg(func->name));
+	Rope_appendFormat(gen->out, String_FMT ":\n", String_arg(func->name));
+
+	_X64Generator_prologue(gen, func->frameSize);
+
+	//move parameters to their slots
+	for (int i = 0; i < func->parameters.size; ++i)
+	{
+		Parameter* param = Vector_get(&func->parameters, i);
+		if (i < X64_ARG_REGISTERS)
+		{
+			if (param->type.id == TYPE_BOOL)
+				_X64Generator_emit(gen, "movzbl %s, %%eax", argRegister8[i]);
+			else
+				_X64Generator_emit(gen, "movl %s, %%eax", argRegister32[i]);
+		}
+		else
+		{
+			_X64Generator_emit(gen, "movl %d(%%rbp), %%eax", 16 + 8 * (i - X64_ARG_REGISTERS));
+			if (param->type.id == TYPE_BOOL)
+				_X64Generator_emit(gen, "movzbl %%al, %%eax");
+		}
+		_X64Generator_emitSlot(gen, "movl %eax,", i, "");
+	}
+
+	for (int i = 0; i < func->block.size; ++i)
+		_X64Generator_statement(gen, Vector_get(&func->block, i));
+
+	_X64Generator_epilogue(gen);
+	gen->func = NULL;
+}
+
+void _X64Generator_globalInit(X64Generator* gen)
+{
+	//globals without constant initializer are set before main by .init_array
+	int count = 0;
+	for (int i = 0; i < gen->module->declarations.size; i++)
+	{
+		Declaration* decl = Vector_get(&gen->module->declarations, i);
+		Constant value;
+		if (decl->type == DECL_TYPE_VARIANT && decl->variant.initExpr && !Constant_evaluate(decl->variant.initExpr, &value))
+			count++;
+	}
+
+	if (!count)
+		return;
+
+	Rope_append(gen->out, ".Lclam_init:\n");
+	_X64Generator_prologue(gen, 0);
+
+	for (int i = 0; i < gen->module->declarations.size; i++)
+	{
+		Declaration* decl = Vector_get(&gen->module->declarations, i);
+		Constant value;
+		if (decl->type != DECL_TYPE_VARIANT || !decl->variant.initExpr || Constant_evaluate(decl->variant.initExpr, &value))
+			continue;
+
+		_X64Generator_expression(gen, decl->variant.initExpr);
+		Rope_appendFormat(gen->out, "\tmovl %%eax, " String_FMT "(%%rip)\n", String_arg(decl->variant.name));
+	}
+
+	_X64Generator_epilogue(gen);
+
+	Rope_append(gen->out, "\t.section .init_array,\"aw\"\n\t.align 8\n\t.quad .Lclam_init\n\t.text\n");
+}
+
+void _X64Generator_prologue(X64Generator* gen, int frameSize)
+{
+	gen->saved = frameSize < X64_SAVED_REGISTERS ? frameSize : X64_SAVED_REGISTERS;
+	gen->depth = 0;
+	gen->retLabel = _X64Generator_newLabel(gen);
+
+	_X64Generator_emit(gen, "pushq %%rbp");
+	_X64Generator_emit(gen, "movq %%rsp, %%rbp");
+	for (int i = 0; i < gen->saved; ++i)
+		_X64Generator_emit(gen, "pushq %s", savedRegister64[i]);
+
+	//keep rsp 16-byte aligned in body
+	int slots = frameSize - gen->saved;
+	if ((gen->saved + slots) % 2)
+		slots++;
+	if (slots)
+		_X64Generator_emit(gen, "subq $%d, %%rsp", slots * 8);
+}
+
+void _X64Generator_epilogue(X64Generator* gen)
+{
+	Rope_appendFormat(gen->out, ".L%d:\n", gen->retLabel);
+	if (gen->saved)
+		_X64Generator_emit(gen, "leaq %d(%%rbp), %%rsp", -8 * gen->saved);
+	else
+		_X64Generator_emit(gen, "movq %%rbp, %%rsp");
+	for (int i = gen->saved - 1; i >= 0; --i)
+		_X64Generator_emit(gen, "popq %s", savedRegister64[i]);
+	_X64Generator_emit(gen, "popq %%rbp");
+	_X64Generator_emit(gen, "ret");
+}
+
+void _X64Generator_statement(X64Generator* gen, Statement* stat)
+{
+	switch (stat->type)
+	{
+	case STATEMENT_TYPE_DECLARATION:
+		if (stat->declaration.variant.initExpr)
+			_X64Generator_expression(gen, stat->declaration.variant.initExpr);
+		else
+			_X64Generator_emit(gen, "xorl %%eax, %%eax");
+		_X64Generator_emitSlot(gen, "movl %eax,", stat->declaration.variant.slot, "");
+		break;
+
+	case STATEMENT_TYPE_IF:
+		_X64Generator_ifStatement(gen, stat);
+		break;
+
+	case STATEMENT_TYPE_COMPOUND:
+		for (int i = 0; i < stat->compound.size; ++i)
+			_X64Generator_statement(gen, Vector_get(&stat->compound, i));
+		break;
+
+	case STATEMENT_TYPE_ASSIGN:
+	case STATEMENT_TYPE_ADD_ASSIGN:
+	case STATEMENT_TYPE_SUB_ASSIGN:
+	case STATEMENT_TYPE_MUL_ASSIGN:
+	case STATEMENT_TYPE_DIV_ASSIGN:
+	case STATEMENT_TYPE_MOD_ASSIGN:
+	case STATEMENT_TYPE_BITAND_ASSIGN:
+	case STATEMENT_TYPE_BITOR_ASSIGN:
+	case STATEMENT_TYPE_XOR_ASSIGN:
+	case STATEMENT_TYPE_LSHIFT_ASSIGN:
+	case STATEMENT_TYPE_RSHIFT_ASSIGN:
+		_X64Generator_assignStatement(gen, stat);
+		break;
+
+	case STATEMENT_TYPE_INC:
+	case STATEMENT_TYPE_DEC:
+		_X64Generator_incDecStatement(gen, stat);
+		break;
+
+	case STATEMENT_TYPE_EXPRESSION:
+		_X64Generator_expression(gen, stat->expr);
+		break;
+
+	case STATEMENT_TYPE_RETURN:
+		if (stat->returnExpr)
+			_X64Generator_expression(gen, stat->returnExpr);
+		_X64Generator_emit(gen, "jmp .L%d", gen->retLabel);
+		break;
+	}
+}
+
+void _X64Generator_ifStatement(X64Generator* gen, Statement* stat)
+{
+	int elseLabel = _X64Generator_newLabel(gen);
+	int endLabel = _X64Generator_newLabel(gen);
+
+	_X64Generator_expression(gen, stat->ifStat.condition);
+	_X64Generator_emit(gen, "testl %%eax, %%eax");
+	_X64Generator_emit(gen, "je .L%d", elseLabel);
+
+	_X64Generator_statement(gen, stat->ifStat.statement);
+
+	if (stat->ifStat.elseStat)
+	{
+		_X64Generator_emit(gen, "jmp .L%d", endLabel);
+		Rope_appendFormat(gen->out, ".L%d:\n", elseLabel);
+		_X64Generator_statement(gen, stat->ifStat.elseStat);
+		Rope_appendFormat(gen->out, ".L%d:\n", endLabel);
+	}
+	else
+	{
+		Rope_appendFormat(gen->out, ".L%d:\n", elseLabel);
+	}
+}
+
+void _X64Generator_assignStatement(X64Generator* gen, Statement* stat)
+{
+	ExprType op = EXPR_TYPE_INT;
+	switch (stat->type)
+	{
+	case STATEMENT_TYPE_ADD_ASSIGN:    op = EXPR_TYPE_ADD;    break;
+	case STATEMENT_TYPE_SUB_ASSIGN:    op = EXPR_TYPE_SUB;    break;
+	case STATEMENT_TYPE_MUL_ASSIGN:    op = EXPR_TYPE_MUL;    break;
+	case STATEMENT_TYPE_DIV_ASSIGN:    op = EXPR_TYPE_DIV;    break;
+	case STATEMENT_TYPE_MOD_ASSIGN:    op = EXPR_TYPE_MOD;    break;
+	case STATEMENT_TYPE_BITAND_ASSIGN: op = EXPR_TYPE_BITAND; break;
+	case STATEMENT_TYPE_BITOR_ASSIGN:  op = EXPR_TYPE_BITOR;  break;
+	case STATEMENT_TYPE_XOR_ASSIGN:    op = EXPR_TYPE_XOR;    break;
+	case STATEMENT_TYPE_LSHIFT_ASSIGN: op = EXPR_TYPE_LSHIFT; break;
+	case STATEMENT_TYPE_RSHIFT_ASSIGN: op = EXPR_TYPE_RSHIFT; break;
+	}
+
+	_X64Generator_expression(gen, stat->assign.rightExpr);
+	if (op != EXPR_TYPE_INT)
+	{
+		_X64Generator_emit(gen, "movl %%eax, %%ecx");
+		_X64Generator_emitOperand(gen, "movl", stat->assign.leftExpr, ", %eax");
+		_X64Generator_operate(gen, op, &stat->location);
+	}
+	_X64Generator_emitOperand(gen, "movl %eax,", stat->assign.leftExpr, "");
+}
+
+void _X64Generator_incDecStatement(X64Generator* gen, Statement* stat)
+{
+	_X64Generator_emitOperand(gen, stat->type == STATEMENT_TYPE_INC ? "incl" : "decl", stat->incExpr, "");
+}
+
+void _X64Generator_expression(X64Generator* gen, Expression* expr)
+{
+	switch (expr->type)
+	{
+	case EXPR_TYPE_INT:
+		if (expr->intExpr == 0)
+			_X64Generator_emit(gen, "xorl %%eax, %%eax");
+		else
+			_X64Generator_emit(gen, "movl $%d, %%eax", expr->intExpr);
+		break;
+
+	case EXPR_TYPE_BOOL:
+		_X64Generator_emit(gen, "movl $%d, %%eax", expr->boolExpr ? 1 : 0);
+		break;
+
+	case EXPR_TYPE_IDENT:
+		_X64Generator_emitOperand(gen, "movl", expr, ", %eax");
+		break;
+
+	case EXPR_TYPE_CALL:
+		_X64Generator_callExpression(gen, expr);
+		break;
+
+	case EXPR_TYPE_PLUS:
+	case EXPR_TYPE_MINUS:
+	case EXPR_TYPE_NOT:
+	case EXPR_TYPE_NEG:
+		_X64Generator_unaryExpression(gen, expr);
+		break;
+
+	case EXPR_TYPE_AND:
+	case EXPR_TYPE_OR:
+		_X64Generator_logicExpression(gen, expr);
+		break;
+
+	case EXPR_TYPE_COND:
+		_X64Generator_conditionExpression(gen, expr);
+		break;
+
+	default:
+		_X64Generator_binaryExpression(gen, expr);
+		break;
+	}
+}
+
+void _X64Generator_conditionExpression(X64Generator* gen, Expression* expr)
+{
+	int elseLabel = _X64Generator_newLabel(gen);
+	int endLabel = _X64Generator_newLabel(gen);
+
+	_X64Generator_expression(gen, expr->condExpr.expr1);
+	_X64Generator_emit(gen, "testl %%eax, %%eax");
+	_X64Generator_emit(gen, "je .L%d", elseLabel);
+	_X64Generator_expression(gen, expr->condExpr.expr2);
+	_X64Generator_emit(gen, "jmp .L%d", endLabel);
+	Rope_appendFormat(gen->out, ".L%d:\n", elseLabel);
+	_X64Generator_expression(gen, expr->condExpr.expr3);
+	Rope_appendFormat(gen->out, ".L%d:\n", endLabel);
+}
+
+void _X64Generator_logicExpression(X64Generator* gen, Expression* expr)
+{
+	//left value is the result when it short circuits
+	int endLabel = _X64Generator_newLabel(gen);
+
+	_X64Generator_expression(gen, expr->binaryExpr.leftExpr);
+	_X64Generator_emit(gen, "testl %%eax, %%eax");
+	_X64Generator_emit(gen, "%s .L%d", expr->type == EXPR_TYPE_AND ? "je" : "jne", endLabel);
+	_X64Generator_expression(gen, expr->binaryExpr.rightExpr);
+	Rope_appendFormat(gen->out, ".L%d:\n", endLabel);
+}
+
+void _X64Generator_callExpression(X64Generator* gen, Expression* expr)
+{
+	Vector* args = &expr->callExpr.args;
+	int count = args->size;
+	int stackArgs = count > X64_ARG_REGISTERS ? count - X64_ARG_REGISTERS : 0;
+
+	//evaluate left to right, each argument is pushed
+	for (int i = 0; i < count; ++i)
+	{
+		_X64Generator_expression(gen, Vector_get(args, i));
+		_X64Generator_emit(gen, "pushq %%rax");
+		gen->depth++;
+	}
+
+	//rsp must be 16-byte aligned at call
+	int pad = (gen->depth + stackArgs) % 2;
+	if (pad)
+		_X64Generator_emit(gen, "subq $8, %%rsp");
+
+	//argument i is at 8 * (count - 1 - i) + 8 * pad above rsp, copy stack arguments in reverse order
+	for (int i = count - 1, pushed = 0; i >= X64_ARG_REGISTERS; --i, ++pushed)
+		_X64Generator_emit(gen, "pushq %d(%%rsp)", 8 * (count - 1 - i) + 8 * pad + 8 * pushed);
+
+	for (int i = 0; i < count && i < X64_ARG_REGISTERS; ++i)
+		_X64Generator_emit(gen, "movl %d(%%rsp), %s", 8 * (count - 1 - i) + 8 * pad + 8 * stackArgs, argRegister32[i]);
+
+	Declaration* decl = expr->callExpr.decl;
+	Rope_appendFormat(gen->out, "\tcall " String_FMT "\n", String_arg(decl->function.name));
+
+	int release = count + pad + stackArgs;
+	if (release)
+		_X64Generator_emit(gen, "addq $%d, %%rsp", release * 8);
+	gen->depth -= count;
+}
+
+void _X64Generator_unaryExpression(X64Generator* gen, Expression* expr)
+{
+	_X64Generator_expression(gen, expr->unaryExpr);
+
+	switch (expr->type)
+	{
+	case EXPR_TYPE_MINUS:
+		_X64Generator_emit(gen, "negl %%eax");
+		break;
+
+	case EXPR_TYPE_NEG:
+		_X64Generator_emit(gen, "notl %%eax");
+		break;
+
+	case EXPR_TYPE_NOT:
+		_X64Generator_emit(gen, "xorl $1, %%eax");
+		break;
+	}
+}
+
+void _X64Generator_binaryExpression(X64Generator* gen, Expression* expr)
+{
+	_X64Generator_expression(gen, expr->binaryExpr.leftExpr);
+
+	//literal or variant right operand is loaded directly, others are evaluated with left saved on stack
+	if (_X64Generator_isOperand(gen, expr->binaryExpr.rightExpr))
+	{
+		_X64Generator_emitOperand(gen, "movl", expr->binaryExpr.rightExpr, ", %ecx");
+	}
+	else
+	{
+		_X64Generator_emit(gen, "pushq %%rax");
+		gen->depth++;
+		_X64Generator_expression(gen, expr->binaryExpr.rightExpr);
+		_X64Generator_emit(gen, "movl %%eax, %%ecx");
+		_X64Generator_emit(gen, "popq %%rax");
+		gen->depth--;
+	}
+
+	_X64Generator_operate(gen, expr->type, &expr->location);
+}
+
+void _X64Generator_operate(X64Generator* gen, ExprType type, SourceLocation* loc)
+{
+	//eax = eax op ecx
+	const char* set = NULL;
+
+	switch (type)
+	{
+	case EXPR_TYPE_ADD:    _X64Generator_emit(gen, "addl %%ecx, %%eax");  break;
+	case EXPR_TYPE_SUB:    _X64Generator_emit(gen, "subl %%ecx, %%eax");  break;
+	case EXPR_TYPE_MUL:    _X64Generator_emit(gen, "imull %%ecx, %%eax"); break;
+	case EXPR_TYPE_BITAND: _X64Generator_emit(gen, "andl %%ecx, %%eax");  break;
+	case EXPR_TYPE_BITOR:  _X64Generator_emit(gen, "orl %%ecx, %%eax");   break;
+	case EXPR_TYPE_XOR:    _X64Generator_emit(gen, "xorl %%ecx, %%eax");  break;
+	case EXPR_TYPE_LSHIFT: _X64Generator_emit(gen, "sall %%cl, %%eax");   break;
+	case EXPR_TYPE_RSHIFT: _X64Generator_emit(gen, "sarl %%cl, %%eax");   break;
+
+	case EXPR_TYPE_DIV:
+	case EXPR_TYPE_MOD:
+		_X64Generator_emit(gen, "cltd");
+		_X64Generator_emit(gen, "idivl %%ecx");
+		if (type == EXPR_TYPE_MOD)
+			_X64Generator_emit(gen, "movl %%edx, %%eax");
+		break;
+
+	case EXPR_TYPE_EQ: set = "sete";  break;
+	case EXPR_TYPE_NE: set = "setne"; break;
+	case EXPR_TYPE_LT: set = "setl";  break;
+	case EXPR_TYPE_LE: set = "setle"; break;
+	case EXPR_TYPE_GT: set = "setg";  break;
+	case EXPR_TYPE_GE: set = "setge"; break;
+
+	default:
+		error(loc, "x64 generator not support this operator");
+	}
+
+	if (set)
+	{
+		_X64Generator_emit(gen, "cmpl %%ecx, %%eax");
+		_X64Generator_emit(gen, "%s %%al", set);
+		_X64Generator_emit(gen, "movzbl %%al, %%eax");
+	}
+}
+
+bool _X64Generator_isOperand(X64Generator* gen, Expression* expr)
+{
+	return expr->type == EXPR_TYPE_INT || expr->type == EXPR_TYPE_BOOL || expr->type == EXPR_TYPE_IDENT;
+}
+
+void _X64Generator_emitOperand(X64Generator* gen, const char* op, Expression* expr, const char* rest)
+{
+	switch (expr->type)
+	{
+	case EXPR_TYPE_INT:
+		Rope_appendFormat(gen->out, "\t%s $%d%s\n", op, expr->intExpr, rest);
+		break;
+
+	case EXPR_TYPE_BOOL:
+		Rope_appendFormat(gen->out, "\t%s $%d%s\n", op, expr->boolExpr ? 1 : 0, rest);
+		break;
+
+	case EXPR_TYPE_IDENT:
+		if (expr->identExpr.global)
+			Rope_appendFormat(gen->out, "\t%s " String_FMT "(%%rip)%s\n", op, String_arg(expr->identExpr.name), rest);
+		else
+			_X64Generator_emitSlot(gen, op, expr->identExpr.slot, rest);
+		break;
+	}
+}
+
+void _X64Generator_emitSlot(X64Generator* gen, const char* op, int slot, const char* rest)
+{
+	//saved registers are pushed right below rbp, stack slots follow them
+	if (slot < gen->saved)
+		Rope_appendFormat(gen->out, "\t%s %s%s\n", op, savedRegister32[slot], rest);
+	else
+		Rope_appendFormat(gen->out, "\t%s %d(%%rbp)%s\n", op, -8 * (slot + 1), rest);
+}
+
+void _X64Generator_emit(X64Generator* gen, const char* fmt, ...)
+{
+	char tmp[256];
+	va_list vp;
+	va_start(vp, fmt);
+	vsnprintf(tmp, sizeof(tmp), fmt, vp);
+	va_end(vp);
+
+	Rope_append(gen->out, "\t");
+	Rope_append(gen->out, tmp);
+	Rope_append(gen->out, "\n");
+}
+
+int _X64Generator_newLabel(X64Generator* gen)
+{
+	return gen->label++;
+}
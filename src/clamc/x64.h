@@ -0,0 +1,26 @@
+#ifndef CLAM_X64_H
+#define CLAM_X64_H
+
+#include "module.h"
+#include "rope.h"
+
+//x86-64 GNU assembly backend for analyzed module, System V calling convention
+//first local slots live in callee saved registers, the rest in stack frame
+struct X64Generator
+{
+	Module* module;
+	Rope* out;
+	FuncDecl* func;    //current function, NULL in global init
+	int saved;         //callee saved registers used by current function
+	int depth;         //outstanding 8-byte pushes of expression evaluation
+	int label;         //next local label
+	int retLabel;      //epilogue label of current function
+};
+typedef struct X64Generator X64Generator;
+
+void X64Generator_init(X64Generator* gen);
+void X64Generator_destroy(X64Generator* gen);
+
+void X64Generator_generate(X64Generator* gen, Module* module, Rope* out);
+
+#endif